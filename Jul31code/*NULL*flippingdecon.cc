@@ -39,6 +39,12 @@
 //"larsoft" object includes
 #include "lardataobj/RecoBase/Wire.h"
 
+#include "SNOptions.h"
+#include "ROIView.h"
+#include "ROIBaseline.hh"
+#include "WaveformSnapshots.hh"
+#include "FlippedBits.hh"
+
 
 
 //convenient for us! let's not bother with art and std namespaces!
@@ -53,7 +59,7 @@ int main(int argc, char** argv) {
   
   //We specify our files in a list of file names!
   //Note: multiple files allowed. Just separate by comma.
-  vector<string> filenames { argv[1] };
+  vector<string> filenames = sn::ParseOptions(argc, argv).filenames;   // lists, globs and @list.txt too
 
   
   //Check the contents of your file by setting up a version of uboonecode, and
@@ -90,8 +96,12 @@ int main(int argc, char** argv) {
 
 
 
-  size_t  fZSPresamples = 7;
-  size_t  fZSPostsamples = 8;
+  // the single waveforms to draw at the end, instead of a canvas and a png per ROI
+  sn::SnapshotStore snapRaw(100), snapNot(100), snapFlipped(100);
+
+  // reused from wire to wire
+  std::vector<sn::ROIView> rois;
+  std::vector<sn::ROIBaseline> baselines;
 
   for (gallery::Event ev(filenames) ; !ev.atEnd(); ev.next()) {
     if(evCtr >= _maxEvts) break;
@@ -121,102 +131,40 @@ int main(int argc, char** argv) {
 
 
     for (unsigned int i=0; i<wire_vec.size();i++){
-      auto zsROIs = wire_vec[i].SignalROI();
       int channel = wire_vec[i].Channel();
      
       //Int nROI = wire_vec[i].SignalROI().n_ranges(); // how many ROIs in a channel
  
-      for (auto iROI = zsROIs.begin_range(); iROI != zsROIs.end_range(); ++iROI) {
-        auto ROI = *iROI;
+      // baselines of all the ROIs of this wire in one batch
+      sn::WireROIs wireROIs(wire_vec[i]);
+      rois.assign(wireROIs.begin(), wireROIs.end());
+      baselines.resize(rois.size());
+      sn::EstimateBaselines(rois.data(), rois.size(), baselines.data());
+
+      for (size_t iROI = 0; iROI < rois.size(); iROI++) {
+        sn::ROIView const& ROI = rois[iROI];
         const size_t firstTick = ROI.begin_index();
 	const size_t endTick = ROI.end_index();
 		
 	//********************************************** begin baseline algorithm***********************************                                            
-	// Find the median of presamples/postsamples                                                                                                            
-	std::vector<float> presamples; presamples.reserve(fZSPresamples);
-	std::vector<float> postsamples; postsamples.reserve(fZSPostsamples);
-	for(size_t isample = 0; isample < fZSPresamples; isample++){
-	  if(ROI[ROI.begin_index() + isample] > 1){ // Get rid of 1e-44 and similar swizzler errors(?)                                                          
-	    presamples.push_back(ROI[ROI.begin_index() + isample]);
-	    //            std::cout << "Presample " << isample << " = " << presamples.back() << std::endl;                                                      
-	  }
-	}
-	for(size_t isample = 0; isample < fZSPostsamples; isample++){
-	  if(ROI[ROI.end_index() - fZSPostsamples + 1 + isample] > 1){
-	    postsamples.push_back(ROI[ROI.end_index() - fZSPostsamples + 1 + isample]);
-	    //            std::cout << "Postsample " << isample << " = " << postsamples.back() << std::endl;                                                    
-	  }
-	}
-
-	std::sort(presamples.begin(), presamples.end());
-	std::sort(postsamples.begin(), postsamples.end());
-
-	const size_t goodPresamples = presamples.size();
-	const size_t goodPostsamples = postsamples.size();
-
-	const float medianPresample = ((goodPresamples % 2) == 0)?
-	  (presamples[goodPresamples/2 - 1] + presamples[goodPresamples/2])/2. : presamples[goodPresamples/2];
-	//            std::cout << "Median presample " << medianPresample << std::endl;                                                                         
-	const float medianPostsample = ((goodPostsamples % 2) == 0)?
-	  (postsamples[goodPostsamples/2 - 1] + postsamples[goodPostsamples/2])/2. : postsamples[goodPostsamples/2];
-	//            std::cout << "Median postsample " << medianPostsample << std::endl;                                                                       
-	// Get the earliest presample and last postsample which are close to the medians                                                                       
-	float prebaseline = -4095; // baseline estimated from presamples                                                                                     
-	float postbaseline = -4095; // baseline estimated from postsamples                                                                                   
-	size_t pretick = -1; // tick with baseline estimated from presamples                                                                                
-
-	size_t postick = -1; // tick with baseline estimated from postsamples                                                                                
-	const float medianCut = 15; // Maximum absolute difference between a sample and the median to be considered as baseline // Add to FHiCL file?      
-	  for(size_t isample = 0; isample < fZSPresamples; isample++){
-	    //if(fOutputHistograms) if(ROI[ROI.begin_index() + isample] > 1)                                                                                      
-	    //                      fDiffPresamplesMedianHist->Fill(channel, ROI[ROI.begin_index() + isample]- medianPresample);          
-	    if(fabs(ROI[ROI.begin_index() + isample]- medianPresample) < medianCut){
-	      pretick = ROI.begin_index() + isample;
-	      prebaseline = ROI[pretick];
-	      //    std::cout << "Prebaseline at tick " << isample << " = " << prebaseline << std::endl;                                                    
-	      break;
-	    }
-	  }
-	  for(size_t isample = 0; isample < fZSPostsamples; isample++){
-	    //if(fOutputHistograms) if(ROI[ROI.begin_index() + isample] > 1)                                                                                      
-	    //                      fDiffPostsamplesMedianHist->Fill(channel, ROI[ROI.begin_index() + isample]- medianPostsample);                                
-	    if(fabs(ROI[ROI.end_index() -  isample] - medianPostsample) < medianCut){
-	      postick = ROI.end_index() - isample;
-	      postbaseline = ROI[postick];
-	      //            std::cout << "Postbaseline at tick -" << isample << " = " << postbaseline << std::endl;                                         
-	      break;
-	    }
-	  }
-
-	  // Linear interpolation for baseline                                                                                                                    
-	  const float slope = (postbaseline - prebaseline)/(postick - pretick);
-	  //const float intercept = (postick*prebaseline - postbaseline*pretick)/(postick - pretick);                                                             
-	  const float intercept = prebaseline - slope*pretick;
+	// (see ROIBaseline.hh; estimated for all the ROIs of the wire at once, above)
+	const float slope = baselines[iROI].slope;
+	const float intercept = baselines[iROI].intercept;
 
 	  //*******************************************end baseline algorightm*************************************************      
 	
-	  TH1D horig1("roi_original1", "roi_original;Tick;ADC", endTick - firstTick, firstTick, endTick);
-          for (size_t iTick = ROI.begin_index(); iTick < ROI.end_index(); iTick++ ){
-            horig1.Fill((int)iTick,ROI[iTick]);}
-          TCanvas c2(Form("c1_%d_%d_na",event,channel),"c1",900,600);
-          //cout<<"channel: "<<channel<<' '<< abs(ROI[endTick]-(slope*(endTick)+intercept))<<"\n";                                                          
-          horig1.Draw("hist ]");
-          c2.Print(".png");
-
-
-	// define vector of 0s and 1s that will say whether there is a flipped bit or not 
-	vector<int> flippedROI;
-
-	// Difference to interpolation
-	double difftoint;
-	for (size_t iTick = 1+ROI.begin_index(); iTick < ROI.end_index()-1; iTick++ ){   ///loop through values in the ROI excluding the second to last tick as well
-	  difftoint = ROI[iTick] - (( ROI[iTick+1] + ROI[iTick-1] )/2);
-	  
-	  if(difftoint > 32){              // our metric of flipped bit is a difference of more than 32
-	    flippedROI.push_back(1);}    // add a 1 if there is a flipped bit
-	  else
-	    {flippedROI.push_back(0);}    // add a 0 if there isnt a flipped bit
+	// the raw waveform, kept for drawing at the end (see WaveformSnapshots.hh)
+	if(sn::WaveformSnapshot* snap = snapRaw.Offer()){
+	  snap->name = Form("c1_%d_%d_na",event,channel);
+	  snap->title = "roi_original;Tick;ADC";
+	  snap->firstTick = snap->sampleTick = firstTick;
+	  snap->nTicks = endTick - firstTick;
+	  snap->samples.assign(ROI.begin(), ROI.end());
 	}
+
+
+	// is there a flipped bit anywhere in the ROI? (second difference against the neighbours, see FlippedBits.hh)
+	const bool flippedROI = sn::HasFlippedBit(ROI.begin(), ROI.size());
       
 	//cout<<flippedROI.size();
 	//for(int i:flippedROI){
@@ -227,38 +175,35 @@ int main(int argc, char** argv) {
         roilength = endTick-firstTick;
         hRoiLen.Fill(channel,roilength);
 
-	// check if every value in flippedROI is 0 which would mean there is no flipped bit
-	if( std::all_of(flippedROI.begin(), flippedROI.end(), [](int x){return x==0;})){   
-	  double integral;                                                                                                                                  
-	  TH1D horig("roi_original", "roi_original;Tick;ADC", endTick - firstTick, firstTick, endTick); // new hist of the waveform
-	  for (size_t iTick = ROI.begin_index(); iTick < ROI.end_index(); iTick++ ){    //not including last sample                   
-	    double absvalue;
-	    absvalue = abs(ROI[iTick]-(slope*(iTick)+intercept));  // subtract the algorithm baseline and then take the absolue value
-	    horig.Fill((int)iTick,absvalue);}                    // fill that hist with the waveform              
-	  TCanvas c1(Form("c1_%d_%d",event,channel),"c1",900,600);
-          horig.Draw("hist ]");
-          c1.Print(".png");
-	  integral = horig.Integral();                                            // take the integral of that waveform              
+	// the baseline subtracted waveform, if it is kept for drawing at the end
+	sn::SnapshotStore& store = flippedROI ? snapFlipped : snapNot;
+	sn::WaveformSnapshot* snap = store.Offer();
+	if(snap){
+	  snap->name = flippedROI ? Form("c1_%d_%d_f",event,channel) : Form("c1_%d_%d",event,channel);
+	  snap->title = "roi_original;Tick;ADC";
+	  snap->firstTick = snap->sampleTick = firstTick;
+	  snap->nTicks = endTick - firstTick;
+	}
+
+	// integral of the baseline subtracted waveform, the sum of what used to go into one TH1D bin per tick
+	double integral = 0;
+	for (size_t iTick = ROI.begin_index(); iTick < ROI.end_index(); iTick++ ){    //not including last sample
+	  double absvalue;
+	  absvalue = abs(ROI[iTick]-(slope*(iTick)+intercept));  // subtract the algorithm baseline and then take the absolue value
+	  if(snap) snap->samples.push_back(absvalue);
+	  integral += absvalue;}
+
+	// no flipped bit in the ROI
+	if( !flippedROI ){
 	  hIntNot.Fill(channel,integral); // fill the histogram of no flipped bits integrals
 	}
 
 	else {  // if there is at least one 1 there is a flipped bit
-	  double integral;
-          TH1D horig("roi_original", "roi_original;Tick;ADC", endTick - firstTick, firstTick, endTick);
-	  for (size_t iTick = ROI.begin_index(); iTick < ROI.end_index(); iTick++ ){
-	    double absvalue;
-	    absvalue = abs(ROI[iTick]-(slope*(iTick)+intercept));
-	    horig.Fill((int)iTick,absvalue);}
-	  TCanvas c1(Form("c1_%d_%d_f",event,channel),"c1",900,600);
-	  //cout<<"channel: "<<channel<<' '<< abs(ROI[endTick]-(slope*(endTick)+intercept))<<"\n";
-	  horig.Draw("hist ]");
-	  c1.Print(".png");
-	  integral = horig.Integral();                                                                                                               
           hIntFlipped.Fill(channel,integral);   // fill the histogram of at least one flipped bit integrals
 
 	  numflipped[channel]+= 1;   // if there is a flipped bit add 1 to the number of occurances for the channel
 	
-	  hIntLen.Fill(roilength,integral);  
+	  hIntLen.Fill(roilength,integral);
 
 	}
 	
@@ -275,6 +220,11 @@ int main(int argc, char** argv) {
   }
   //end loop over events!
   f_output.cd();
+
+  std::vector<sn::WaveformSnapshot> snapshots;
+  for(sn::SnapshotStore const* store : {&snapRaw, &snapNot, &snapFlipped})
+    snapshots.insert(snapshots.end(), store->Kept().begin(), store->Kept().end());
+  sn::RenderSnapshots(snapshots, ".");
   
   
   //diff to interpolation
@@ -0,0 +1,767 @@
+//***************************
+//    analysis baseline estimations in each plane
+//    Clara Berger 6/20/18
+//***************************
+
+#include "BaselineAna.hh"
+#include "ROIView.h"
+#include "ROIBaseline.hh"
+#include "ChannelPool.hh"
+#include "SNMetrics.hh"
+#include "SNMemory.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+//some ROOT includes
+#include "TCanvas.h"
+#include "TPad.h"
+#include "TMath.h"
+#include "TLine.h"
+#include "TF1.h"
+#include "TStyle.h"
+#include "TPaveStats.h"
+
+using namespace std;
+
+void sn::BaselineAna::ProcessEvent(SNEvent const& evt)
+{
+  auto const& wire_vec(*evt.wires);
+
+  // the wires don't depend on each other, so they may go in chunks over the channel threads
+  ForEachWireChunk(evt, [&](size_t firstWire, size_t lastWire, FillBuffer& fills){
+      ProcessWires(wire_vec, firstWire, lastWire, fills);
+    });
+}
+
+void sn::BaselineAna::ProcessWires(std::vector<recob::Wire> const& wire_vec, size_t firstWire, size_t lastWire, FillBuffer& fills)
+{
+ // reused from wire to wire
+ std::vector<sn::ROIView> rois;
+ std::vector<sn::ROIBaseline> baselines;
+
+ for (size_t i=firstWire; i<lastWire;i++){
+   int channel = wire_vec[i].Channel();
+
+   //const float maxADCInterpolDiff = 32; // Maximum ADC difference to the interpolation using nearest neigbors to be considered non-flipped bits.
+   //size_t ctrROI = 0;
+
+   // baselines of all the ROIs of this wire in one batch
+   sn::WireROIs wireROIs(wire_vec[i]);
+   rois.assign(wireROIs.begin(), wireROIs.end());
+   baselines.resize(rois.size());
+   {
+     ScopedTimer timer(kBaseline);
+     sn::EstimateBaselines(rois.data(), rois.size(), baselines.data());
+   }
+
+   for (size_t iROI = 0; iROI < rois.size(); iROI++) {
+     sn::ROIView const& ROI = rois[iROI];   // no copies of the sparse_vector or its ranges
+     const size_t firstTick = ROI.begin_index();
+     const size_t lastTick = ROI.end_index() - 1;   // the ROI's last sample, end_index() is one past it
+
+     //********************************************** begin baseline algorithm***********************************
+     // (see ROIBaseline.hh; estimated for all the ROIs of the wire at once, above)
+     const float slope = baselines[iROI].slope;
+     const float intercept = baselines[iROI].intercept;
+
+     //******************************************* end baseline algorightm*************************************************
+
+     // first sample passing the threshold
+     double firstpre;
+     firstpre = ROI[firstTick+7]-ROI[firstTick]; // 8th sample - 1st sample
+     fills.Fill(fFirstPreQ,channel,firstpre);
+     if(fFullHists) fills.Fill(hFirstPre,channel,firstpre);
+     if(channel <= 2400){
+       fills.Fill(hFirstPreU,firstpre);}
+     else if(channel >2400 && channel <=4800){
+       fills.Fill(hFirstPreV,firstpre);
+       if (firstpre>=0){fills.Add(counterpos,1);}   //positive peaks in the V plane
+       if (firstpre<0){fills.Add(counterneg,1);}}
+     else
+       {fills.Fill(hFirstPreY,firstpre);}
+
+     double firstpost;
+     if(ROI[lastTick]>1){
+       firstpost = ROI[firstTick+7]-ROI[lastTick];}
+     else
+       {firstpost = ROI[firstTick+7]-ROI[lastTick-1];}  //if the last sample seems to be 0 or very small use the second to last sample
+     fills.Fill(fFirstPostQ,channel,firstpost);
+     if(fFullHists) fills.Fill(hFirstPost,channel,firstpost);
+     if(channel <= 2400){
+       fills.Fill(hFirstPostU,firstpost);}
+     else if(channel >2400 && channel <=4800){
+       fills.Fill(hFirstPostV,firstpost);
+       if(firstpost<0){fills.Fill(hFirstNegV,channel);}  // look at channels with negative V plane triggers
+	 //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<' '<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick]<<"="<<firstpost<<"\n";}
+     }
+     else
+       {fills.Fill(hFirstPostY,firstpost);
+	 //if(firstpost<1 && firstpost>=0){
+	   //  cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<' '<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick]<<"="<<firstpost<<"\n";}
+       }
+     double firstalgo;
+     firstalgo = ROI[firstTick+7]-(slope*(firstTick+7)+intercept); // use slope and intercept to solve for baseline under the 8th sample
+     fills.Fill(fFirstAlgoQ,channel,firstalgo);
+     if(fFullHists) fills.Fill(hFirstAlgo,channel,firstalgo);
+     if(channel <= 2400){
+       fills.Fill(hFirstAlgoU,firstalgo);}
+     else if(channel >2400 && channel <=4800){
+       fills.Fill(hFirstAlgoV,firstalgo);}
+     else
+       {fills.Fill(hFirstAlgoY,firstalgo);}
+
+
+     // last sample passing the threshold
+     double lastpre;
+     lastpre = ROI[lastTick-8]-ROI[firstTick];
+     fills.Fill(fLastPreQ,channel,lastpre);
+     if(fFullHists) fills.Fill(hLastPre,channel,lastpre);
+     if(channel <= 2400){
+       fills.Fill(hLastPreU,lastpre);}
+     else if(channel >2400 && channel <=4800){
+       fills.Fill(hLastPreV,lastpre);}
+     else
+       {fills.Fill(hLastPreY,lastpre);}
+
+     double lastpost;
+     if(ROI[lastTick]>0){
+       lastpost = ROI[lastTick-8]-ROI[lastTick];}
+     else
+       {lastpost = ROI[lastTick-8]-ROI[lastTick-1];}
+     fills.Fill(fLastPostQ,channel,lastpost);
+     if(fFullHists) fills.Fill(hLastPost,channel,lastpost);
+     if(channel <= 2400){
+       fills.Fill(hLastPostU,lastpost);}
+     else if(channel >2400 && channel <=4800){
+       fills.Fill(hLastPostV,lastpost);}
+     else
+       {fills.Fill(hLastPostY,lastpost);}
+
+     double lastalgo;
+     lastalgo = ROI[lastTick-8]-(slope*(lastTick-8)+intercept);
+     fills.Fill(fLastAlgoQ,channel,lastalgo);
+     if(fFullHists) fills.Fill(hLastAlgo,channel,lastalgo);
+     if(channel <= 2400){
+       fills.Fill(hLastAlgoU,lastalgo);}
+     else if(channel >2400 && channel <=4800){
+       fills.Fill(hLastAlgoV,lastalgo);}
+     else
+       {fills.Fill(hLastAlgoY,lastalgo);}
+
+   }
+ }
+}
+
+void sn::BaselineAna::Finish()
+{
+  // what the 2D pads show, until their canvas is written (see Draw2D)
+  Drawn drawn;
+
+  // first sample passing the threshold
+  TCanvas c1("c_U","c1",1100,400); // u plane canvas
+  c1.Divide(3,1);
+  TCanvas c2("c_V","c2",1100,400);
+  c2.Divide(3,1);
+  TCanvas c3("c_Y","c3",1100,400);
+  c3.Divide(3,1);
+  TCanvas c4("c_first","c4",600,900); // not divided into planes
+  c4.Divide(1,3);
+
+
+  // last sample passing the threshold
+  TCanvas c5("c_Ul","c1",1200,400);
+  c5.Divide(3,1);
+  TCanvas c6("c_Vl","c2",1200,400);
+  c6.Divide(3,1);
+  TCanvas c7("c_Yl","c3",1200,400);
+  c7.Divide(3,1);
+  TCanvas c8("c_last","c4",600,900);
+  c8.Divide(1,3);
+
+  //channels in V that have negative first samples passing the threshold
+  TCanvas c10("c_neg","c10",900,600);
+
+  // fit two gaussians to the V planes -- define their functions
+  TF1 *g1 = new TF1("gfpre1","gaus",-34,-22);
+  TF1 *g2 = new TF1("gfpre2","gaus",8,25);
+  TF1 *g3 = new TF1("gfpost1","gaus",-28,-5);
+  TF1 *g4 = new TF1("gfpost2","gaus",8,30);
+  TF1 *g5 = new TF1("gfalg1","gaus",-40,-10);
+  TF1 *g6 = new TF1("gfalg2","gaus",10,25);
+
+  TF1 *g7 = new TF1("glpre1","gaus",-20,-6);
+  TF1 *g8 = new TF1("glpre2","gaus",6,20);
+  TF1 *g9 = new TF1("glpost1","gaus",-25,0);
+  TF1 *g10 = new TF1("glpost2","gaus",10,35);
+  TF1 *g11 = new TF1("glalg1","gaus",-25,-5);
+  TF1 *g12 = new TF1("glalg2","gaus",8,30);
+
+  //first passing threshold********************************************************************************
+  //U plane
+  c1.cd(1);
+  hFirstPreU.GetYaxis()->SetTitleOffset(2);  // slightly move axis label
+  hFirstPreU.Fit("gaus","","",-43,-20);  // fit gaussian on the range -43, -20
+  gStyle->SetOptFit(1);
+  hFirstPreU.SetLineColor(kBlack);
+  TLine line(-25,0,-25,18000);     // draw vertical line at the threshold in U plane
+  line.SetLineColor(kRed);
+  line.Draw();
+  c1.cd(2);
+  hFirstPostU.Fit("gaus","","",-35,-11);
+  hFirstPostU.GetYaxis()->SetTitleOffset(2);
+  gStyle->SetOptFit(1);
+  hFirstPostU.SetLineColor(kBlack);
+  TLine lineI(-25,0,-25,21000);
+  lineI.SetLineColor(kRed);
+  lineI.Draw();
+  c1.cd(3);
+  hFirstAlgoU.Fit("gaus","","",-39,-19);
+  gStyle->SetOptFit(1);
+  hFirstAlgoU.GetYaxis()->SetTitleOffset(2);
+  hFirstAlgoU.SetLineColor(kBlack);
+  TLine lineII(-25,0,-25,22000);
+  lineII.SetLineColor(kRed);
+  lineII.Draw();
+  c1.cd();
+  c1.Write();
+  c1.Print(".png");
+
+  //V plane
+  // first sample - presample
+  TH1F *hFirstPreV2 = (TH1F*)hFirstPreV.Clone();  // make a copy of the histogram to use for two separate peaks to get two statistics boxes
+  hFirstPreV2->SetNameTitle("Positive Peak","hey");
+  hFirstPreV.SetNameTitle("Negative Peak","First sample passing V threshold - first presample ADC");
+
+  c2.cd(1);
+  // gStyle->SetOptStat(11); // regular stats box only has the name and number of entries -- only turn on for fit because it will affect the other plots
+  hFirstPreV.Draw("");
+  gStyle->SetOptFit(1);   // statistics box with the info from the fit without errors
+  g1->SetLineColor(kBlue); // make the fit blue to distinguish it
+  hFirstPreV.Fit(g1,"R"); // negative peak
+  hFirstPreV.GetYaxis()->SetTitleOffset(2);
+  c2.Update();
+  TPaveStats *st = (TPaveStats*)hFirstPreV.FindObject( "stats" ); // get that stats box
+  if (st){                      // move the statistics box so that you can see both boxes at the same time
+    st->SetX1NDC(0.68);
+    st->SetX2NDC(1.0);
+    st->SetY1NDC(0.6);
+    st->SetY2NDC(0.9);
+  }
+
+  hFirstPreV2->Draw("sames");  // positive peak
+  gStyle->SetOptFit(1);
+  g2->SetLineColor(kGreen);
+  hFirstPreV2->Fit(g2,"R");
+  c2.Update();
+  TPaveStats *st2 = (TPaveStats*)hFirstPreV2->FindObject( "stats" );
+  if (st2){
+    st2->SetX1NDC(0.68);
+    st2->SetX2NDC(1.0);
+    st2->SetY1NDC(0.3);
+    st2->SetY2NDC(0.6);
+  }
+  hFirstPreV2->SetLineColor(kBlack);
+  TLine line2(-15,0,-15,27000);  // draw lines showing the thresholds
+  line2.SetLineColor(kRed);
+  line2.Draw();
+  TLine line3(15,0,15,27000);
+  line3.SetLineColor(kRed);
+  line3.Draw();
+  // first sample - postsample
+  c2.cd(2);
+  TH1F *hFirstPostV2 = (TH1F*)hFirstPostV.Clone();  // make a copy of the histogram to use for two separate peaks to get two statistics boxes
+  hFirstPostV2->SetNameTitle("Positive Peak","hey");
+  hFirstPostV.SetNameTitle("Negative Peak","First sample passing V threshold - last postsample ADC");
+
+  // gStyle->SetOptStat(11); // regular stats box only has the name and number of entries
+  hFirstPostV.Draw();
+  gStyle->SetOptFit(1);   // statistics box with the info from the fit without errors
+  g3->SetLineColor(kBlue);
+  hFirstPostV.Fit(g3,"R");
+  hFirstPostV.GetYaxis()->SetTitleOffset(2);
+  g3->SetLineColor(kBlue);
+  gStyle->SetOptFit(1);
+  c2.Update();
+  TPaveStats *st3 = (TPaveStats*)hFirstPostV.FindObject( "stats" ); // get that stats box
+  c2.Modified();
+  if (st3){
+    st3->SetX1NDC(0.68);
+    st3->SetX2NDC(1.0);
+    st3->SetY1NDC(0.6);
+    st3->SetY2NDC(0.9);
+  }
+
+  hFirstPostV2->Draw("sames");
+  gStyle->SetOptFit(1);
+  g4->SetLineColor(kGreen);
+  hFirstPostV2->Fit(g4,"R");
+  c2.Update();
+  TPaveStats *st4 = (TPaveStats*)hFirstPostV2->FindObject( "stats" );
+  if (st4){
+    st4->SetX1NDC(0.68);
+    st4->SetX2NDC(1.0);
+    st4->SetY1NDC(0.3);
+    st4->SetY2NDC(0.6);
+  }
+  hFirstPostV2->SetLineColor(kBlack);
+  TLine line2I(-15,0,-15,20000);
+  line2I.SetLineColor(kRed);
+  line2I.Draw();
+  TLine line3I(15,0,15,20000);
+  line3I.SetLineColor(kRed);
+  line3I.Draw();
+
+  //first sample-algorithm baseline
+  c2.cd(3);
+  TH1F *hFirstAlgoV2 = (TH1F*)hFirstAlgoV.Clone();  // make a copy of the histogram to use for two separate peaks to get twostatistics boxes
+  hFirstAlgoV2->SetNameTitle("Positive Peak","hey");
+  hFirstAlgoV.SetNameTitle("Negative Peak","First sample passing V threshold - algorithm baseline ADC");
+  //gStyle->SetOptStat(11); // regular stats box only has the name and number of entries
+  hFirstAlgoV.Draw();
+  gStyle->SetOptFit(1);   // statistics box with the info from the fit without errors
+  g5->SetLineColor(kBlue);
+  hFirstAlgoV.Fit(g5,"R");
+  hFirstAlgoV.GetYaxis()->SetTitleOffset(2);
+  g5->SetLineColor(kBlue);
+  gStyle->SetOptFit(1);
+  c2.Update();
+  TPaveStats *st5 = (TPaveStats*)hFirstAlgoV.FindObject( "stats" ); // get that stats box
+  if (st5){
+   st5->SetX1NDC(0.68);
+   st5->SetX2NDC(1.0);
+   st5->SetY1NDC(0.6);
+   st5->SetY2NDC(0.9);
+  }
+  hFirstAlgoV2->Draw("sames");
+  gStyle->SetOptFit(1);
+  g6->SetLineColor(kGreen);
+  hFirstAlgoV2->Fit(g6,"R");
+  hFirstAlgoV2->GetYaxis()->SetTitleOffset(2);
+  c2.Update();
+  TPaveStats *st6 = (TPaveStats*)hFirstAlgoV2->FindObject( "stats" );
+  if (st6){
+    st6->SetX1NDC(0.68);
+    st6->SetX2NDC(1.0);
+    st6->SetY1NDC(0.3);
+    st6->SetY2NDC(0.6);
+  }
+  hFirstAlgoV2->SetLineColor(kBlack);
+  TLine line2II(-15,0,-15,30000);
+  line2II.SetLineColor(kRed);
+  line2II.Draw();
+  TLine line3II(15,0,15,30000);
+  line3II.SetLineColor(kRed);
+  line3II.Draw();
+  c2.cd();
+  c2.Write();
+  c2.Print(".png");
+
+  //Y plane
+  c3.cd(1);
+  hFirstPreY.Fit("gaus","","",22,38);
+  gStyle->SetOptFit(1);
+  hFirstPreY.SetLineColor(kBlack);
+  hFirstPreY.GetXaxis()->SetRangeUser(-15,15);
+  hFirstPreY.GetYaxis()->SetTitleOffset(2);
+  TLine line4(30,0,30,21000);
+  line4.SetLineColor(kRed);
+  line4.Draw();
+  c3.cd(2);
+  hFirstPostY.Fit("gaus","","",22,46);
+  gStyle->SetOptFit(1);
+  hFirstPostY.SetLineColor(kBlack);
+  hFirstPostY.GetXaxis()->SetRangeUser(-15,15);
+  hFirstPostY.GetYaxis()->SetTitleOffset(2);
+  TLine line4I(30,0,30,14000);
+  line4I.SetLineColor(kRed);
+  line4I.Draw();
+  c3.cd(3);
+  hFirstAlgoY.Fit("gaus","","",22,39);
+  gStyle->SetOptFit(1);
+  hFirstAlgoY.SetLineColor(kBlack);
+  hFirstAlgoY.GetXaxis()->SetRangeUser(-15,15);
+  hFirstAlgoY.GetYaxis()->SetTitleOffset(2);
+  line4.Draw();
+  c3.cd();
+  c3.Write();
+  c3.Print(".png");
+
+  //2D
+  c4.cd(1);
+  Draw2D(hFirstPre, fFirstPreQ, drawn);
+  TLine line5(0,-25,2400,-25);
+  line5.SetLineColor(kRed);
+  line5.Draw();
+  TLine line6(2400,15,4800,15);
+  line6.SetLineColor(kRed);
+  line6.Draw();
+  TLine line7(2400,-15,4800,-15);
+  line7.SetLineColor(kRed);
+  line7.Draw();
+  TLine line8(4800,30,8256,30);
+  line8.SetLineColor(kRed);
+  line8.Draw();
+  c4.cd(2);
+  Draw2D(hFirstPost, fFirstPostQ, drawn);
+  line5.Draw();
+  line6.Draw();
+  line7.Draw();
+  line8.Draw();
+  c4.cd(3);
+  Draw2D(hFirstAlgo, fFirstAlgoQ, drawn);
+  line5.Draw();
+  line6.Draw();
+  line7.Draw();
+  line8.Draw();
+  c4.cd();
+  c4.Write();
+  c4.Print(".png");
+  for(auto& h : drawn.hists) if(h->GetDimension() == 2) h->Write();
+  drawn.hists.clear();
+  drawn.dense.clear();
+
+  //last sample passing threshold ***************************************************************************************
+  //U plane
+  c5.cd(1);
+  hLastPreU.Fit("gaus","","",-37,-17);
+  gStyle->SetOptFit(1);
+  hLastPreU.SetLineColor(kBlack);
+  hLastPreU.GetYaxis()->SetTitleOffset(2);
+  TLine line16(-25,0,-25,21000);
+  line16.SetLineColor(kRed);
+  line16.Draw();
+  c5.cd(2);
+  hLastPostU.Fit("gaus","","",-27,-7);
+  gStyle->SetOptFit(1);
+  hLastPostU.SetLineColor(kBlack);
+  hLastPostU.GetYaxis()->SetTitleOffset(2);
+  TLine line6I(-25,0,-25,16000);
+  line6I.SetLineColor(kRed);
+  line6I.Draw();
+  c5.cd(3);
+  hLastAlgoU.Fit("gaus","","",-27,-15);
+  gStyle->SetOptFit(1);
+  hLastAlgoU.SetLineColor(kBlack);
+  hLastAlgoU.GetYaxis()->SetTitleOffset(2);
+  TLine line6II(-25,0,-25,35000);
+  line6II.SetLineColor(kRed);
+  line6II.Draw();
+  c5.cd();
+  c5.Write();
+  c5.Print(".png");
+
+  //V plane
+  // last sample - presample
+  TH1F *hLastPreV2 = (TH1F*)hLastPreV.Clone();  // make a copy of the histogram to use for two separate peaks to get two statistics boxes
+  hLastPreV2->SetNameTitle("Positive Peak","hey");
+  hLastPreV.SetNameTitle("Negative Peak","Last sample passing V threshold - first presample ADC");
+
+  c6.cd(1);
+  //gStyle->SetOptStat(11); // regular stats box only has the name and number of entries
+  hLastPreV.Draw("");
+  hLastPreV.GetYaxis()->SetTitleOffset(2);
+  gStyle->SetOptFit(1);   // statistics box with the info from the fit without errors
+  g7->SetLineColor(kBlue); // make the fit blue to distinguish it
+  hLastPreV.Fit(g7,"R"); // negative peak
+  hLastPreV.GetYaxis()->SetTitleOffset(2);
+  c6.Update();
+  TPaveStats *st7 = (TPaveStats*)hLastPreV.FindObject( "stats" ); // get that stats box
+  if (st7){                      // move the statistics box so that you can see both boxes at the same time
+    st7->SetX1NDC(0.68);
+    st7->SetX2NDC(1.0);
+    st7->SetY1NDC(0.6);
+    st7->SetY2NDC(0.9);
+  }
+
+  hLastPreV2->Draw("sames");  // positive peak
+  gStyle->SetOptFit(1);
+  g8->SetLineColor(kGreen);
+  hLastPreV2->GetYaxis()->SetTitleOffset(2);
+  hLastPreV2->Fit(g8,"R");
+  hLastPreV2->GetYaxis()->SetTitleOffset(2);
+  c6.Update();
+  TPaveStats *st8 = (TPaveStats*)hLastPreV2->FindObject( "stats" );
+  if (st8){
+    st8->SetX1NDC(0.68);
+    st8->SetX2NDC(1.0);
+    st8->SetY1NDC(0.3);
+    st8->SetY2NDC(0.6);
+  }
+  hLastPreV2->SetLineColor(kBlack);
+  //TLine line2(-15,0,-15,27000);
+  line2.SetLineColor(kRed);
+  line2.Draw();
+  //TLine line3(15,0,15,27000);
+  line3.SetLineColor(kRed);
+  line3.Draw();
+
+  c6.cd(2); //last sample - postsample
+  TH1F *hLastPostV2 = (TH1F*)hLastPostV.Clone();  // make a copy of the histogram to use for two separate peaks to get two statistics boxes
+  hLastPostV2->SetNameTitle("Positive Peak","hey");
+  hLastPostV.SetNameTitle("Negative Peak","Last sample passing V threshold - last postsample ADC");
+
+  // gStyle->SetOptStat(11); // regular stats box only has the name and number of entries
+  hLastPostV.Draw("");
+  gStyle->SetOptFit(1);   // statistics box with the info from the fit without errors
+  g9->SetLineColor(kBlue); // make the fit blue to distinguish it
+  hLastPostV.Fit(g9,"R"); // negative peak
+  hLastPostV.GetYaxis()->SetTitleOffset(2);
+  c6.Update();
+  TPaveStats *st9 = (TPaveStats*)hLastPostV.FindObject( "stats" ); // get that stats box
+  if (st9){                      // move the statistics box so that you can see both boxes at the same time
+    st9->SetX1NDC(0.68);
+    st9->SetX2NDC(1.0);
+    st9->SetY1NDC(0.6);
+    st9->SetY2NDC(0.9);
+  }
+
+  hLastPostV2->Draw("sames");  // positive peak
+  gStyle->SetOptFit(1);
+  g10->SetLineColor(kGreen);
+  hLastPostV2->Fit(g10,"R");
+  hLastPostV2->GetYaxis()->SetTitleOffset(2);
+  c6.Update();
+  TPaveStats *st10 = (TPaveStats*)hLastPostV2->FindObject( "stats" );
+  if (st10){
+    st10->SetX1NDC(0.68);
+    st10->SetX2NDC(1.0);
+    st10->SetY1NDC(0.3);
+    st10->SetY2NDC(0.6);
+  }
+  hLastPostV2->SetLineColor(kBlack);
+  hLastPostV2->GetYaxis()->SetTitleOffset(2);
+  TLine line12I(-15,0,-15,17000);
+  line12I.SetLineColor(kRed);
+  line12I.Draw();
+  TLine line13I(15,0,15,17000);
+  line13I.SetLineColor(kRed);
+  line13I.Draw();
+
+  c6.cd(3); // last sample - algorithm
+  TH1F *hLastAlgoV2 = (TH1F*)hLastAlgoV.Clone();  // make a copy of the histogram to use for two separate peaks to get two statistics boxes
+  hLastAlgoV2->SetNameTitle("Positive Peak","hey");
+  hLastAlgoV.SetNameTitle("Negative Peak","Last sample passing V threshold - algorithm baseline ADC");
+
+  //  gStyle->SetOptStat(11); // regular stats box only has the name and number of entries
+  hLastAlgoV.Draw("");
+  hLastAlgoV.GetYaxis()->SetTitleOffset(2);
+  gStyle->SetOptFit(1);   // statistics box with the info from the fit without errors
+  g11->SetLineColor(kBlue); // make the fit blue to distinguish it
+  hLastAlgoV.Fit(g11,"R"); // negative peak
+  hLastAlgoV.GetYaxis()->SetTitleOffset(2);
+  c6.Update();
+  TPaveStats *st11 = (TPaveStats*)hLastAlgoV.FindObject( "stats" ); // get that stats box
+  if (st11){                      // move the statistics box so that you can see both boxes at the same time
+    st11->SetX1NDC(0.68);
+    st11->SetX2NDC(1.0);
+    st11->SetY1NDC(0.6);
+    st11->SetY2NDC(0.9);
+  }
+
+  hLastAlgoV2->Draw("sames");  // positive peak
+  gStyle->SetOptFit(1);
+  g12->SetLineColor(kGreen);
+  hLastAlgoV2->Fit(g12,"R");
+  c6.Update();
+  TPaveStats *st12 = (TPaveStats*)hLastAlgoV2->FindObject( "stats" );
+  if (st12){
+    st12->SetX1NDC(0.68);
+    st12->SetX2NDC(1.0);
+    st12->SetY1NDC(0.3);
+    st12->SetY2NDC(0.6);
+  }
+  hLastAlgoV2->SetLineColor(kBlack);
+  TLine line12II(-15,0,-15,34000);
+  line12II.SetLineColor(kRed);
+  line12II.Draw();
+  TLine line13II(15,0,15,34000);
+  line13II.SetLineColor(kRed);
+  line13II.Draw();
+  c6.cd();
+  c6.Write();
+  c6.Print(".png");
+
+  //Y plane
+  c7.cd(1);
+  hLastPreY.Fit("gaus","","",13,30);
+  gStyle->SetOptFit(1);
+  hLastPreY.SetLineColor(kBlack);
+  hLastPreY.GetYaxis()->SetTitleOffset(2);
+  //TLine line4(30,0,30,21000);
+  line4.SetLineColor(kRed);
+  line4.Draw();
+  c7.cd(2);
+  hLastPostY.Fit("gaus","","",12,40);
+  gStyle->SetOptFit(1);
+  hLastPostY.SetLineColor(kBlack);
+  hLastPostY.GetYaxis()->SetTitleOffset(2);
+  TLine line4Ii(30,0,30,8000);
+  line4Ii.SetLineColor(kRed);
+  line4Ii.Draw();
+  c7.cd(3);
+  hLastAlgoY.Fit("gaus","","",16,32);
+  gStyle->SetOptFit(1);
+  hLastAlgoY.SetLineColor(kBlack);
+  hLastAlgoY.GetYaxis()->SetTitleOffset(2);
+  line4.Draw();
+  c7.cd();
+  c7.Write();
+  c7.Print(".png");
+
+  //2D
+  c8.cd(1);
+  Draw2D(hLastPre, fLastPreQ, drawn);
+
+  //TLine line5(0,-25,8256,-25);
+  line5.SetLineColor(kRed);
+  line5.Draw();
+  //TLine line6(0,15,8256,15);
+  line6.SetLineColor(kRed);
+  line6.Draw();
+  //TLine line7(0,-15,8256,-15);
+  line7.SetLineColor(kRed);
+  line7.Draw();
+  //TLine line8(0,30,8256,30);
+  line8.SetLineColor(kRed);
+  line8.Draw();
+  c8.cd(2);
+  Draw2D(hLastPost, fLastPostQ, drawn);
+  line5.Draw();
+  line6.Draw();
+  line7.Draw();
+  line8.Draw();
+  c8.cd(3);
+  Draw2D(hLastAlgo, fLastAlgoQ, drawn);
+  line5.Draw();
+  line6.Draw();
+  line7.Draw();
+  line8.Draw();
+  c8.cd();
+  c8.Write();
+  c8.Print(".png");
+  for(auto& h : drawn.hists) if(h->GetDimension() == 2) h->Write();
+  drawn.hists.clear();
+  drawn.dense.clear();
+
+  c10.cd();
+  hFirstNegV.Draw("hist ][");
+  c10.Print(".png");
+
+  // median, IQR and tails per plane, and per channel into the file
+  for(ChannelQuantiles* quantiles : Quantiles()){
+    quantiles->Print();
+    quantiles->Write();
+  }
+}
+
+void sn::BaselineAna::Draw2D(SparseTH2I const& h, ChannelQuantiles& quantiles, Drawn& drawn)
+{
+  if(fFullHists){
+    std::unique_ptr<DenseBooking> dense(new DenseBooking(h.GetName(), h.DenseBytes()));
+    if(*dense){
+      drawn.dense.push_back(std::move(dense));
+      drawn.hists.emplace_back(h.MakeTH2());
+      drawn.hists.back()->Draw("colz");
+      return;
+    }
+  }
+
+  // the per-channel median between the quartiles
+  drawn.hists.emplace_back(quantiles.MakeTH1(ChannelQuantiles::kMedian));
+  drawn.hists.back()->SetLineColor(kBlack);
+  drawn.hists.back()->Draw("hist");
+  for(ChannelQuantiles::Summary what : { ChannelQuantiles::kQ25, ChannelQuantiles::kQ75 }){
+    drawn.hists.emplace_back(quantiles.MakeTH1(what));
+    drawn.hists.back()->SetLineColor(kGray+1);
+    drawn.hists.back()->Draw("hist same");
+  }
+}
+
+std::vector<TH1*> sn::BaselineAna::Hists()
+{
+  return { &hFirstPreU,
+           &hFirstPreV,
+           &hFirstPreY,
+           &hFirstPostU,
+           &hFirstPostV,
+           &hFirstPostY,
+           &hFirstAlgoU,
+           &hFirstAlgoV,
+           &hFirstAlgoY,
+           &hLastPreU,
+           &hLastPreV,
+           &hLastPreY,
+           &hLastPostU,
+           &hLastPostV,
+           &hLastPostY,
+           &hLastAlgoU,
+           &hLastAlgoV,
+           &hLastAlgoY,
+           &hFirstNegV };
+}
+
+std::vector<sn::SparseHist2D*> sn::BaselineAna::SparseHists()
+{
+  return { &hFirstPre,
+           &hFirstPost,
+           &hFirstAlgo,
+           &hLastPre,
+           &hLastPost,
+           &hLastAlgo };
+}
+
+std::vector<sn::ChannelQuantiles*> sn::BaselineAna::Quantiles()
+{
+  return { &fFirstPreQ,
+           &fFirstPostQ,
+           &fFirstAlgoQ,
+           &fLastPreQ,
+           &fLastPostQ,
+           &fLastAlgoQ };
+}
+
+sn::SNStage* sn::BaselineAna::NewWorker() const
+{
+  BaselineAna* worker = new BaselineAna();
+  worker->fFullHists = fFullHists;
+  return worker;
+}
+
+void sn::BaselineAna::Merge(SNStage& worker)
+{
+  BaselineAna& other = dynamic_cast<BaselineAna&>(worker);
+  std::vector<TH1*> mine = Hists();
+  std::vector<TH1*> theirs = other.Hists();
+  for(size_t i_h=0; i_h<mine.size(); i_h++)
+    mine[i_h]->Add(theirs[i_h]);
+  std::vector<SparseHist2D*> mineSparse = SparseHists();
+  std::vector<SparseHist2D*> theirsSparse = other.SparseHists();
+  for(size_t i_h=0; i_h<mineSparse.size(); i_h++)
+    mineSparse[i_h]->Add(*theirsSparse[i_h]);
+  std::vector<ChannelQuantiles*> mineQ = Quantiles();
+  std::vector<ChannelQuantiles*> theirsQ = other.Quantiles();
+  for(size_t i_q=0; i_q<mineQ.size(); i_q++)
+    mineQ[i_q]->Merge(*theirsQ[i_q]);
+
+  counterpos += other.counterpos;
+  counterneg += other.counterneg;
+}
+
+size_t sn::BaselineAna::BookingBytes()
+{
+  // six differences, each in U (400 bins), V (100) and Y (400), and hFirstNegV
+  return 6*(2*HistBytes(400, 0, sizeof(int)) + HistBytes(100, 0, sizeof(int))) + HistBytes(2400, 0, sizeof(int));
+}
+
+size_t sn::BaselineAna::SparseBytes()
+{
+  size_t bytes = 0;
+  for(auto const* h : SparseHists()) bytes += h->Bytes();
+  for(auto const* q : Quantiles()) bytes += q->Bytes();
+  return bytes;
+}
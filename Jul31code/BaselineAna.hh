@@ -0,0 +1,114 @@
+//***************************
+//    analysis baseline estimations in each plane
+//    Clara Berger 6/20/18
+//***************************
+
+#ifndef SN_BASELINEANA_HH
+#define SN_BASELINEANA_HH
+
+//some standard C++ includes
+#include <vector>
+#include <memory>
+
+//some ROOT includes
+#include "TH1F.h"
+#include "TH2S.h"
+
+#include "SNStage.hh"
+#include "FillBuffer.h"
+#include "SparseHist2D.hh"
+#include "QuantileSketch.hh"
+
+namespace sn{
+
+  class DenseBooking;
+
+  class BaselineAna : public SNStage{
+
+  public:
+    size_t MaxEvents() const override { return 100; }
+    void ProcessEvent(SNEvent const& evt) override;
+    void Finish() override;
+
+    bool RunsInParallel() const override { return true; }
+    SNStage* NewWorker() const override;
+    void Merge(SNStage& worker) override;
+    size_t SparseBytes() override;
+    static size_t BookingBytes();   // the histogram members below, before they are booked
+
+    // the differences are kept as quantile sketches per channel and plane (ChannelQuantiles);
+    // their full channel x ADC TH2s are only filled and written on request
+    void SetFullHists(bool full) { fFullHists = full; }
+
+  private:
+    bool fFullHists = false;
+
+    // the wires [firstWire,lastWire) of one event; everything shared is filled through fills
+    void ProcessWires(std::vector<recob::Wire> const& wire_vec, size_t firstWire, size_t lastWire, FillBuffer& fills);
+
+    // everything that gets filled, in one list for merging
+    std::vector<TH1*> Hists();
+    std::vector<SparseHist2D*> SparseHists();
+    std::vector<ChannelQuantiles*> Quantiles();
+
+    // what the 2D pads of a canvas show, until it is written: the TH2s with their room in
+    // the memory budget, or the per-channel summaries
+    struct Drawn{
+      std::vector< std::unique_ptr<TH1> > hists;
+      std::vector< std::unique_ptr<DenseBooking> > dense;
+    };
+    // a 2D pad: the TH2 (SetFullHists, if it fits in the memory budget) or the per-channel
+    // median and quartiles, kept in drawn
+    void Draw2D(SparseTH2I const& h, ChannelQuantiles& quantiles, Drawn& drawn);
+
+    // per channel and plane: the six differences below, all in ADC
+    ChannelQuantiles fFirstPreQ{"hFirstPre", "First sample passing threshold - first presample (ADC)"};
+    ChannelQuantiles fFirstPostQ{"hFirstPost", "First sample passing threshold - last postsample (ADC)"};
+    ChannelQuantiles fFirstAlgoQ{"hFirstAlgo", "First sample passing threshold - algorithm baseline (ADC)"};
+    ChannelQuantiles fLastPreQ{"hLastPre", "Last sample passing threshold - first presample (ADC)"};
+    ChannelQuantiles fLastPostQ{"hLastPost", "Last sample passing threshold - last postsample (ADC)"};
+    ChannelQuantiles fLastAlgoQ{"hLastAlgo", "Last sample passing threshold - algorithm baseline (ADC)"};
+
+    //first passing sample - first presample (the TH2s: SetFullHists)
+    TH1I hFirstPreU{"hFirstPreu","First sample passing U threshold - first presample ADC; ADC; Frequency",400,-200,200};
+    TH1I hFirstPreV{"hFirstPrev","First sample passing V threshold - first presample ADC; ADC; Frequency",100,-50,50};
+    TH1I hFirstPreY{"hFirstPrey","First sample passing Y threshold - first presample ADC; ADC; Frequency",400,-200,200};
+    SparseTH2I hFirstPre{"hFirstPre", "First sample passing threshold - first presample ADC; Channel; ADC", 8256, 0, 8256, 400, -200, 200};
+    //first passing sample - last postsample
+    TH1I hFirstPostU{"hFirstPostu","First sample passing U threshold - last postsample ADC; ADC; Frequency",400,-200,200};
+    TH1I hFirstPostV{"hFirstPostv","First sample passing V threshold - last postsample ADC; ADC; Frequency",100,-50,50};
+    TH1I hFirstPostY{"hFirstPosty","First sample passing Y threshold - last postsample ADC; ADC; Frequency",400,-200,200};
+    SparseTH2I hFirstPost{"hFirstPost","First sample passing threshold - last postsample ADC; Channel; ADC;", 8256, 0, 8256, 400,-200,200};
+    // first passing sample - algorithm baseline
+    TH1I hFirstAlgoU{"hFirstAlgou","First sample passing U threshold - algorithm baseline ADC; ADC; Frequency",400,-200,200};
+    TH1I hFirstAlgoV{"hFirstAlgov","First sample passing V threshold - algorithm baseline ADC; ADC; Frequency",100,-50,50};
+    TH1I hFirstAlgoY{"hFirstAlgoy","First sample passing Y threshold - algorithm baseline ADC; ADC; Frequency",400,-200,200};
+    SparseTH2I hFirstAlgo{"hFirstAlgo","First sample passing threshold - algorithm baseline ADC; Channel; ADC;", 8256, 0, 8256, 400,-200,200};
+
+    // last sample passing the threshold
+    TH1I hLastPreU{"hLastPreu","Last sample passing U threshold - first presample ADC; ADC; Frequency",400,-200,200};
+    TH1I hLastPreV{"hLastPrev","Last sample passing V threshold - first presample ADC; ADC; Frequency",100,-50,50};
+    TH1I hLastPreY{"hLastPrey","Last sample passing Y threshold - first presample ADC; ADC; Frequency",400,-200,200};
+    SparseTH2I hLastPre{"hLastPre", "Last sample passing threshold - first presample ADC; Channel; ADC", 8256, 0, 8256, 400, -200, 200};
+
+    TH1I hLastPostU{"hLastPostu","Last sample passing U threshold - last postsample ADC; ADC; Frequency",400,-200,200};
+    TH1I hLastPostV{"hLastPostv","Last sample passing V threshold - last postsample ADC; ADC; Frequency",100,-50,50};
+    TH1I hLastPostY{"hLastPosty","Last sample passing Y threshold - last postsample ADC; ADC; Frequency",400,-200,200};
+    SparseTH2I hLastPost{"hLastPost","Last sample passing threshold - last postsample ADC; Channel; ADC;", 8256, 0, 8256, 400,-200,200};
+
+    TH1I hLastAlgoU{"hLastAlgou","Last sample passing U threshold - algorithm baseline ADC; ADC; Frequency",400,-200,200};
+    TH1I hLastAlgoV{"hLastAlgov","Last sample passing V threshold - algorithm baseline ADC; ADC; Frequency",100,-50,50};
+    TH1I hLastAlgoY{"hLastAlgoy","Last sample passing Y threshold - algorithm baseline ADC; ADC; Frequency",400,-200,200};
+    SparseTH2I hLastAlgo{"hLastAlgo","Last sample passing threshold - algorithm baseline ADC; Channel; ADC;", 8256, 0, 8256, 400,-200,200};
+
+    //channels in V that have negative first samples passing the threshold
+    TH1I hFirstNegV{"hFirstNegV","V Channels where the first sample passing the threshold-last post sample is negative; Channel; Frequency",2400,2401,4800};
+
+    // to find the ratio between the positive and negative peaks of the Vplane threshold
+    double counterpos=0;
+    double counterneg=0;
+  };
+
+}
+
+#endif
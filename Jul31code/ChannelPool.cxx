@@ -0,0 +1,159 @@
+//***************************
+//    thread pool for running the wires of one event in parallel
+//***************************
+
+#include "ChannelPool.hh"
+#include "SNStage.hh"
+
+sn::ChannelPool::ChannelPool(size_t nThreads)
+  : fTask(nullptr)
+  , fGeneration(0)
+  , fRemaining(0)
+  , fStop(false)
+{
+  if(nThreads < 1) nThreads = 1;
+  for(size_t w=0; w<nThreads; w++)
+    fQueues.emplace_back(new Queue());
+  for(size_t w=1; w<nThreads; w++)
+    fThreads.emplace_back(&ChannelPool::WorkerLoop, this, w);
+}
+
+sn::ChannelPool::~ChannelPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStop = true;
+  }
+  fWake.notify_all();
+  for(auto& t : fThreads) t.join();
+}
+
+void sn::ChannelPool::Run(size_t nTasks, std::function<void(size_t)> const& task)
+{
+  if(nTasks == 0) return;
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fTask = &task;
+    fRemaining = nTasks;
+  }
+
+  // contiguous blocks, so neighbouring chunks stay on one thread unless somebody steals them
+  const size_t nQueues = fQueues.size();
+  for(size_t q=0; q<nQueues; q++){
+    std::lock_guard<std::mutex> lock(fQueues[q]->m);
+    for(size_t t = q*nTasks/nQueues; t < (q+1)*nTasks/nQueues; t++)
+      fQueues[q]->tasks.push_back(t);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fGeneration++;
+  }
+  fWake.notify_all();
+
+  // the calling thread works too
+  size_t t;
+  while(NextTask(0,t)) DoTask(t);
+
+  std::unique_lock<std::mutex> lock(fMutex);
+  fDone.wait(lock, [this](){ return fRemaining == 0; });
+}
+
+void sn::ChannelPool::WorkerLoop(size_t w)
+{
+  size_t seen = 0;
+  while(true){
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      fWake.wait(lock, [this,seen](){ return fStop || fGeneration != seen; });
+      if(fStop) return;
+      seen = fGeneration;
+    }
+    size_t t;
+    while(NextTask(w,t)) DoTask(t);
+  }
+}
+
+bool sn::ChannelPool::NextTask(size_t w, size_t& task)
+{
+  {
+    Queue& own = *fQueues[w];
+    std::lock_guard<std::mutex> lock(own.m);
+    if(!own.tasks.empty()){
+      task = own.tasks.front();
+      own.tasks.pop_front();
+      return true;
+    }
+  }
+
+  // nothing left of our own, steal from the far end of somebody else's
+  const size_t nQueues = fQueues.size();
+  for(size_t k=1; k<nQueues; k++){
+    Queue& other = *fQueues[(w+k)%nQueues];
+    std::lock_guard<std::mutex> lock(other.m);
+    if(!other.tasks.empty()){
+      task = other.tasks.back();
+      other.tasks.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
+
+void sn::ChannelPool::DoTask(size_t task)
+{
+  (*fTask)(task);
+  if(--fRemaining == 0){
+    std::lock_guard<std::mutex> lock(fMutex);
+    fDone.notify_all();
+  }
+}
+
+std::vector<size_t> sn::BalancedWireChunks(std::vector<recob::Wire> const& wires, size_t nChunks)
+{
+  std::vector<size_t> bounds { 0 };
+  if(nChunks < 2 || wires.size() < 2){
+    bounds.push_back(wires.size());
+    return bounds;
+  }
+
+  size_t nROIs = 0;
+  for(auto const& wire : wires) nROIs += wire.SignalROI().n_ranges();
+
+  // close chunk k as soon as it holds k/nChunks of all the ROIs
+  size_t seen = 0;
+  size_t k = 1;
+  for(size_t i=0; i+1<wires.size() && k<nChunks; i++){
+    seen += wires[i].SignalROI().n_ranges();
+    if(seen*nChunks >= k*nROIs){
+      bounds.push_back(i+1);
+      while(k<nChunks && seen*nChunks >= k*nROIs) k++;
+    }
+  }
+  bounds.push_back(wires.size());
+  return bounds;
+}
+
+void sn::ForEachWireChunk(SNEvent const& evt,
+                          std::function<void(size_t, size_t, FillBuffer&)> const& func)
+{
+  auto const& wire_vec(*evt.wires);
+
+  if(!evt.pool || evt.pool->NThreads() < 2){
+    FillBuffer fills(true);
+    func(0, wire_vec.size(), fills);
+    fills.Flush();
+    return;
+  }
+
+  // a few chunks per thread, so there is something left to steal
+  const std::vector<size_t> bounds = BalancedWireChunks(wire_vec, 4*evt.pool->NThreads());
+  const size_t nChunks = bounds.size()-1;
+
+  std::vector<FillBuffer> fills(nChunks);
+  evt.pool->Run(nChunks, [&](size_t k){ func(bounds[k], bounds[k+1], fills[k]); });
+
+  // in channel order, as if it had run on one thread
+  for(auto& chunkFills : fills) chunkFills.Flush();
+}
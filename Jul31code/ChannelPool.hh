@@ -0,0 +1,78 @@
+//***************************
+//    thread pool for running the wires of one event in parallel
+//
+//    the wires are cut into chunks holding about the same number of ROIs
+//    (Y-plane channels have many more than U/V), the chunks are dealt out to
+//    per-thread queues and idle threads steal from the back of the others.
+//***************************
+
+#ifndef SN_CHANNELPOOL_HH
+#define SN_CHANNELPOOL_HH
+
+//some standard C++ includes
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdlib.h>
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+#include "FillBuffer.h"
+
+namespace sn{
+
+  struct SNEvent;
+
+  class ChannelPool{
+
+  public:
+    // nThreads counts the calling thread, so nThreads-1 threads get started
+    explicit ChannelPool(size_t nThreads);
+    ~ChannelPool();
+
+    size_t NThreads() const { return fQueues.size(); }
+
+    // runs task(0) ... task(nTasks-1) on the pool and returns when all of them are done
+    void Run(size_t nTasks, std::function<void(size_t)> const& task);
+
+  private:
+    struct Queue{
+      std::mutex m;
+      std::deque<size_t> tasks;
+    };
+
+    void WorkerLoop(size_t w);
+    bool NextTask(size_t w, size_t& task);   // own queue from the front, others from the back
+    void DoTask(size_t task);
+
+    std::vector< std::unique_ptr<Queue> > fQueues;   // one per thread, 0 is the caller
+    std::vector<std::thread> fThreads;
+
+    std::mutex fMutex;
+    std::condition_variable fWake;
+    std::condition_variable fDone;
+    std::function<void(size_t)> const* fTask;
+    size_t fGeneration;
+    std::atomic<size_t> fRemaining;
+    bool fStop;
+  };
+
+  // wire index boundaries of (at most) nChunks chunks with about the same number of ROIs each:
+  // chunk k is wires [bounds[k], bounds[k+1])
+  std::vector<size_t> BalancedWireChunks(std::vector<recob::Wire> const& wires, size_t nChunks);
+
+  // runs func(firstWire, lastWire, fills) over all the wires of the event: in chunks over
+  // evt.pool if there is one, in one go otherwise. All shared histograms and counters have to
+  // be filled through 'fills'; they are replayed in channel order before this returns.
+  void ForEachWireChunk(SNEvent const& evt,
+                        std::function<void(size_t, size_t, FillBuffer&)> const& func);
+
+}
+
+#endif
@@ -0,0 +1,88 @@
+//***************************
+//    per-channel running statistics
+//***************************
+
+#include "ChannelStats.hh"
+
+//some standard C++ includes
+#include <algorithm>
+
+sn::ChannelStats::ChannelStats(const char* name, const char* title, size_t nChannels)
+  : fName(name)
+  , fTitle(title)
+  , fCount(nChannels, 0)
+  , fMean(nChannels, 0)
+  , fM2(nChannels, 0)
+  , fMin(nChannels, 0)
+  , fMax(nChannels, 0)
+  , fOutside(0)
+  , fNonFinite(0)
+{}
+
+void sn::ChannelStats::Merge(ChannelStats const& other)
+{
+  for(size_t ch=0; ch<fCount.size() && ch<other.fCount.size(); ch++){
+    const uint64_t nb = other.fCount[ch];
+    if(nb == 0) continue;
+    const uint64_t na = fCount[ch];
+    if(na == 0){
+      fCount[ch] = nb;
+      fMean[ch] = other.fMean[ch];
+      fM2[ch] = other.fM2[ch];
+      fMin[ch] = other.fMin[ch];
+      fMax[ch] = other.fMax[ch];
+      continue;
+    }
+    const double n = double(na + nb);
+    const double delta = other.fMean[ch] - fMean[ch];
+    fMean[ch] += delta*nb/n;
+    fM2[ch] += other.fM2[ch] + delta*delta*(double(na)*nb/n);
+    fMin[ch] = std::min(fMin[ch], other.fMin[ch]);
+    fMax[ch] = std::max(fMax[ch], other.fMax[ch]);
+    fCount[ch] = na + nb;
+  }
+  fOutside += other.fOutside;
+  fNonFinite += other.fNonFinite;
+}
+
+size_t sn::ChannelStats::Bytes() const
+{
+  return fCount.size()*(sizeof(uint64_t) + 4*sizeof(double));
+}
+
+std::unique_ptr<TH1D> sn::ChannelStats::MakeTH1(Summary what) const
+{
+  static const char* const suffix[] = { "mean", "stddev", "min", "max", "count" };
+  static const char* const label[] = { "mean", "standard deviation", "minimum", "maximum", "entries" };
+
+  const std::string name = fName + "_" + suffix[what];
+  const std::string title = fName + " " + label[what] + " per channel; Channel; "
+    + (what == kCount ? std::string("Entries") : fTitle);
+  const int nChannels = fCount.size();
+  std::unique_ptr<TH1D> h(new TH1D(name.c_str(), title.c_str(), nChannels, 0, nChannels));
+  if(what == kMean) h->Sumw2();
+
+  size_t nFilled = 0;
+  for(int ch=0; ch<nChannels; ch++){
+    if(fCount[ch] == 0) continue;
+    nFilled++;
+    double v = 0;
+    switch(what){
+    case kMean:   v = fMean[ch]; break;
+    case kStdDev: v = StdDev(ch); break;
+    case kMin:    v = fMin[ch]; break;
+    case kMax:    v = fMax[ch]; break;
+    case kCount:  v = fCount[ch]; break;
+    }
+    h->SetBinContent(ch+1, v);
+    if(what == kMean) h->SetBinError(ch+1, StdDev(ch));
+  }
+  h->SetEntries(nFilled);   // channels that saw anything
+  return h;
+}
+
+void sn::ChannelStats::Write() const
+{
+  for(Summary what : { kMean, kStdDev, kMin, kMax, kCount })
+    MakeTH1(what)->Write();
+}
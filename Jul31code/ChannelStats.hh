@@ -0,0 +1,86 @@
+//***************************
+//    per-channel running statistics
+//
+//    most of the channel x quantity TH2s are only ever looked at for the mean
+//    and spread in each channel. ChannelStats keeps exactly that for every
+//    channel: count, mean and variance (Welford), min and max, each in one
+//    array over the 8256 channels. Two of them merge (Chan et al.), so every
+//    worker can keep its own. The summaries become TH1Ds over the channels
+//    when they are drawn or written.
+//***************************
+
+#ifndef SN_CHANNELSTATS_HH
+#define SN_CHANNELSTATS_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <stdint.h>
+
+//some ROOT includes
+#include "TH1D.h"
+
+namespace sn{
+
+  class ChannelStats{
+
+  public:
+    static constexpr size_t kNChannels = 8256;
+
+    // the title is the quantity, as on the y axis of the TH2 it stands for ("Mean (ADC)")
+    ChannelStats(const char* name, const char* title, size_t nChannels = kNChannels);
+
+    // one value of a channel; channels outside [0,nChannels) and NaN/inf are only counted
+    void Fill(int channel, double v){
+      if(channel < 0 || size_t(channel) >= fCount.size()){ fOutside++; return; }
+      if(!std::isfinite(v)){ fNonFinite++; return; }
+      const uint64_t n = ++fCount[channel];
+      const double delta = v - fMean[channel];
+      fMean[channel] += delta/n;
+      fM2[channel] += delta*(v - fMean[channel]);
+      if(n == 1 || v < fMin[channel]) fMin[channel] = v;
+      if(n == 1 || v > fMax[channel]) fMax[channel] = v;
+    }
+
+    // add another worker's values, as if they had been filled here
+    void Merge(ChannelStats const& other);
+
+    const char* GetName() const { return fName.c_str(); }
+    size_t NChannels() const { return fCount.size(); }
+    uint64_t Count(size_t channel) const { return fCount[channel]; }
+    double Mean(size_t channel) const { return fMean[channel]; }
+    // population variance, the spread a TH2's ProjectionY would show (0 with less than 2 values)
+    double Variance(size_t channel) const { return fCount[channel] > 1 ? fM2[channel]/fCount[channel] : 0; }
+    double StdDev(size_t channel) const { return std::sqrt(Variance(channel)); }
+    double Min(size_t channel) const { return fMin[channel]; }
+    double Max(size_t channel) const { return fMax[channel]; }
+    size_t NOutside() const { return fOutside; }
+    size_t NNonFinite() const { return fNonFinite; }
+
+    size_t Bytes() const;
+
+    enum Summary { kMean, kStdDev, kMin, kMax, kCount };
+    // one summary over the channels, booked in gDirectory as <name>_mean, <name>_stddev, ...
+    // The mean has the standard deviation as its error, so Draw("E") shows the spread
+    std::unique_ptr<TH1D> MakeTH1(Summary what) const;
+
+    // all the summaries, one at a time, into gDirectory
+    void Write() const;
+
+  private:
+    std::string fName;
+    std::string fTitle;
+    std::vector<uint64_t> fCount;
+    std::vector<double> fMean;
+    std::vector<double> fM2;    // sum of squared differences to the mean
+    std::vector<double> fMin;
+    std::vector<double> fMax;
+    size_t fOutside;
+    size_t fNonFinite;
+  };
+
+}
+
+#endif
@@ -1,18 +1,33 @@
 //********************************
-// plot event display after display to look through with more convenience 
+// plot event display after display to look through with more convenience
+//
+//   root -l
+//   .x DrawCanvasData.cc+
+//
+// the canvases are listed once from the keys, so any of them can be shown at any
+// time; while one is on the screen a background thread reads (and decompresses) the
+// next and the previous one of the list, so stepping does not wait for the file.
+// After double clicking the display:
+//   Enter: next, b: back, j N: the N-th canvas, e RUN EVENT: that event,
+//   f RUN [EVENT_LOW EVENT_HIGH]: only those from now on, f: all again, l: list, q: quit
 //*********************************
 
 
-//some standard C++ includes          (from ReadSNSwizzledData.cc)                                                                                           
+//some standard C++ includes          (from ReadSNSwizzledData.cc)
 #include <iostream>
+#include <sstream>
 #include <stdlib.h>
+#include <cstdio>
 #include <string>
 #include <vector>
-#include <chrono>
-#include <limits>
+#include <map>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 
-//some ROOT includes                                                                                                          
+//some ROOT includes
 #include "TInterpreter.h"
 #include "TROOT.h"
 #include "TH1F.h"
@@ -20,38 +35,208 @@
 #include "TFile.h"
 #include "TCanvas.h"
 #include "TPad.h"
+#include "TStyle.h"
 #include "TIterator.h"
 #include "TKey.h"
 
-//convenient for us! let's not bother with art and std namespaces!                                                           
- 
-using namespace art;
+//convenient for us! let's not bother with the std namespace!
+
 using namespace std;
 
-using namespace std::chrono;
+// one canvas of the file: the key name, and the run and event from "c4_<run>_<event>" (-1 if not)
+struct CanvasEntry{
+  string name;
+  int run;
+  int event;
+};
 
-// define a control that shows "press enter to continue" after each iteration and then takes an enter input
-void PressEnterToContinue()
-{
-  cout << "Press Enter to continue" << flush ;
-  cin.ignore(numeric_limits<streamsize>::max(),'\n');
-}
+// reads the canvases it is asked for on its own thread, from its own TFile (a TFile is not
+// to be shared between threads), and keeps them until they are taken
+class CanvasPrefetcher{
+
+public:
+  explicit CanvasPrefetcher(const char* path)
+    : fPath(path), fStop(false), fThread(&CanvasPrefetcher::ReadLoop, this) {}
+
+  ~CanvasPrefetcher(){
+    {
+      lock_guard<mutex> lock(fMutex);
+      fStop = true;
+    }
+    fChanged.notify_all();
+    fThread.join();
+    for(auto& c : fDone) delete c.second;
+  }
+
+  // read these next (the ones not wanted any more are dropped)
+  void Want(vector<string> const& names){
+    lock_guard<mutex> lock(fMutex);
+    fWanted = names;
+    for(auto it = fDone.begin(); it != fDone.end(); ){
+      if(find(names.begin(), names.end(), it->first) == names.end()){ delete it->second; it = fDone.erase(it); }
+      else ++it;
+    }
+    fChanged.notify_all();
+  }
+
+  // the canvas if it has been read already, nullptr if not; it is the caller's then
+  TCanvas* Take(string const& name){
+    lock_guard<mutex> lock(fMutex);
+    auto it = fDone.find(name);
+    if(it == fDone.end()) return nullptr;
+    TCanvas* c = it->second;
+    fDone.erase(it);
+    return c;
+  }
+
+private:
+  void ReadLoop(){
+    TFile* file = TFile::Open(fPath.c_str());
+    while(true){
+      string name;
+      {
+        unique_lock<mutex> lock(fMutex);
+        fChanged.wait(lock, [this]{ return fStop || NextWanted(); });
+        if(fStop) break;
+        name = fWanted.front();
+        fWanted.erase(fWanted.begin());
+      }
+      TCanvas* c = file ? (TCanvas*) file->Get(name.c_str()) : nullptr;
+      lock_guard<mutex> lock(fMutex);
+      if(c) fDone[name] = c;
+    }
+    delete file;
+  }
 
-TCanvas* obj;
+  // drops the wanted ones that are there already; is there anything left to read?
+  bool NextWanted(){
+    while(!fWanted.empty() && fDone.count(fWanted.front())) fWanted.erase(fWanted.begin());
+    return !fWanted.empty();
+  }
 
+  string fPath;
+  mutex fMutex;
+  condition_variable fChanged;
+  vector<string> fWanted;
+  map<string, TCanvas*> fDone;
+  bool fStop;
+  thread fThread;   // last, so everything above is set up when it starts
+};
 
-void  DrawCanvasData()
+
+void  DrawCanvasData(const char* path = "ReadSNSwizzledData_output_500.root")  // by default the output data from 500 events in run 14662
 {
   gStyle->SetPalette(55);
-  TFile *F1 = TFile::Open("ReadSNSwizzledData_output_500.root");  // specifically uses output data from 500 events in run 14662
-  
+  ROOT::EnableThreadSafety();   // the prefetch thread reads from a file of its own
+  TFile *F1 = TFile::Open(path);
+  if(!F1 || F1->IsZombie()){
+    cout << "Can't open " << path << endl;
+    return;
+  }
+
+  // the index: every canvas, in the order of the keys
+  vector<CanvasEntry> index;
   TIter next(F1->GetListOfKeys());
   TKey *key;
   while ((key = (TKey*)next()))
     {
-      obj  =(TCanvas*) F1->Get(key->GetName());
-      obj->Draw();               // draw the event display 
-      gPad->WaitPrimitive();     // pause to look at the event display
-      PressEnterToContinue();    // go to the next one
+      if(string(key->GetClassName()) != "TCanvas") continue;
+      CanvasEntry entry{ key->GetName(), -1, -1 };
+      sscanf(key->GetName(), "c4_%d_%d", &entry.run, &entry.event);
+      index.push_back(entry);
+    }
+  if(index.empty()){
+    cout << path << " has no canvases" << endl;
+    return;
+  }
+  cout << index.size() << " event displays in " << path << endl;
+
+  // the filter: all, or one run and a range of events
+  int filterRun = -1, filterLow = -1, filterHigh = -1;
+  auto passes = [&](CanvasEntry const& e){
+    if(filterRun < 0) return true;
+    if(e.run != filterRun) return false;
+    return filterLow < 0 || (e.event >= filterLow && e.event <= filterHigh);
+  };
+  // the next (step 1) or previous (step -1) one that passes, or -1
+  auto step = [&](long from, int dir){
+    for(long i = from + dir; i >= 0 && i < (long)index.size(); i += dir)
+      if(passes(index[i])) return i;
+    return -1L;
+  };
+
+  CanvasPrefetcher prefetcher(path);
+  TCanvas* obj = nullptr;
+  long current = step(-1, 1);
+
+  while(current >= 0)
+    {
+      // from the prefetch if it got there, otherwise right now
+      CanvasEntry const& entry = index[current];
+      delete obj;
+      obj = prefetcher.Take(entry.name);
+      if(!obj) obj = (TCanvas*) F1->Get(entry.name.c_str());
+
+      // and the neighbours, while this one is looked at
+      vector<string> wanted;
+      const long after = step(current, 1), before = step(current, -1);
+      if(after >= 0) wanted.push_back(index[after].name);
+      if(before >= 0) wanted.push_back(index[before].name);
+      prefetcher.Want(wanted);
+
+      if(obj){
+        cout << "[" << current << "/" << index.size() << "] " << entry.name << endl;
+        obj->Draw();               // draw the event display
+        gPad->WaitPrimitive();     // pause to look at the event display
+      }
+      else
+        cout << "Can't read " << entry.name << endl;
+
+      cout << "Enter: next, b: back, j N, e RUN EVENT, f RUN [LOW HIGH], l, q > " << flush;
+      string line;
+      if(!getline(cin, line)) break;
+      istringstream command(line);
+      string what;
+      command >> what;
+
+      long go = current;
+      if(what.empty())
+        go = step(current, 1);
+      else if(what == "q")
+        break;
+      else if(what == "b")
+        go = step(current, -1);
+      else if(what == "j"){
+        long n = -1;
+        go = (command >> n && n >= 0 && n < (long)index.size()) ? n : -1;
+      }
+      else if(what == "e"){
+        int run = -1, event = -1;
+        go = -1;
+        if(command >> run >> event)
+          for(size_t i=0; i<index.size(); i++)
+            if(index[i].run == run && index[i].event == event){ go = i; break; }
+      }
+      else if(what == "f"){
+        int run, low, high;
+        filterRun = filterLow = filterHigh = -1;
+        if(command >> run){
+          filterRun = run;
+          if(command >> low >> high){ filterLow = low; filterHigh = high; }
+        }
+        go = passes(index[current]) ? current : step(current, 1);
+        if(go < 0) go = step(current, -1);
+      }
+      else if(what == "l"){
+        for(size_t i=0; i<index.size(); i++)
+          if(passes(index[i])) cout << "  " << i << "  " << index[i].name << endl;
+      }
+
+      if(go < 0){
+        cout << "nothing there, staying here" << endl;
+        go = current;
+      }
+      current = go;
     }
+  delete obj;
 }
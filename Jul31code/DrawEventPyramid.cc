@@ -0,0 +1,103 @@
+//********************************
+// browse the event displays of ReadSNSwizzledData -P (see EventPyramid.hh)
+//
+//   root -l
+//   .L EventPyramid.cxx+
+//   .x DrawEventPyramid.cc+("ReadSNSwizzledData_display.snpyr")
+//
+// only the tiles on the screen are read, at the resolution of the pad, and the
+// next event is read in the background while this one is looked at.
+// Zoom with the mouse, double click to get the prompt:
+//   Enter: next event, b: back, r: read again at the zoom on the screen, u: unzoom, q: quit
+//*********************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <tuple>
+#include <future>
+
+//some ROOT includes
+#include "TROOT.h"
+#include "TH2F.h"
+#include "TCanvas.h"
+#include "TPad.h"
+#include "TStyle.h"
+
+#include "EventPyramid.hh"
+
+using namespace std;
+
+void DrawEventPyramid(const char* path = "ReadSNSwizzledData_display.snpyr")
+{
+  gStyle->SetPalette(55);
+  gStyle->SetOptStat(0);
+
+  sn::EventPyramid pyramid(path);
+  if(pyramid.NEvents() == 0){
+    cout << path << " has no events" << endl;
+    return;
+  }
+
+  TCanvas* c = new TCanvas("cPyramid","event display",1000,600);
+  TH2F* h = nullptr;
+
+  // what is on the screen: event, channels, ticks, and the cells that fit on the pad
+  typedef tuple<size_t,size_t,size_t,size_t,size_t,size_t,size_t> Request;
+  size_t entry = 0;
+  size_t ch0 = 0, ch1 = pyramid.NChannels(), t0 = 0, t1 = pyramid.NTicks();
+
+  auto read = [&pyramid](Request r){
+    return pyramid.Read(get<0>(r), get<1>(r), get<2>(r), get<3>(r), get<4>(r), get<5>(r), get<6>(r));
+  };
+  Request prefetched;
+  future<sn::PyramidView> next;
+
+  while(true){
+    const Request now(entry, ch0, ch1, t0, t1, c->GetWw(), c->GetWh());
+    sn::PyramidView view;
+    if(next.valid() && prefetched == now) view = next.get();
+    else{
+      if(next.valid()) next.wait();   // not the one, but it uses the file
+      next = future<sn::PyramidView>();
+      view = read(now);
+    }
+
+    delete h;
+    h = view.MakeTH2F("hPyramid", Form("Run %d event %d (1 bin = %d x %d); Channel; Tick",
+                                       view.run, view.event, 1 << view.level, 1 << view.level)).release();
+    c->cd();
+    h->Draw("colz");
+    c->Update();
+
+    // the next event at the same zoom while this one is on the screen
+    if(entry+1 < pyramid.NEvents()){
+      prefetched = Request(entry+1, ch0, ch1, t0, t1, c->GetWw(), c->GetWh());
+      next = async(launch::async, read, prefetched);
+    }
+
+    gPad->WaitPrimitive();     // pause to look at the event display
+    cout << "Enter: next, b: back, r: read the zoom, u: unzoom, q: quit > " << flush;
+    string line;
+    if(!getline(cin, line) || line == "q") break;
+    if(line == "b"){
+      if(entry > 0) entry--;
+    }
+    else if(line == "r"){
+      ch0 = h->GetXaxis()->GetBinLowEdge(h->GetXaxis()->GetFirst());
+      ch1 = h->GetXaxis()->GetBinUpEdge(h->GetXaxis()->GetLast());
+      t0 = h->GetYaxis()->GetBinLowEdge(h->GetYaxis()->GetFirst());
+      t1 = h->GetYaxis()->GetBinUpEdge(h->GetYaxis()->GetLast());
+    }
+    else if(line == "u"){
+      ch0 = 0; ch1 = pyramid.NChannels();
+      t0 = 0; t1 = pyramid.NTicks();
+    }
+    else if(entry+1 < pyramid.NEvents())
+      entry++;
+    else
+      cout << "that was the last event" << endl;
+  }
+  if(next.valid()) next.wait();
+}
@@ -0,0 +1,117 @@
+//***************************
+//    channel x tick image of the wire signals, for the event displays
+//***************************
+
+#include "EventImage.hh"
+
+//some standard C++ includes
+#include <algorithm>
+
+sn::EventImage::EventImage(size_t nChannels, size_t nTicks)
+  : fNChannels(nChannels)
+  , fNTicks(nTicks)
+  , fNTileChannels((nChannels + kTileChannels-1) / kTileChannels)
+  , fNTileTicks((nTicks + kTileTicks-1) / kTileTicks)
+  , fTiles(fNTileChannels*fNTileTicks)
+  , fEntries(0)
+  , fOutside(0)
+{}
+
+float* sn::EventImage::Tile(size_t tile)
+{
+  if(!fTiles[tile]){
+    fTiles[tile].reset(new float[kTileChannels*kTileTicks]);
+    std::fill(fTiles[tile].get(), fTiles[tile].get() + kTileChannels*kTileTicks, 0.f);
+  }
+  return fTiles[tile].get();
+}
+
+void sn::EventImage::Add(int channel, size_t firstTick, float const* samples, size_t n)
+{
+  if(channel < 0 || size_t(channel) >= fNChannels){ fOutside += n; return; }
+  if(firstTick >= fNTicks){ fOutside += n; return; }
+  if(firstTick + n > fNTicks){
+    fOutside += firstTick + n - fNTicks;
+    n = fNTicks - firstTick;
+  }
+
+  // the run of samples, cut at the tile edges; each piece is one row of its tile
+  const size_t tileChannel = channel / kTileChannels;
+  const size_t row = size_t(channel % kTileChannels) * kTileTicks;
+  size_t tick = firstTick;
+  const size_t lastTick = firstTick + n;
+  while(tick < lastTick){
+    const size_t tileTick = tick / kTileTicks;
+    const size_t end = std::min(lastTick, (tileTick+1)*kTileTicks);
+    float* out = Tile(TileIndex(tileChannel, tileTick)) + row + (tick - tileTick*kTileTicks);
+    float const* in = samples + (tick - firstTick);
+    for(size_t i=0; i<end-tick; i++) out[i] += in[i];
+    tick = end;
+  }
+}
+
+void sn::EventImage::AddWire(recob::Wire const& wire)
+{
+  for(auto const& roi : sn::ROIs(wire)) Add(roi);
+  fEntries += wire.NSignal();
+}
+
+void sn::EventImage::Add(EventImage const& other)
+{
+  for(size_t tile=0; tile<fTiles.size() && tile<other.fTiles.size(); tile++){
+    float const* theirs = other.fTiles[tile].get();
+    if(!theirs) continue;
+    float* mine = Tile(tile);
+    for(int cell=0; cell<kTileChannels*kTileTicks; cell++) mine[cell] += theirs[cell];
+  }
+  fEntries += other.fEntries;
+  fOutside += other.fOutside;
+}
+
+float sn::EventImage::At(int channel, size_t tick) const
+{
+  if(channel < 0 || size_t(channel) >= fNChannels || tick >= fNTicks) return 0;
+  float const* tile = TileAt(channel, tick);
+  if(!tile) return 0;
+  return tile[(channel % kTileChannels)*kTileTicks + tick % kTileTicks];
+}
+
+size_t sn::EventImage::NTilesUsed() const
+{
+  size_t n = 0;
+  for(auto const& tile : fTiles) if(tile) n++;
+  return n;
+}
+
+size_t sn::EventImage::Bytes() const
+{
+  return fTiles.size()*sizeof(fTiles[0]) + NTilesUsed()*kTileChannels*kTileTicks*sizeof(float);
+}
+
+void sn::EventImage::CopyTo(TH2F& h) const
+{
+  // bin (channel+1, tick+1) of a TH2F with fNChannels+2 bins per row, under/overflow included
+  float* content = h.GetArray();
+  const size_t nx = fNChannels+2;
+  for(size_t tc=0; tc<fNTileChannels; tc++){
+    for(size_t tt=0; tt<fNTileTicks; tt++){
+      float const* tile = fTiles[TileIndex(tc,tt)].get();
+      if(!tile) continue;
+      const size_t ch0 = tc*kTileChannels, ch1 = std::min(fNChannels, ch0+kTileChannels);
+      const size_t t0 = tt*kTileTicks, t1 = std::min(fNTicks, t0+kTileTicks);
+      for(size_t ch=ch0; ch<ch1; ch++){
+        float const* row = tile + (ch-ch0)*kTileTicks;
+        for(size_t tick=t0; tick<t1; tick++) content[(tick+1)*nx + ch+1] = row[tick-t0];
+      }
+    }
+  }
+}
+
+std::unique_ptr<TH2F> sn::EventImage::MakeTH2F(const char* name, const char* title) const
+{
+  std::unique_ptr<TH2F> h(new TH2F(name, title, fNChannels, 0, fNChannels, fNTicks, 0, fNTicks));
+  CopyTo(*h);
+  h->ResetStats();
+  h->SetEntries(fEntries);
+  return h;
+}
@@ -0,0 +1,81 @@
+//***************************
+//    channel x tick image of the wire signals, for the event displays
+//
+//    the overlay of many events is a sum of ADC values per (channel, tick) and
+//    nothing else: no fill statistics, no errors. EventImage keeps those sums
+//    as floats in tiles of 16 channels x 256 ticks (16 kB, so a tile stays in
+//    the cache while the wires of its channels are added), allocated when the
+//    first ROI lands in them. The ROIs are added straight from the wire's
+//    sparse_vector, one contiguous run of samples at a time, so the zeros
+//    between them cost nothing. The TH2F is made only when it is needed.
+//***************************
+
+#ifndef SN_EVENTIMAGE_HH
+#define SN_EVENTIMAGE_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <memory>
+
+//some ROOT includes
+#include "TH2F.h"
+
+#include "ROIView.h"
+
+namespace sn{
+
+  class EventImage{
+
+  public:
+    static constexpr int kTileChannels = 16;
+    static constexpr int kTileTicks = 256;
+
+    EventImage(size_t nChannels = 8256, size_t nTicks = 6400);
+
+    // image(channel, firstTick+i) += samples[i]; ticks past the end and unknown channels are dropped
+    void Add(int channel, size_t firstTick, float const* samples, size_t n);
+    void Add(ROIView const& roi) { Add(roi.channel, roi.firstTick, roi.samples, roi.length); }
+    // all the ROIs of a wire; counts the wire's full (zero padded) length as entries, like filling it tick by tick
+    void AddWire(recob::Wire const& wire);
+    // another image of the same size, tile by tile
+    void Add(EventImage const& other);
+
+    float At(int channel, size_t tick) const;
+
+    size_t NChannels() const { return fNChannels; }
+    size_t NTicks() const { return fNTicks; }
+    double GetEntries() const { return fEntries; }
+    size_t NOutside() const { return fOutside; }
+    size_t NTilesUsed() const;
+    size_t Bytes() const;
+
+    // the tile of (channel, tick), nullptr if nothing was added there; the channels of
+    // the tile are rows of kTileTicks floats
+    float const* TileAt(int channel, size_t tick) const {
+      return fTiles[TileIndex(channel/kTileChannels, tick/kTileTicks)].get();
+    }
+
+    // the image as a TH2F with one bin per channel and tick, booked in gDirectory;
+    // the statistics are the ones of the bin contents
+    std::unique_ptr<TH2F> MakeTH2F(const char* name, const char* title) const;
+    // copy the image into h (binned like MakeTH2F's), only where there is something;
+    // h keeps whatever it had in the tiles that are still empty
+    void CopyTo(TH2F& h) const;
+
+  private:
+    size_t TileIndex(size_t tileChannel, size_t tileTick) const { return tileChannel*fNTileTicks + tileTick; }
+    float* Tile(size_t tile);
+
+    size_t fNChannels;
+    size_t fNTicks;
+    size_t fNTileChannels;
+    size_t fNTileTicks;
+    std::vector<std::unique_ptr<float[]>> fTiles;
+    double fEntries;
+    size_t fOutside;   // samples dropped outside the image
+  };
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+//***************************
+//    read-ahead of the SN wire products
+//***************************
+
+#include "EventPrefetcher.hh"
+#include "SNMemory.hh"
+
+//"art" includes (canvas, and gallery)
+#include "gallery/Event.h"
+#include "gallery/ValidHandle.h"
+
+sn::EventPrefetcher::EventPrefetcher(std::vector<std::string> const& filenames,
+                                     art::InputTag const& wireTag, art::InputTag const& wireTagDecon,
+                                     WantFunc want, size_t depth, size_t maxBytes,
+                                     size_t firstEntry, size_t worker, size_t nWorkers)
+  : fFilenames(filenames)
+  , fWireTag(wireTag)
+  , fWireTagDecon(wireTagDecon)
+  , fWant(want)
+  , fDepth(depth < 1 ? 1 : depth)
+  , fMaxBytes(maxBytes)
+  , fFirstEntry(firstEntry)
+  , fWorker(worker)
+  , fNWorkers(nWorkers < 1 ? 1 : nWorkers)
+  , fQueuedBytes(0)
+  , fDone(false)
+  , fStop(false)
+  , fThread(&EventPrefetcher::ReadLoop, this)
+{}
+
+sn::EventPrefetcher::~EventPrefetcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStop = true;
+  }
+  fChanged.notify_all();
+  fThread.join();
+}
+
+bool sn::EventPrefetcher::Next(std::unique_ptr<PrefetchedEvent>& evt)
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+  fChanged.wait(lock, [this](){ return !fQueue.empty() || fDone; });
+
+  // what was read before the error still gets processed
+  if(fQueue.empty()){
+    if(fError) std::rethrow_exception(fError);
+    return false;
+  }
+  evt = std::move(fQueue.front());
+  fQueue.pop_front();
+  fQueuedBytes -= evt->bytes;
+  lock.unlock();
+  fChanged.notify_all();
+  return true;
+}
+
+void sn::EventPrefetcher::ReadLoop()
+{
+  try{
+    size_t entry = fFirstEntry;
+    for (gallery::Event ev(fFilenames) ; !ev.atEnd(); ev.next(), entry++) {
+
+      bool needDecon = false;
+      if(!fWant(entry, needDecon)) break;
+      if(entry % fNWorkers != fWorker) continue;
+
+      std::unique_ptr<PrefetchedEvent> evt(new PrefetchedEvent());
+      evt->entry = entry;
+      evt->run = ev.eventAuxiliary().run();
+      evt->event = ev.eventAuxiliary().event();
+      evt->wires = *ev.getValidHandle< std::vector<recob::Wire> >(fWireTag);
+      evt->hasDecon = needDecon;
+      if(needDecon)
+        evt->wires_d = *ev.getValidHandle< std::vector<recob::Wire> >(fWireTagDecon);
+      evt->bytes = WireBytes(evt->wires) + WireBytes(evt->wires_d);
+
+      // room for it? an empty queue always takes one, however big
+      std::unique_lock<std::mutex> lock(fMutex);
+      const size_t bytes = evt->bytes;
+      fChanged.wait(lock, [this,bytes](){
+          return fStop || fQueue.empty() || (fQueue.size() < fDepth && fQueuedBytes + bytes <= fMaxBytes);
+        });
+      if(fStop) break;
+      fQueuedBytes += evt->bytes;
+      fQueue.push_back(std::move(evt));
+      lock.unlock();
+      fChanged.notify_all();
+    }
+  }
+  catch(...){
+    std::lock_guard<std::mutex> lock(fMutex);
+    fError = std::current_exception();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fDone = true;
+  }
+  fChanged.notify_all();
+}
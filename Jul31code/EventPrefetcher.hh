@@ -0,0 +1,91 @@
+//***************************
+//    read-ahead of the SN wire products
+//
+//    a background thread owns the gallery::Event, reads and decodes the wires of the
+//    next events and queues them, so the disk and the decompressor keep going while
+//    the stages work on the current event. The queue holds at most 'depth' events and
+//    (one event aside) at most 'maxBytes' of wires.
+//***************************
+
+#ifndef SN_EVENTPREFETCHER_HH
+#define SN_EVENTPREFETCHER_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <stdlib.h>
+
+//"art" includes (canvas, and gallery)
+#include "canvas/Utilities/InputTag.h"
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+namespace sn{
+
+  // one event as it comes out of the queue; the wires are our own copy, gallery has moved on
+  struct PrefetchedEvent{
+    size_t entry;
+    int run;
+    int event;
+    std::vector<recob::Wire> wires;
+    std::vector<recob::Wire> wires_d;
+    bool hasDecon;
+    size_t bytes;
+  };
+
+  class EventPrefetcher{
+
+  public:
+    // want(entry, needDecon): does anybody still want this entry (false ends the read-ahead),
+    // and do they want the deconvolved wires too? Called from the background thread.
+    typedef std::function<bool(size_t, bool&)> WantFunc;
+
+    // reads entries worker, worker+nWorkers, ... of filenames; the first event of
+    // filenames is entry firstEntry
+    EventPrefetcher(std::vector<std::string> const& filenames,
+                    art::InputTag const& wireTag, art::InputTag const& wireTagDecon,
+                    WantFunc want, size_t depth, size_t maxBytes,
+                    size_t firstEntry = 0, size_t worker = 0, size_t nWorkers = 1);
+    ~EventPrefetcher();
+    EventPrefetcher(EventPrefetcher const&) = delete;
+    EventPrefetcher& operator=(EventPrefetcher const&) = delete;
+
+    // waits for the next event; false once there are none left.
+    // Whatever went wrong on the background thread is rethrown here
+    bool Next(std::unique_ptr<PrefetchedEvent>& evt);
+
+  private:
+    void ReadLoop();
+
+    std::vector<std::string> fFilenames;
+    art::InputTag fWireTag;
+    art::InputTag fWireTagDecon;
+    WantFunc fWant;
+    size_t fDepth;
+    size_t fMaxBytes;
+    size_t fFirstEntry;
+    size_t fWorker;
+    size_t fNWorkers;
+
+    std::mutex fMutex;
+    std::condition_variable fChanged;
+    std::deque< std::unique_ptr<PrefetchedEvent> > fQueue;
+    size_t fQueuedBytes;
+    bool fDone;
+    bool fStop;
+    std::exception_ptr fError;
+
+    std::thread fThread;   // last, so everything above is set up when it starts
+  };
+
+}
+
+#endif
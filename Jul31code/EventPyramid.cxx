@@ -0,0 +1,383 @@
+//***************************
+//    multi-resolution event displays
+//***************************
+
+#include "EventPyramid.hh"
+
+//some standard C++ includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+//for mmap
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+  const char kMagic[8] = { 'S','N','P','Y','R','M','\0','\1' };
+  const uint32_t kVersion = 1;
+  const int kTile = sn::EventPyramid::kTileSize;
+  const size_t kTileCells = size_t(kTile)*kTile;
+
+  struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t nLevels;
+    uint32_t nChannels;
+    uint32_t nTicks;
+    uint32_t firstLevel;   // the finer levels are not in the file
+    uint32_t unused;
+    uint64_t nEvents;
+    uint64_t eventsOffset;
+    uint64_t nTiles;
+    uint64_t indexOffset;
+  };
+
+  // cells of level 'level' over n cells of level 0
+  size_t LevelSize(size_t n, int level) { return (n + (size_t(1) << level) - 1) >> level; }
+  size_t NTilesOver(size_t n) { return (n + kTile-1) / kTile; }
+
+  // the pooled value: the one largest in magnitude, sign kept (the positive one of a tie,
+  // so the order of pooling does not matter)
+  inline float Pool(float a, float b){
+    const float fa = std::fabs(a), fb = std::fabs(b);
+    return (fb > fa || (fb == fa && b > a)) ? b : a;
+  }
+
+}
+
+//-------------------------------------------------------------------------------------------------
+// view
+
+std::unique_ptr<TH2F> sn::PyramidView::MakeTH2F(const char* name, const char* title) const
+{
+  std::unique_ptr<TH2F> h(new TH2F(name, title, nx, channelLow, channelHigh, ny, tickLow, tickHigh));
+  float* content = h->GetArray();
+  for(size_t iy=0; iy<ny; iy++)
+    std::copy(&cells[iy*nx], &cells[iy*nx] + nx, content + (iy+1)*(nx+2) + 1);
+  h->ResetStats();
+  return h;
+}
+
+//-------------------------------------------------------------------------------------------------
+// reader
+
+sn::EventPyramid::EventPyramid(std::string const& path)
+  : fPath(path)
+  , fMap(nullptr)
+  , fMapSize(0)
+  , fNEvents(0)
+  , fNChannels(0)
+  , fNTicks(0)
+  , fNLevels(0)
+  , fFirstLevel(0)
+  , fEvents(nullptr)
+  , fTiles(nullptr)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) throw std::runtime_error("EventPyramid: can't open " + path);
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)){
+    close(fd);
+    throw std::runtime_error("EventPyramid: " + path + " is too short to be a pyramid file");
+  }
+  fMapSize = st.st_size;
+  fMap = mmap(nullptr, fMapSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);   // the mapping keeps the file
+  if(fMap == MAP_FAILED){
+    fMap = nullptr;
+    throw std::runtime_error("EventPyramid: can't map " + path);
+  }
+
+  char const* base = static_cast<char const*>(fMap);
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if(std::memcmp(header.magic, kMagic, 8) != 0 || header.version != kVersion){
+    munmap(fMap, fMapSize);
+    throw std::runtime_error("EventPyramid: " + path + " is not a version " + std::to_string(kVersion) + " pyramid file");
+  }
+  if(header.eventsOffset + header.nEvents*sizeof(EventEntry) > fMapSize
+     || header.indexOffset + header.nTiles*sizeof(TileEntry) > fMapSize
+     || header.eventsOffset % alignof(EventEntry) != 0 || header.indexOffset % alignof(TileEntry) != 0){
+    munmap(fMap, fMapSize);
+    throw std::runtime_error("EventPyramid: " + path + " is truncated (not closed?)");
+  }
+  fNEvents = header.nEvents;
+  fNChannels = header.nChannels;
+  fNTicks = header.nTicks;
+  fNLevels = header.nLevels;
+  fFirstLevel = std::min<int>(header.firstLevel, fNLevels-1);
+  fEvents = reinterpret_cast<EventEntry const*>(base + header.eventsOffset);
+  fTiles = reinterpret_cast<TileEntry const*>(base + header.indexOffset);
+}
+
+sn::EventPyramid::~EventPyramid()
+{
+  if(fMap) munmap(fMap, fMapSize);
+}
+
+sn::EventPyramid::TileEntry const* sn::EventPyramid::FindTile(size_t entry, int level, size_t tileChannel, size_t tileTick) const
+{
+  TileEntry const* first = fTiles + fEvents[entry].firstTile;
+  TileEntry const* last = first + fEvents[entry].nTiles;
+  auto before = [](TileEntry const& a, TileEntry const& b){
+    if(a.level != b.level) return a.level < b.level;
+    if(a.tileChannel != b.tileChannel) return a.tileChannel < b.tileChannel;
+    return a.tileTick < b.tileTick;
+  };
+  TileEntry key{ uint16_t(level), uint16_t(tileChannel), uint16_t(tileTick), 0, 0, 0 };
+  TileEntry const* it = std::lower_bound(first, last, key, before);
+  if(it == last || before(key, *it)) return nullptr;
+  return it;
+}
+
+int sn::EventPyramid::ChooseLevel(size_t channelLow, size_t channelHigh, size_t tickLow, size_t tickHigh,
+                                  size_t maxX, size_t maxY) const
+{
+  for(int level=fFirstLevel; level<fNLevels; level++){
+    if(LevelSize(channelHigh, level) - (channelLow >> level) <= maxX
+       && LevelSize(tickHigh, level) - (tickLow >> level) <= maxY)
+      return level;
+  }
+  return fNLevels-1;
+}
+
+sn::PyramidView sn::EventPyramid::Read(size_t entry, size_t channelLow, size_t channelHigh,
+                                       size_t tickLow, size_t tickHigh, size_t maxX, size_t maxY) const
+{
+  if(entry >= fNEvents)
+    throw std::runtime_error("EventPyramid: no entry " + std::to_string(entry) + " in " + fPath);
+  channelHigh = std::min(std::max(channelHigh, channelLow+1), fNChannels);
+  tickHigh = std::min(std::max(tickHigh, tickLow+1), fNTicks);
+  channelLow = std::min(channelLow, channelHigh-1);
+  tickLow = std::min(tickLow, tickHigh-1);
+
+  PyramidView view;
+  view.entry = entry;
+  view.run = Run(entry);
+  view.event = Event(entry);
+  view.level = ChooseLevel(channelLow, channelHigh, tickLow, tickHigh, maxX, maxY);
+
+  // the whole cells of the level over the range
+  const int level = view.level;
+  const size_t x0 = channelLow >> level, x1 = LevelSize(channelHigh, level);
+  const size_t y0 = tickLow >> level, y1 = LevelSize(tickHigh, level);
+  view.channelLow = x0 << level;
+  view.channelHigh = x1 << level;
+  view.tickLow = y0 << level;
+  view.tickHigh = y1 << level;
+  view.nx = x1 - x0;
+  view.ny = y1 - y0;
+  view.cells.assign(view.nx*view.ny, 0.f);
+
+  // only the tiles over the range
+  char const* base = static_cast<char const*>(fMap);
+  for(size_t tc = x0/kTile; tc <= (x1-1)/kTile; tc++){
+    for(size_t tt = y0/kTile; tt <= (y1-1)/kTile; tt++){
+      TileEntry const* tile = FindTile(entry, level, tc, tt);
+      if(!tile) continue;
+      if(tile->offset + tile->bytes > fMapSize)
+        throw std::runtime_error("EventPyramid: tile of entry " + std::to_string(entry) + " of " + fPath + " is damaged");
+
+      char const* p = base + tile->offset;
+      char const* end = p + tile->bytes;
+      size_t cell = 0;
+      while(p + 2*sizeof(uint16_t) <= end){
+        uint16_t run[2];
+        std::memcpy(run, p, sizeof(run));
+        p += sizeof(run);
+        cell += run[0];
+        if(cell + run[1] > kTileCells || p + run[1]*sizeof(float) > end)
+          throw std::runtime_error("EventPyramid: tile of entry " + std::to_string(entry) + " of " + fPath + " is damaged");
+        for(size_t k=0; k<run[1]; k++, cell++, p += sizeof(float)){
+          const size_t x = tc*kTile + cell/kTile;
+          const size_t y = tt*kTile + cell%kTile;
+          if(x < x0 || x >= x1 || y < y0 || y >= y1) continue;
+          std::memcpy(&view.cells[(y-y0)*view.nx + (x-x0)], p, sizeof(float));
+        }
+      }
+    }
+  }
+  return view;
+}
+
+//-------------------------------------------------------------------------------------------------
+// writer
+
+sn::EventPyramidWriter::EventPyramidWriter(std::string const& path, size_t nChannels, size_t nTicks, int firstLevel)
+  : fPath(path)
+  , fFile(nullptr)
+  , fNChannels(nChannels)
+  , fNTicks(nTicks)
+  , fNLevels(1)
+  , fFirstLevel(firstLevel)
+  , fOffset(sizeof(FileHeader))
+{
+  // down to a single tile
+  while(LevelSize(nChannels, fNLevels-1) > size_t(kTile) || LevelSize(nTicks, fNLevels-1) > size_t(kTile)) fNLevels++;
+  fFirstLevel = std::max(0, std::min(fFirstLevel, fNLevels-1));
+  fLevels.resize(fNLevels);
+  for(int level=0; level<fNLevels; level++){
+    fLevels[level].nTileChannels = NTilesOver(LevelSize(nChannels, level));
+    fLevels[level].nTileTicks = NTilesOver(LevelSize(nTicks, level));
+    if(level < fFirstLevel) continue;   // never made
+    fLevels[level].tiles.resize(fLevels[level].nTileChannels*fLevels[level].nTileTicks);
+    fLevels[level].used.resize(fLevels[level].tiles.size());
+  }
+
+  fFile = std::fopen(path.c_str(), "wb");
+  if(!fFile) throw std::runtime_error("EventPyramidWriter: can't open " + path);
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));   // written for real in Close()
+  std::fwrite(&header, sizeof(header), 1, fFile);
+}
+
+sn::EventPyramidWriter::~EventPyramidWriter()
+{
+  if(fFile) std::fclose(fFile);
+}
+
+void sn::EventPyramidWriter::AddEvent(int run, int event, EventImage const& image)
+{
+  if(image.NChannels() != fNChannels || image.NTicks() != fNTicks)
+    throw std::runtime_error("EventPyramidWriter: the image is not " + std::to_string(fNChannels) + " x " + std::to_string(fNTicks));
+  if(!fFile) throw std::runtime_error("EventPyramidWriter: " + fPath + " is closed already");
+
+  EventPyramid::EventEntry entry{ uint32_t(run), uint32_t(event), fIndex.size(), 0 };
+  for(auto& level : fLevels) std::fill(level.used.begin(), level.used.end(), 0);
+
+  // the first level written, straight from the rows of the image tiles (256 ticks, as
+  // ours): 2^first x 2^first cells of level 0 into one. The pooled value does not depend
+  // on the order, so this is what pooling level after level would give
+  static_assert(EventImage::kTileTicks == EventPyramid::kTileSize, "image and pyramid tiles have to be as long");
+  const int first = fFirstLevel;
+  Level& top = fLevels[first];
+  for(size_t channel=0; channel<fNChannels; channel+=EventImage::kTileChannels){
+    for(size_t tick=0; tick<fNTicks; tick+=kTile){
+      float const* rows = image.TileAt(channel, tick);
+      if(!rows) continue;
+      const size_t y = tick >> first;   // the image tile stays within one of our tiles
+      const size_t nRows = std::min<size_t>(EventImage::kTileChannels, fNChannels - channel);
+      for(size_t r=0; r<nRows; r++){
+        const size_t x = (channel + r) >> first;
+        float* out = UseTile(top, x/kTile, y/kTile) + (x%kTile)*kTile + y%kTile;
+        float const* in = rows + r*kTile;
+        if(first == 0) std::copy(in, in + kTile, out);
+        else for(int t=0; t<kTile; t++) out[t >> first] = Pool(out[t >> first], in[t]);
+      }
+    }
+  }
+
+  // every coarser level from the one below, 2x2 cells into one
+  for(int level=first+1; level<fNLevels; level++){
+    Level const& below = fLevels[level-1];
+    Level& here = fLevels[level];
+    for(size_t tc=0; tc<here.nTileChannels; tc++){
+      for(size_t tt=0; tt<here.nTileTicks; tt++){
+        for(int dc=0; dc<2; dc++){
+          for(int dt=0; dt<2; dt++){
+            const size_t bc = 2*tc + dc, bt = 2*tt + dt;
+            if(bc >= below.nTileChannels || bt >= below.nTileTicks) continue;
+            const size_t child = bc*below.nTileTicks + bt;
+            if(!below.used[child]) continue;
+            float const* in0 = below.tiles[child].get();
+            float* quarter = UseTile(here, tc, tt) + size_t(dc*kTile/2)*kTile + dt*kTile/2;
+            for(int c=0; c<kTile; c++){
+              float* out = quarter + size_t(c/2)*kTile;
+              float const* in = in0 + size_t(c)*kTile;
+              for(int t=0; t<kTile; t++) out[t/2] = Pool(out[t/2], in[t]);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for(int level=first; level<fNLevels; level++){
+    Level const& here = fLevels[level];
+    for(size_t tc=0; tc<here.nTileChannels; tc++)
+      for(size_t tt=0; tt<here.nTileTicks; tt++)
+        if(here.used[tc*here.nTileTicks + tt]) WriteTile(level, tc, tt, here.tiles[tc*here.nTileTicks + tt].get());
+  }
+
+  entry.nTiles = fIndex.size() - entry.firstTile;
+  fEvents.push_back(entry);
+}
+
+float* sn::EventPyramidWriter::UseTile(Level& level, size_t tileChannel, size_t tileTick)
+{
+  const size_t i = tileChannel*level.nTileTicks + tileTick;
+  std::unique_ptr<float[]>& tile = level.tiles[i];
+  if(!level.used[i]){
+    if(!tile) tile.reset(new float[kTileCells]);
+    std::fill(tile.get(), tile.get() + kTileCells, 0.f);
+    level.used[i] = 1;
+  }
+  return tile.get();
+}
+
+void sn::EventPyramidWriter::WriteTile(int level, size_t tileChannel, size_t tileTick, float const* cells)
+{
+  // runs of non-zero cells behind the number of zeros before them
+  fBuffer.clear();
+  size_t cell = 0;
+  while(cell < kTileCells){
+    size_t first = cell;
+    while(first < kTileCells && cells[first] == 0) first++;
+    if(first == kTileCells) break;
+    size_t last = first;
+    while(last < kTileCells && last - first < 0xffff && cells[last] != 0) last++;
+
+    const uint16_t run[2] = { uint16_t(first - cell), uint16_t(last - first) };
+    const size_t at = fBuffer.size();
+    fBuffer.resize(at + sizeof(run) + (last-first)*sizeof(float));
+    std::memcpy(&fBuffer[at], run, sizeof(run));
+    std::memcpy(&fBuffer[at + sizeof(run)], cells + first, (last-first)*sizeof(float));
+    cell = last;
+  }
+  if(fBuffer.empty()) return;   // all zeros after all
+
+  if(std::fwrite(fBuffer.data(), 1, fBuffer.size(), fFile) != fBuffer.size())
+    throw std::runtime_error("EventPyramidWriter: error writing " + fPath);
+  fIndex.push_back(EventPyramid::TileEntry{ uint16_t(level), uint16_t(tileChannel), uint16_t(tileTick), 0,
+                                            uint32_t(fBuffer.size()), fOffset });
+  fOffset += fBuffer.size();
+}
+
+void sn::EventPyramidWriter::Close()
+{
+  if(!fFile) return;
+
+  // the events and the index behind the tiles, 8 byte aligned, then the header
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, 8);
+  header.version = kVersion;
+  header.nLevels = fNLevels;
+  header.firstLevel = fFirstLevel;
+  header.unused = 0;
+  header.nChannels = fNChannels;
+  header.nTicks = fNTicks;
+  header.nEvents = fEvents.size();
+  header.nTiles = fIndex.size();
+
+  const char zeros[8] = {0};
+  const uint64_t aligned = (fOffset + 7)/8*8;
+  std::fwrite(zeros, 1, aligned - fOffset, fFile);
+  header.eventsOffset = aligned;
+  std::fwrite(fEvents.data(), sizeof(EventPyramid::EventEntry), fEvents.size(), fFile);
+  header.indexOffset = aligned + fEvents.size()*sizeof(EventPyramid::EventEntry);
+  std::fwrite(fIndex.data(), sizeof(EventPyramid::TileEntry), fIndex.size(), fFile);
+
+  std::fseek(fFile, 0, SEEK_SET);
+  std::fwrite(&header, sizeof(header), 1, fFile);
+
+  const bool failed = std::ferror(fFile);
+  std::fclose(fFile);
+  fFile = nullptr;
+  for(auto& level : fLevels) for(auto& tile : level.tiles) tile.reset();
+  if(failed) throw std::runtime_error("EventPyramidWriter: error writing " + fPath);
+}
@@ -0,0 +1,170 @@
+//***************************
+//    multi-resolution event displays
+//
+//    the display of one event is an 8256 x 6400 image; drawing it from a TCanvas
+//    in a ROOT file means reading and decompressing all of it, even to look at a
+//    corner or at the whole detector on a screen of 1000 pixels. EventPyramidWriter
+//    stores every event as a pyramid of images: level 0 is one cell per channel and
+//    tick, level L pools 2^L x 2^L cells of level 0 into one (the value largest in
+//    magnitude, so the tracks and the negative lobes of the deconvolved wires stay
+//    visible). Every level is cut into tiles of 256 x 256 cells, and only the tiles
+//    with something in them are written, as runs of non-zero cells.
+//
+//    file layout (byte order of the writing host):
+//      header                        magic, version, image size, levels (the finest one written) and events
+//      tiles                         one after the other, in the order they were written
+//      events[nEvents]               run, event, and its tiles in the index
+//      index[nTiles]                 level, tile channel, tile tick, offset and size of each tile,
+//                                    sorted by (level, channel, tick) within every event
+//    a tile is runs of { uint16 zeros skipped, uint16 n, float cells[n] } over its
+//    cells, channel after channel, 256 ticks each.
+//
+//    EventPyramid maps the file and reads the cells of a channel x tick range at the
+//    coarsest level that still has the resolution asked for, from the tiles in that
+//    range only.
+//***************************
+
+#ifndef SN_EVENTPYRAMID_HH
+#define SN_EVENTPYRAMID_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <stdint.h>
+
+//some ROOT includes
+#include "TH2F.h"
+
+#include "EventImage.hh"
+
+namespace sn{
+
+  // the cells of a channel x tick range at one level of the pyramid
+  struct PyramidView{
+    size_t entry = 0;
+    int run = 0;
+    int event = 0;
+    int level = 0;
+    size_t channelLow = 0, channelHigh = 0;   // the range covered, in channels and ticks
+    size_t tickLow = 0, tickHigh = 0;         // (level 0 units, whole cells of the level)
+    size_t nx = 0, ny = 0;                    // cells across the channels and the ticks
+    std::vector<float> cells;                 // cells[iy*nx + ix]
+
+    // a TH2F of the cells, booked in gDirectory
+    std::unique_ptr<TH2F> MakeTH2F(const char* name, const char* title) const;
+  };
+
+  class EventPyramid{
+
+  public:
+    static constexpr int kTileSize = 256;
+
+    // the index of the file, as it is on disk
+    struct EventEntry{
+      uint32_t run;
+      uint32_t event;
+      uint64_t firstTile;
+      uint64_t nTiles;
+    };
+    struct TileEntry{
+      uint16_t level;
+      uint16_t tileChannel;
+      uint16_t tileTick;
+      uint16_t pad;
+      uint32_t bytes;
+      uint64_t offset;
+    };
+
+    explicit EventPyramid(std::string const& path);   // throws std::runtime_error if it is not a pyramid file
+    ~EventPyramid();
+    EventPyramid(EventPyramid const&) = delete;
+    EventPyramid& operator=(EventPyramid const&) = delete;
+
+    size_t NEvents() const { return fNEvents; }
+    int Run(size_t entry) const { return fEvents[entry].run; }
+    int Event(size_t entry) const { return fEvents[entry].event; }
+    size_t NChannels() const { return fNChannels; }
+    size_t NTicks() const { return fNTicks; }
+    int NLevels() const { return fNLevels; }
+    int FirstLevel() const { return fFirstLevel; }
+
+    // the finest level with no more than maxX x maxY cells over the range (the coarsest if none has;
+    // never one finer than FirstLevel)
+    int ChooseLevel(size_t channelLow, size_t channelHigh, size_t tickLow, size_t tickHigh,
+                    size_t maxX, size_t maxY) const;
+
+    // the cells of [channelLow,channelHigh) x [tickLow,tickHigh) of one event at that level;
+    // const and without state, so a prefetch thread can read the next event meanwhile
+    PyramidView Read(size_t entry, size_t channelLow, size_t channelHigh, size_t tickLow, size_t tickHigh,
+                     size_t maxX, size_t maxY) const;
+
+    // the tiles stored for one event, all levels
+    size_t NTiles(size_t entry) const { return fEvents[entry].nTiles; }
+
+  private:
+    // the index entry of one tile, nullptr if it is empty
+    TileEntry const* FindTile(size_t entry, int level, size_t tileChannel, size_t tileTick) const;
+
+    std::string fPath;
+    void* fMap;
+    size_t fMapSize;
+    size_t fNEvents;
+    size_t fNChannels;
+    size_t fNTicks;
+    int fNLevels;
+    int fFirstLevel;
+    EventEntry const* fEvents;
+    TileEntry const* fTiles;
+  };
+
+  // writes one pyramid per event; the index goes at the end in Close()
+  class EventPyramidWriter{
+
+  public:
+    // the levels finer than firstLevel are left out (a level 3 pyramid of 8256 x 6400 is about
+    // a screen full, for the animation frames)
+    EventPyramidWriter(std::string const& path, size_t nChannels = 8256, size_t nTicks = 6400, int firstLevel = 0);
+    ~EventPyramidWriter();
+    EventPyramidWriter(EventPyramidWriter const&) = delete;
+    EventPyramidWriter& operator=(EventPyramidWriter const&) = delete;
+
+    // the image has to be nChannels x nTicks
+    void AddEvent(int run, int event, EventImage const& image);
+
+    void Close();
+
+    size_t NEvents() const { return fEvents.size(); }
+    size_t NTiles() const { return fIndex.size(); }
+    size_t Bytes() const { return fOffset; }
+
+  private:
+    // the tiles of one level; their buffers are kept from one event to the next, 'used' says
+    // which of them the event being written has. Levels finer than fFirstLevel have none
+    struct Level{
+      size_t nTileChannels, nTileTicks;
+      std::vector<std::unique_ptr<float[]>> tiles;
+      std::vector<char> used;
+    };
+
+    // the tile to pool into, zeroed when the event first uses it
+    float* UseTile(Level& level, size_t tileChannel, size_t tileTick);
+    void WriteTile(int level, size_t tileChannel, size_t tileTick, float const* cells);
+
+    std::string fPath;
+    std::FILE* fFile;
+    size_t fNChannels;
+    size_t fNTicks;
+    int fNLevels;
+    int fFirstLevel;
+    uint64_t fOffset;
+    std::vector<Level> fLevels;   // of the event being written, reused
+    std::vector<char> fBuffer;
+    std::vector<EventPyramid::EventEntry> fEvents;
+    std::vector<EventPyramid::TileEntry> fIndex;
+  };
+
+}
+
+#endif
@@ -0,0 +1,233 @@
+//***************************
+//    histogram fills and counter sums of one chunk of wires
+//
+//    when the wires of an event are split over threads, nobody may touch the
+//    shared histograms while the event is running: every chunk fills into its
+//    own buffer instead, and the buffers are replayed in channel order once the
+//    event is done, so the histograms see exactly the fills of a serial run.
+//    A direct buffer (one chunk, no threads) flushes whenever kBatch fills have
+//    piled up.
+//
+//    The bin of a TH1/TH2 fill is found when the fill is made, on the chunk's
+//    own thread (the axes are only read). The replay goes histogram by
+//    histogram: the fills are grouped by target (keeping their order within
+//    each), and every TH1/TH2 gets AddBinContent on the found bins with its
+//    sumw2, statistics and entries kept the way TH1::FillN keeps them. A sparse
+//    TH2 gets one SparseHist2D::FillN. A histogram only ever sees its own fills
+//    in their own order, so the contents come out the same. Histograms whose
+//    axes can grow have their bins found at the replay, by FillN.
+//***************************
+
+#ifndef SN_FILLBUFFER_H
+#define SN_FILLBUFFER_H
+
+#include <vector>
+
+//some ROOT includes
+#include "TH1.h"
+#include "TH2.h"
+#include "TAxis.h"
+#include "TArrayD.h"
+
+#include "SparseHist2D.hh"
+#include "ChannelStats.hh"
+#include "QuantileSketch.hh"
+#include "SNMetrics.hh"
+
+namespace sn{
+
+  class FillBuffer{
+
+  public:
+    // how many fills a direct buffer holds on to
+    static constexpr size_t kBatch = 1 << 14;
+
+    explicit FillBuffer(bool direct = false) : fDirect(direct) {}
+
+    // h.Fill(x)
+    void Fill(TH1& h, double x){
+      Push(TH1Entry(h,x,1));   // Fill(x) is Fill(x,1) on a TH1
+    }
+
+    // h.Fill(x,y): (x,y) for a TH2, (x,weight) for a TH1, same as calling it directly
+    void Fill(TH1& h, double x, double y){
+      Push(TH1Entry(h,x,y));
+    }
+
+    // h.Fill(x,y) on a sparse TH2
+    template<typename T, typename TH2Type>
+    void Fill(SparseTH2<T,TH2Type>& h, double x, double y){
+      Push(Entry{kSparse,static_cast<SparseHist2D*>(&h),x,y,-1,false});
+    }
+
+    // s.Fill(channel,v)
+    void Fill(ChannelStats& s, int channel, double v){
+      Push(Entry{kStats,&s,double(channel),v,-1,false});
+    }
+
+    // q.Fill(channel,v)
+    void Fill(ChannelQuantiles& q, int channel, double v){
+      Push(Entry{kQuantiles,&q,double(channel),v,-1,false});
+    }
+
+    // sum += value
+    void Add(double& sum, double value){
+      if(fDirect){ sum += value; return; }
+      fSums.push_back(Sum{&sum,value});
+    }
+
+    // replay everything, each histogram in the order its fills came in
+    void Flush(){
+      ScopedTimer timer(kFill);
+      GroupByTarget();
+      for(auto const& g : fGroups){
+        double const* x = fX.data() + g.first;
+        double const* y = fY.data() + g.first;
+        switch(g.kind){
+        case kTH1:{
+          TH1* h = static_cast<TH1*>(g.target);
+          if(fBin[g.first] >= 0) FillBins(*h, g.n, x, y, fBin.data() + g.first, fInRange.data() + g.first);
+          else if(h->GetDimension() == 1) h->FillN(g.n, x, y);   // y are the weights
+          else static_cast<TH2*>(h)->FillN(g.n, x, y, nullptr);
+          break;
+        }
+        case kSparse:
+          static_cast<SparseHist2D*>(g.target)->FillN(g.n, x, y);
+          break;
+        case kStats:
+          for(size_t i=0; i<g.n; i++) static_cast<ChannelStats*>(g.target)->Fill(int(x[i]),y[i]);
+          break;
+        case kQuantiles:
+          for(size_t i=0; i<g.n; i++) static_cast<ChannelQuantiles*>(g.target)->Fill(int(x[i]),y[i]);
+          break;
+        }
+      }
+      for(auto const& s : fSums) *s.sum += s.value;
+      fFills.clear();
+      fSums.clear();
+    }
+
+    size_t size() const { return fFills.size() + fSums.size(); }
+
+  private:
+    // what target points to, and so which FillN to replay into
+    enum Kind { kTH1, kSparse, kStats, kQuantiles };
+    struct Entry{
+      Kind kind;
+      void* target;
+      double x;
+      double y;
+      int bin;        // global bin of a TH1/TH2 fill, -1 if found at the replay
+      bool inRange;   // not in an under/overflow bin: counted in the statistics
+    };
+    struct Sum{
+      double* sum;
+      double value;
+    };
+    // the fills of one target, at [first,first+n) of fX/fY
+    struct Group{
+      Kind kind;
+      void* target;
+      size_t first;
+      size_t n;
+    };
+
+    // the bin of h.Fill(x,y), as TH1::Fill/TH2::Fill would find it
+    static Entry TH1Entry(TH1& h, double x, double y){
+      Entry e{kTH1,&h,x,y,-1,false};
+      TAxis const* xaxis = h.GetXaxis();
+      if(xaxis->CanExtend()) return e;
+      const int binx = xaxis->FindFixBin(x);
+      e.inRange = binx > 0 && binx <= xaxis->GetNbins();
+      if(h.GetDimension() == 1){
+        e.bin = binx;
+        return e;
+      }
+      TAxis const* yaxis = h.GetYaxis();
+      if(yaxis->CanExtend()) return e;
+      const int biny = yaxis->FindFixBin(y);
+      e.inRange = e.inRange && biny > 0 && biny <= yaxis->GetNbins();
+      e.bin = h.GetBin(binx, biny);
+      return e;
+    }
+
+    // what TH1::FillN (x, weights y) or TH2::FillN (x, y, weight 1) does, on bins already found
+    static void FillBins(TH1& h, size_t n, double const* x, double const* y, int const* bin, char const* inRange){
+      const bool twoD = h.GetDimension() == 2;
+      const bool statOverflows = TH1::GetStatOverflows();
+      double stats[TH1::kNstat] = {};
+      h.GetStats(stats);
+      for(size_t i=0; i<n; i++){
+        const double w = twoD ? 1 : y[i];
+        if(!h.GetSumw2N() && w != 1 && !h.TestBit(TH1::kIsNotW)) h.Sumw2();
+        if(h.GetSumw2N()) h.GetSumw2()->fArray[bin[i]] += w*w;
+        h.AddBinContent(bin[i], w);
+        if(!inRange[i] && !statOverflows) continue;
+        stats[0] += w;
+        stats[1] += w*w;
+        stats[2] += w*x[i];
+        stats[3] += w*x[i]*x[i];
+        if(twoD){
+          stats[4] += w*y[i];
+          stats[5] += w*y[i]*y[i];
+          stats[6] += w*x[i]*y[i];
+        }
+      }
+      h.PutStats(stats);
+      h.SetEntries(h.GetEntries() + n);
+    }
+
+    void Push(Entry const& e){
+      fFills.push_back(e);
+      if(fDirect && fFills.size() >= kBatch) Flush();
+    }
+
+    // sort the fills into fX/fY by target, stably; an analysis has a handful of
+    // histograms and fills them in runs, so the last one found is tried first
+    void GroupByTarget(){
+      fGroups.clear();
+      fGroupOf.resize(fFills.size());
+      size_t last = 0;
+      for(size_t i=0; i<fFills.size(); i++){
+        void* target = fFills[i].target;
+        size_t g = last;
+        if(g >= fGroups.size() || fGroups[g].target != target){
+          for(g=0; g<fGroups.size() && fGroups[g].target != target; g++);
+          if(g == fGroups.size()) fGroups.push_back(Group{fFills[i].kind, target, 0, 0});
+        }
+        fGroups[g].n++;
+        fGroupOf[i] = g;
+        last = g;
+      }
+
+      size_t first = 0;
+      for(auto& g : fGroups){ g.first = first; first += g.n; g.n = 0; }
+      fX.resize(first);
+      fY.resize(first);
+      fBin.resize(first);
+      fInRange.resize(first);
+      for(size_t i=0; i<fFills.size(); i++){
+        Group& g = fGroups[fGroupOf[i]];
+        fX[g.first + g.n] = fFills[i].x;
+        fY[g.first + g.n] = fFills[i].y;
+        fBin[g.first + g.n] = fFills[i].bin;
+        fInRange[g.first + g.n] = fFills[i].inRange;
+        g.n++;
+      }
+    }
+
+    bool fDirect;
+    std::vector<Entry> fFills;
+    std::vector<Sum> fSums;
+
+    // scratch of Flush, kept to save the allocations
+    std::vector<Group> fGroups;
+    std::vector<size_t> fGroupOf;
+    std::vector<double> fX, fY;
+    std::vector<int> fBin;
+    std::vector<char> fInRange;
+  };
+
+}
+
+#endif
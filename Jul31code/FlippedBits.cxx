@@ -0,0 +1,132 @@
+//***************************
+//    flipped bit search: second difference of an ROI against a threshold
+//
+//    8 ticks at a time with AVX2, 4 with SSE2 (always there on x86-64), one at a time
+//    for the tail and on anything else; twice that on int16 samples.
+//***************************
+
+#include "FlippedBits.hh"
+
+//some standard C++ includes
+#include <cmath>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+  // the scalar version, for the ticks the vectors don't cover: same float arithmetic
+  inline bool Over(float const* s, size_t t, float threshold){
+    const float difftoint = s[t] - (( s[t+1] + s[t-1] )/2);
+    return difftoint > threshold;
+  }
+
+#if defined(__AVX2__)
+  const size_t kWidth = 8;
+  // bit j set if tick t+j is over threshold; (a+b)*0.5 is exactly (a+b)/2
+  inline unsigned OverMask(float const* s, size_t t, float threshold){
+    const __m256 prev = _mm256_loadu_ps(s + t - 1);
+    const __m256 cur  = _mm256_loadu_ps(s + t);
+    const __m256 next = _mm256_loadu_ps(s + t + 1);
+    const __m256 diff = _mm256_sub_ps(cur, _mm256_mul_ps(_mm256_add_ps(next, prev), _mm256_set1_ps(0.5f)));
+    return _mm256_movemask_ps(_mm256_cmp_ps(diff, _mm256_set1_ps(threshold), _CMP_GT_OQ));
+  }
+#elif defined(__SSE2__)
+  const size_t kWidth = 4;
+  inline unsigned OverMask(float const* s, size_t t, float threshold){
+    const __m128 prev = _mm_loadu_ps(s + t - 1);
+    const __m128 cur  = _mm_loadu_ps(s + t);
+    const __m128 next = _mm_loadu_ps(s + t + 1);
+    const __m128 diff = _mm_sub_ps(cur, _mm_mul_ps(_mm_add_ps(next, prev), _mm_set1_ps(0.5f)));
+    return _mm_movemask_ps(_mm_cmpgt_ps(diff, _mm_set1_ps(threshold)));
+  }
+#else
+  const size_t kWidth = 1;
+  inline unsigned OverMask(float const* s, size_t t, float threshold){
+    return Over(s, t, threshold) ? 1u : 0u;
+  }
+#endif
+
+  // int16: s[t] - (s[t+1] + s[t-1])/2 > threshold is 2*s[t] - s[t+1] - s[t-1] > floor(2*threshold)
+  // for whole numbers, and with |s| <= 8192 none of it overflows 16 bits
+  inline int Limit16(float threshold){
+    const float limit = std::floor(2*threshold);
+    return limit > 32767 ? 32767 : (limit < -32768 ? -32768 : int(limit));
+  }
+
+  inline bool Over16(int16_t const* s, size_t t, int limit){
+    return 2*s[t] - s[t+1] - s[t-1] > limit;
+  }
+
+#if defined(__AVX2__)
+  const size_t kWidth16 = 16;
+  inline unsigned OverMask16(int16_t const* s, size_t t, int limit){
+    const __m256i prev = _mm256_loadu_si256((__m256i const*)(s + t - 1));
+    const __m256i cur  = _mm256_loadu_si256((__m256i const*)(s + t));
+    const __m256i next = _mm256_loadu_si256((__m256i const*)(s + t + 1));
+    const __m256i diff = _mm256_sub_epi16(_mm256_add_epi16(cur, cur), _mm256_add_epi16(next, prev));
+    return _mm256_movemask_epi8(_mm256_cmpgt_epi16(diff, _mm256_set1_epi16(limit)));
+  }
+#elif defined(__SSE2__)
+  const size_t kWidth16 = 8;
+  inline unsigned OverMask16(int16_t const* s, size_t t, int limit){
+    const __m128i prev = _mm_loadu_si128((__m128i const*)(s + t - 1));
+    const __m128i cur  = _mm_loadu_si128((__m128i const*)(s + t));
+    const __m128i next = _mm_loadu_si128((__m128i const*)(s + t + 1));
+    const __m128i diff = _mm_sub_epi16(_mm_add_epi16(cur, cur), _mm_add_epi16(next, prev));
+    return _mm_movemask_epi8(_mm_cmpgt_epi16(diff, _mm_set1_epi16(limit)));
+  }
+#else
+  const size_t kWidth16 = 1;
+  inline unsigned OverMask16(int16_t const* s, size_t t, int limit){
+    return Over16(s, t, limit) ? 1u : 0u;
+  }
+#endif
+
+}
+
+bool sn::HasFlippedBit(float const* samples, size_t length, float threshold)
+{
+  const size_t nTicks = FlippedBitTicks(length);
+  size_t k = 0;   // ticks 1 ... nTicks, reading one sample either side
+  for(; k + kWidth <= nTicks; k += kWidth)
+    if(OverMask(samples, k+1, threshold)) return true;
+  for(; k < nTicks; k++)
+    if(Over(samples, k+1, threshold)) return true;
+  return false;
+}
+
+bool sn::HasFlippedBit(int16_t const* samples, size_t length, float threshold)
+{
+  const size_t nTicks = FlippedBitTicks(length);
+  const int limit = Limit16(threshold);
+  size_t k = 0;
+  for(; k + kWidth16 <= nTicks; k += kWidth16)
+    if(OverMask16(samples, k+1, limit)) return true;
+  for(; k < nTicks; k++)
+    if(Over16(samples, k+1, limit)) return true;
+  return false;
+}
+
+size_t sn::FlippedBitMask(float const* samples, size_t length, std::vector<uint64_t>& mask, float threshold)
+{
+  const size_t nTicks = FlippedBitTicks(length);
+  mask.assign((nTicks + 63)/64, 0);
+
+  // kWidth divides 64, so a vector's bits never straddle two words
+  size_t nOver = 0;
+  size_t k = 0;
+  for(; k + kWidth <= nTicks; k += kWidth){
+    const uint64_t bits = OverMask(samples, k+1, threshold);
+    if(!bits) continue;
+    mask[k/64] |= bits << (k%64);
+    nOver += __builtin_popcountll(bits);
+  }
+  for(; k < nTicks; k++){
+    if(!Over(samples, k+1, threshold)) continue;
+    mask[k/64] |= uint64_t(1) << (k%64);
+    nOver++;
+  }
+  return nOver;
+}
@@ -0,0 +1,39 @@
+//***************************
+//    flipped bit search: second difference of an ROI against a threshold
+//
+//    a sample is a flipped bit candidate when it sticks out of the interpolation of
+//    its neighbours, ROI[t] - (ROI[t+1] + ROI[t-1])/2 > threshold, for every tick t
+//    but the first and the last two (as in flippingbit). The sums are done in float,
+//    like the scalar loop they replace, so the answers are the same.
+//***************************
+
+#ifndef SN_FLIPPEDBITS_HH
+#define SN_FLIPPEDBITS_HH
+
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace sn{
+
+  const float kFlippedBitThreshold = 32;   // our metric of flipped bit is a difference of more than 32
+
+  // number of ticks checked in an ROI of 'length' samples
+  inline size_t FlippedBitTicks(size_t length) { return length > 2 ? length - 2 : 0; }
+
+  // is there any flipped bit in samples[0] ... samples[length-1]? Stops at the first one
+  bool HasFlippedBit(float const* samples, size_t length, float threshold = kFlippedBitThreshold);
+
+  // the same on int16 ADC counts (RawROIStore), twice the ticks per vector: 2*s[t] - s[t+1] - s[t-1]
+  // against 2*threshold, in integers. Exact, and the same answer as the float version, as long as
+  // all samples are within [-8192,8191] (RawROIStore::Narrow())
+  bool HasFlippedBit(int16_t const* samples, size_t length, float threshold = kFlippedBitThreshold);
+
+  // all of them: bit k of mask (word k/64, bit k%64) is set when tick k+1 of the ROI is over
+  // threshold. mask is resized to hold FlippedBitTicks(length) bits; returns how many are set
+  size_t FlippedBitMask(float const* samples, size_t length, std::vector<uint64_t>& mask,
+                        float threshold = kFlippedBitThreshold);
+
+}
+
+#endif
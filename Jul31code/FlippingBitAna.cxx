@@ -0,0 +1,282 @@
+//***************************
+//    flipped integral analysis
+//    Clara Berger 7/16/18
+//***************************
+
+#include "FlippingBitAna.hh"
+#include "ROIView.h"
+#include "ROIBaseline.hh"
+#include "FlippedBits.hh"
+#include "RawROIStore.hh"
+#include "SNMetrics.hh"
+#include "SNMemory.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <cmath>
+
+//some ROOT includes
+#include "TCanvas.h"
+#include "TPad.h"
+#include "TMath.h"
+#include "TLine.h"
+#include "TStyle.h"
+#include "TGraph.h"
+
+using namespace std;
+
+void sn::FlippingBitAna::ProcessEvent(SNEvent const& evt)
+{
+  int event = evt.event;
+  auto const& wire_vec(*evt.wires);
+  auto const& wire_vec_d(*evt.wires_d);
+  sn::RawROIStore const& raw(*evt.raw);   // the same wires as int16, in the same order
+
+  // reused from wire to wire
+  std::vector<sn::ROIView> rois;
+  std::vector<sn::ROIBaseline> baselines;
+  std::vector<char> flipped;
+
+  for (unsigned int i=0; i<wire_vec.size();i++){
+    int channel = wire_vec[i].Channel();
+
+    //Int nROI = wire_vec[i].SignalROI().n_ranges(); // how many ROIs in a channel
+
+    // baselines of all the ROIs of this wire in one batch
+    sn::WireROIs wireROIs(wire_vec[i]);
+    rois.assign(wireROIs.begin(), wireROIs.end());
+    const size_t firstROI = raw.FirstROI(i);
+    baselines.resize(rois.size());
+    {
+      ScopedTimer timer(kBaseline);
+      sn::EstimateBaselines(rois.data(), rois.size(), baselines.data());
+    }
+
+    // is there a flipped bit anywhere in the ROI? (second difference against the neighbours, see FlippedBits.hh)
+    // on the int16 samples when they are all ADC counts small enough, on the floats otherwise
+    flipped.resize(rois.size());
+    {
+      ScopedTimer timer(kFlipScan);
+      for (size_t iROI = 0; iROI < rois.size(); iROI++) {
+        const size_t iRaw = firstROI + iROI;
+        flipped[iROI] = (raw.Narrow(iRaw) && !raw.HasBad(iRaw)) ? sn::HasFlippedBit(raw.ADC(iRaw), raw.Length(iRaw))
+                                                                : sn::HasFlippedBit(rois[iROI].begin(), rois[iROI].size());
+      }
+    }
+
+    for (size_t iROI = 0; iROI < rois.size(); iROI++) {
+      sn::ROIView const& ROI = rois[iROI];   // no copies of the sparse_vector or its ranges
+      const size_t firstTick = ROI.begin_index();
+	const size_t endTick = ROI.end_index();
+
+	//********************************************** begin baseline algorithm***********************************
+	// (see ROIBaseline.hh; estimated for all the ROIs of the wire at once, above)
+	const float slope = baselines[iROI].slope;
+	const float intercept = baselines[iROI].intercept;
+
+	  //*******************************************end baseline algorightm*************************************************
+
+
+	// (the scan for flipped bits, above for the whole wire)
+	const bool flippedROI = flipped[iROI];
+
+	//cout<<flippedROI.size();
+	//for(int i:flippedROI){
+	//cout<<' '<<i<<' ';}
+
+
+	double roilength;  // find the length of each ROI
+      roilength = endTick-firstTick;
+      hRoiLen.Fill(channel,roilength);
+
+	// integral of the baseline subtracted waveform, the sum of what used to go into one TH1D bin per tick
+	double integral = 0;
+	for (size_t iTick = ROI.begin_index(); iTick < ROI.end_index(); iTick++ ){    //not including last sample
+	  double absvalue;
+	  absvalue = abs(ROI[iTick]-(slope*(iTick)+intercept));  // subtract the algorithm baseline and then take the absolue value
+	  integral += absvalue;}
+
+	// no flipped bit in the ROI
+	if( !flippedROI ){
+	  hIntNot.Fill(channel,integral);       // fill the histogram of no flipped bits integrals
+	  Snapshot(fSnapNot, event, channel, "", ROI, slope, intercept);
+	}
+
+	else {  // if there is at least one 1 there is a flipped bit
+        hIntFlipped.Fill(channel,integral);   // fill the histogram of at least one flipped bit integrals
+	  Snapshot(fSnapFlipped, event, channel, "_f", ROI, slope, intercept);
+
+	  numflipped[channel]+= 1;   // if there is a flipped bit add 1 to the number of occurances for the channel
+
+	  hIntLen.Fill(roilength,integral);
+	}
+
+	// deconvoluted data
+	int channel_d = wire_vec_d[i].Channel();
+
+	//auto ROI_d = zsROIs_d[ROI];
+	for (auto const& ROI_d : sn::ROIs(wire_vec_d[i])) {
+
+	  // the histogram covered the ticks of the ROI before deconvolution, the rest went to under/overflow
+	  double integral_d = 0;
+	  for (size_t iTick = ROI_d.begin_index(); iTick < ROI_d.end_index(); iTick++ ){    //not including last sample
+	    if(iTick >= firstTick && iTick < endTick) integral_d += ROI_d[iTick];}
+
+	  if( !flippedROI ){
+	    hIntNot_d.Fill(channel,integral_d); // fill the histogram of no flipped bits integrals
+	    SnapshotDecon(fSnapNot_d, event, channel_d, "_d", ROI, ROI_d);
+	  }
+	  else {  // if there is at least one 1 there is a flipped bit
+          hIntFlipped_d.Fill(channel,integral_d);   // fill the histogram of at least one flipped bit integrals
+	    SnapshotDecon(fSnapFlipped_d, event, channel, "_df", ROI, ROI_d);
+	  }
+    }// end loop over deconvoluted
+
+
+
+    } //End loop over ROIs
+
+  }//end loop over wires
+}
+
+void sn::FlippingBitAna::Snapshot(SnapshotStore& store, int event, int channel, const char* suffix, ROIView const& ROI, float slope, float intercept)
+{
+  WaveformSnapshot* snap = store.Offer();
+  if(!snap) return;
+  snap->name = Form("c1_%d_%d%s",event,channel,suffix);
+  snap->title = "roi_original;Tick;ADC";
+  snap->firstTick = snap->sampleTick = ROI.begin_index();
+  snap->nTicks = ROI.size();
+  for (size_t iTick = ROI.begin_index(); iTick < ROI.end_index(); iTick++ )
+    snap->samples.push_back(abs(ROI[iTick]-(slope*(iTick)+intercept)));
+}
+
+void sn::FlippingBitAna::SnapshotDecon(SnapshotStore& store, int event, int channel, const char* suffix, ROIView const& ROI, ROIView const& ROI_d)
+{
+  WaveformSnapshot* snap = store.Offer();
+  if(!snap) return;
+  snap->name = Form("c1_%d_%d%s",event,channel,suffix);
+  snap->title = "roi_original;Tick;ADC";
+  snap->firstTick = ROI.begin_index();
+  snap->nTicks = ROI.size();
+  snap->sampleTick = ROI_d.begin_index();
+  snap->samples.assign(ROI_d.begin(), ROI_d.end());
+}
+
+void sn::FlippingBitAna::Finish()
+{
+  // difference to interpolation
+  TCanvas c7("notflippedint","c7",900,600);
+  TCanvas c8("flippedint","c8",900,600);
+  TCanvas c4("notflippedint_decon","c4",900,600);
+  TCanvas c5("flippedint_decon","c5",900,600);
+  // how many times and ROI in a channel had a flipped bit
+  TCanvas c1("flippedchannel","c1",900,600);
+  //how long are the ROIs in the channels
+  TCanvas c2("roilength","c2",900,600);
+  // integral vs. length of ROI
+  TCanvas c3("lengthintegral","c3",900,600);
+
+  // the sparse histograms are made into TH2s one at a time, drawn, written and let go,
+  // each only if it fits in the memory budget (see DenseBooking in SNMemory.hh)
+
+  //diff to interpolation
+  if(DenseBooking dense{hIntNot.GetName(), hIntNot.DenseBytes()}){
+    auto h = hIntNot.MakeTH2();
+    c7.cd();
+    h->Draw("colz");
+    gStyle->SetPalette(60);
+    // h->SetStats(0);
+    c7.Print(".png");
+    h->Write();
+  }
+
+  if(DenseBooking dense{hIntFlipped.GetName(), hIntFlipped.DenseBytes()}){
+    auto h = hIntFlipped.MakeTH2();
+    c8.cd();
+    h->Draw("colz");
+    gStyle->SetPalette(60);
+    //h->SetStats(0);
+    c8.Print(".png");
+    h->Write();
+  }
+
+
+  if(DenseBooking dense{hIntNot_d.GetName(), hIntNot_d.DenseBytes()}){
+    auto h = hIntNot_d.MakeTH2();
+    c4.cd();
+    h->Draw("colz");
+    h->GetZaxis()->SetRangeUser(0,60);
+    gStyle->SetPalette(60);
+    //h->SetStats(0);
+    c4.Print(".png");
+    h->Write();
+  }
+
+  if(DenseBooking dense{hIntFlipped_d.GetName(), hIntFlipped_d.DenseBytes()}){
+    auto h = hIntFlipped_d.MakeTH2();
+    c5.cd();
+    h->Draw("colz");
+    gStyle->SetPalette(60);
+    h->GetZaxis()->SetRangeUser(0,7);
+    //h->SetStats(0);
+    c5.Print(".png");
+    h->Write();
+  }
+
+
+  // Just make the double array of all channel numbers
+  for(int n=0; n<8256;n++)
+    {x[n]=n;}
+
+  // make a bar graph using totalhits as the height of all 8256 bars each bar is a different channel
+  // this will essentially be a histogram with number of hits per wire on the y axis
+  TGraph* channelbits  = new TGraph(8256,x,numflipped);
+  channelbits->SetTitle("Frequency of Flipped Bits by Channel");
+  channelbits->GetXaxis()->SetTitle("Channel");
+  channelbits->GetXaxis()->SetRangeUser(0,8256);
+  channelbits->GetYaxis()->SetTitle("# of times there was an ROI with a flipped bit");
+  channelbits->GetYaxis()->SetTitleOffset(1.4);
+  c1.cd();
+  channelbits->SetFillColor(1);
+  channelbits->Draw("AB");
+  //c1.Print(".png");
+  //c1.Write();
+  delete channelbits;
+
+  // roi length
+  if(DenseBooking dense{hRoiLen.GetName(), hRoiLen.DenseBytes()}){
+    auto h = hRoiLen.MakeTH2();
+    c2.cd();
+    h->Draw("colz");
+    //c2.Print(".png");
+    h->Write();
+  }
+
+  // length vs. integral
+  c3.cd();
+  hIntLen.Draw("colz");
+  //c3.Print(".png");
+
+  // the single ROIs we kept, now that nothing else is going on
+  std::vector<WaveformSnapshot> snapshots;
+  for(SnapshotStore const* store : {&fSnapNot, &fSnapFlipped, &fSnapNot_d, &fSnapFlipped_d}){
+    std::cout << store->Kept().size() << " of " << store->Offered() << " ROIs kept for drawing" << std::endl;
+    snapshots.insert(snapshots.end(), store->Kept().begin(), store->Kept().end());
+  }
+  RenderSnapshots(snapshots, "flippingbit_snapshots");
+}
+
+size_t sn::FlippingBitAna::BookingBytes()
+{
+  return HistBytes(400, 10000, sizeof(float));   // hIntLen, the only dense one
+}
+
+size_t sn::FlippingBitAna::SparseBytes()
+{
+  return hIntFlipped.Bytes() + hIntNot.Bytes() + hIntFlipped_d.Bytes() + hIntNot_d.Bytes() + hRoiLen.Bytes();
+}
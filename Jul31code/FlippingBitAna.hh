@@ -0,0 +1,64 @@
+//***************************
+//    flipped integral analysis
+//    Clara Berger 7/16/18
+//***************************
+
+#ifndef SN_FLIPPINGBITANA_HH
+#define SN_FLIPPINGBITANA_HH
+
+//some ROOT includes
+#include "TH1F.h"
+#include "TH2S.h"
+
+#include "SNStage.hh"
+#include "ROIView.h"
+#include "WaveformSnapshots.hh"
+#include "SparseHist2D.hh"
+
+namespace sn{
+
+  class FlippingBitAna : public SNStage{
+
+  public:
+    size_t MaxEvents() const override { return 65; }
+    bool UsesDeconvolved() const override { return true; }
+    bool UsesRawStore() const override { return true; }   // for the flipped bit scan
+    void ProcessEvent(SNEvent const& evt) override;
+    void Finish() override;
+    size_t SparseBytes() override;
+    static size_t BookingBytes();   // the histogram members below, before they are booked
+
+  private:
+    // the channel x quantity plots are sparse until Finish()
+
+    // difference to interpolation
+    SparseTH2F hIntFlipped{"hIntFlipped", "ROI Integral with Flipped Bit; Channel; ROI integral (ADC)", 8256, 0, 8256, 8000, 0, 8000};
+    SparseTH2F hIntNot{"hIntNot", "ROI Integral No Flipped Bit; Channel; ROI integral (ADC)", 8256, 0, 8256, 8000, 0, 8000};
+
+    SparseTH2F hIntFlipped_d{"hIntFlipped_decon", "Deconvoluted ROI Integral with Flipped Bit; Channel; ROI integral (ADC)", 8256, 0, 8256, 4000, 0, 4000};
+    SparseTH2F hIntNot_d{"hIntNot_decon", " Deconvoluted ROI Integral No Flipped Bit; Channel; ROI integral (ADC)", 8256, 0, 8256, 4000, 0, 4000};
+
+    // how many times and ROI in a channel had a flipped bit
+    int numflipped[8256] = {};
+    int x[8256];
+    // TH1F hNumFlipped("hNumFlipped", "Frequency of Flipped Bits by Channel; Channel; # of times there was a flipped bit", 8256, 0, 8256);
+
+    //how long are the ROIs in the channels
+    SparseTH2F hRoiLen{"hRoiLen", "Lengths of ROIs by Channel; Channel; Length of ROI (Ticks)", 8256, 0, 8256, 2000, 0, 2000};
+
+    // integral vs. length of ROI
+    TH2F hIntLen{"hIntLen", "ROI Integral; Length of ROI (Ticks); ROI Integral (ADC)", 400, 0, 400, 10000, 0, 10000};
+
+    // a sample of the single ROIs (baseline subtracted), drawn at the end instead of a canvas per ROI
+    SnapshotStore fSnapNot{50};
+    SnapshotStore fSnapFlipped{50};
+    SnapshotStore fSnapNot_d{50};
+    SnapshotStore fSnapFlipped_d{50};
+    // the canvas name "c1_<event>_<channel><suffix>" is only made for the ROIs the store keeps
+    void Snapshot(SnapshotStore& store, int event, int channel, const char* suffix, ROIView const& ROI, float slope, float intercept);
+    void SnapshotDecon(SnapshotStore& store, int event, int channel, const char* suffix, ROIView const& ROI, ROIView const& ROI_d);
+  };
+
+}
+
+#endif
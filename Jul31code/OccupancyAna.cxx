@@ -0,0 +1,78 @@
+//***************************************
+//  channel occupancy histogram
+//***************************************
+
+#include "OccupancyAna.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+//some ROOT includes
+#include "TCanvas.h"
+#include "TPad.h"
+#include "TGraph.h"
+
+using namespace std;
+using namespace std::chrono;
+
+void sn::OccupancyAna::ProcessEvent(SNEvent const& evt)
+{
+  auto t_begin = high_resolution_clock::now();
+
+  //to get run and event info, you use this "eventAuxillary()" object.
+  cout << "Processing "
+       << "Run " << evt.run << ", "
+       << "Event " << evt.event << endl;
+
+  auto const& wire_vec(*evt.wires);
+
+  cout << "\tThere are " << wire_vec.size() << " Wires in this event." << endl;
+
+  // cout << "Beginning of loop over wires" << endl;
+
+  // create a vector with the number of hits per wire of one event
+  std::vector<int> wirehits(8256);
+
+  //Fill the totalhits array by adding up the number of hits in each wire over every event
+  for (unsigned int i=0;i<wire_vec.size();i++ )
+    { auto const numhits = wire_vec[i].SignalROI().n_ranges(); // n_ranges give number of events
+	int channel = wire_vec[i].Channel();//get channel number of each wire
+	//cout<< channel<<' ';
+	wirehits[channel]= numhits;
+	totalhits[channel]=totalhits[channel]+wirehits[channel];//add to previous event by channel in total hits
+  	      }
+
+
+
+  auto t_end = high_resolution_clock::now();
+  duration<double,std::milli> time_total_ms(t_end-t_begin);
+  cout << "\tEvent took " << time_total_ms.count() << " ms to process." << endl;
+}
+
+void sn::OccupancyAna::Finish()
+{
+  TCanvas *c1 = new TCanvas("wirehist200","c1",1000,700);
+
+  // just make the double array of all channel numbers
+   for(int n=0; n<8256;n++)
+    {x[n]=n;}
+
+   // make a bar graph using totalhits as the height of all 8256 bars each bar is a different channel
+   // this will essentially be a histogram with number of hits per wire on the y axis
+   TGraph* wireevents  = new TGraph(8256,x,totalhits);
+   wireevents->SetTitle("Wire Occupancy");
+   wireevents->GetXaxis()->SetTitle("Wire");
+   wireevents->GetXaxis()->SetRangeUser(0,8256);
+   wireevents->GetYaxis()->SetTitle("Number of Hits per Wire");
+   wireevents->GetYaxis()->SetTitleOffset(1.2);
+   c1->cd();
+   wireevents->SetFillColor(1);
+   wireevents->Draw("AB");
+
+   c1->Print(".png");
+
+  delete c1;
+  delete wireevents;
+}
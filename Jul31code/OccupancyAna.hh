@@ -0,0 +1,27 @@
+//***************************************
+//  channel occupancy histogram
+//***************************************
+
+#ifndef SN_OCCUPANCYANA_HH
+#define SN_OCCUPANCYANA_HH
+
+#include "SNStage.hh"
+
+namespace sn{
+
+  class OccupancyAna : public SNStage{
+
+  public:
+    size_t MaxEvents() const override { return 200; }
+    void ProcessEvent(SNEvent const& evt) override;
+    void Finish() override;
+
+  private:
+    // Create two arrays that will eventually be used to fill the plot, one of the total hits per each wire and one of just the channel numbers
+    double totalhits[8256] = {};
+    double x[8256];
+  };
+
+}
+
+#endif
@@ -0,0 +1,230 @@
+//***************************
+//    quantile sketches of the baseline differences
+//***************************
+
+#include "QuantileSketch.hh"
+
+//some standard C++ includes
+#include <algorithm>
+#include <limits>
+#include <iomanip>
+#include <stdexcept>
+
+//some ROOT includes
+#include "TMath.h"
+
+namespace{
+
+  // the k1 scale function of the t-digest: k(q) = compression/(2 pi) asin(2q-1),
+  // a centroid may span at most 1 in k, which keeps the tails fine grained
+  double ScaleK(double q, double compression){
+    return compression/(2*TMath::Pi()) * std::asin(2*q-1);
+  }
+  double ScaleQ(double k, double compression){
+    if(k >= compression/4) return 1;
+    return (std::sin(k*2*TMath::Pi()/compression) + 1)/2;
+  }
+
+}
+
+sn::QuantileSketch::QuantileSketch(float compression)
+  : fCompression(compression)
+  , fCount(0)
+  , fMin(0)
+  , fMax(0)
+{}
+
+void sn::QuantileSketch::Compress()
+{
+  if(fBuffer.empty()) return;
+
+  // everything in one sorted list, then greedily merged from the left
+  std::sort(fBuffer.begin(), fBuffer.end(),
+            [](Centroid const& a, Centroid const& b){ return a.mean < b.mean; });
+  std::vector<Centroid>& all = fScratch;
+  all.resize(fCentroids.size() + fBuffer.size());
+  std::merge(fCentroids.begin(), fCentroids.end(), fBuffer.begin(), fBuffer.end(), all.begin(),
+             [](Centroid const& a, Centroid const& b){ return a.mean < b.mean; });
+  fBuffer.clear();
+
+  double total = 0;
+  for(auto const& c : all) total += c.weight;
+
+  // the centroids are built again in their own vector, which keeps its room
+  std::vector<Centroid>& merged = fCentroids;
+  merged.clear();
+  Centroid current = all[0];
+  double meanSum = double(current.mean)*current.weight;   // weighted means in double
+  double weightSoFar = 0;
+  double qLimit = ScaleQ(ScaleK(0, fCompression) + 1, fCompression);
+  for(size_t i=1; i<all.size(); i++){
+    const double qRight = (weightSoFar + current.weight + all[i].weight)/total;
+    if(qRight <= qLimit){
+      current.weight += all[i].weight;
+      meanSum += double(all[i].mean)*all[i].weight;
+      current.mean = meanSum/current.weight;
+    }
+    else{
+      merged.push_back(current);
+      weightSoFar += current.weight;
+      qLimit = ScaleQ(ScaleK(weightSoFar/total, fCompression) + 1, fCompression);
+      current = all[i];
+      meanSum = double(current.mean)*current.weight;
+    }
+  }
+  merged.push_back(current);
+}
+
+void sn::QuantileSketch::Merge(QuantileSketch const& other)
+{
+  if(other.fCount == 0) return;
+  if(fCount == 0 || other.fMin < fMin) fMin = other.fMin;
+  if(fCount == 0 || other.fMax > fMax) fMax = other.fMax;
+  fCount += other.fCount;
+  fBuffer.insert(fBuffer.end(), other.fCentroids.begin(), other.fCentroids.end());
+  fBuffer.insert(fBuffer.end(), other.fBuffer.begin(), other.fBuffer.end());
+  Compress();
+}
+
+double sn::QuantileSketch::Quantile(double q) const
+{
+  if(fCount == 0) return std::numeric_limits<double>::quiet_NaN();
+  if(!fBuffer.empty())
+    throw std::runtime_error("QuantileSketch: Quantile() with values still buffered, Compress() first");
+  if(q <= 0) return fMin;
+  if(q >= 1) return fMax;
+
+  const size_t n = fCentroids.size();
+  if(n == 1) return fCentroids[0].mean;
+
+  // each centroid sits at the middle of its weight; interpolate between those,
+  // and between the outer ones and the min/max
+  const double index = q*fCount;
+  double left = fCentroids[0].weight/2.;
+  if(index < left)
+    return fMin + (index/left)*(fCentroids[0].mean - fMin);
+  for(size_t i=0; i+1<n; i++){
+    const double dw = (fCentroids[i].weight + fCentroids[i+1].weight)/2.;
+    if(index < left + dw)
+      return fCentroids[i].mean + (index-left)/dw*(fCentroids[i+1].mean - fCentroids[i].mean);
+    left += dw;
+  }
+  const double rest = fCentroids[n-1].weight/2.;
+  return fCentroids[n-1].mean + std::min(1., (index-left)/rest)*(fMax - fCentroids[n-1].mean);
+}
+
+sn::ChannelQuantiles::ChannelQuantiles(const char* name, const char* title, size_t nChannels,
+                                       float compression, float planeCompression)
+  : fName(name)
+  , fTitle(title)
+  , fChannels(nChannels, QuantileSketch(compression))
+  , fPlanes(3, QuantileSketch(planeCompression))
+  , fOutside(0)
+  , fNonFinite(0)
+{}
+
+void sn::ChannelQuantiles::Merge(ChannelQuantiles const& other)
+{
+  for(size_t ch=0; ch<fChannels.size() && ch<other.fChannels.size(); ch++)
+    fChannels[ch].Merge(other.fChannels[ch]);
+  for(size_t p=0; p<fPlanes.size(); p++)
+    fPlanes[p].Merge(other.fPlanes[p]);
+  fOutside += other.fOutside;
+  fNonFinite += other.fNonFinite;
+}
+
+void sn::ChannelQuantiles::Compress()
+{
+  for(auto& sketch : fChannels) sketch.Compress();
+  for(auto& sketch : fPlanes) sketch.Compress();
+}
+
+size_t sn::ChannelQuantiles::Bytes() const
+{
+  size_t bytes = (fChannels.size() + fPlanes.size())*sizeof(QuantileSketch);
+  for(auto const& sketch : fChannels) bytes += sketch.Bytes();
+  for(auto const& sketch : fPlanes) bytes += sketch.Bytes();
+  return bytes;
+}
+
+std::unique_ptr<TH1D> sn::ChannelQuantiles::MakeTH1(Summary what)
+{
+  Compress();
+
+  static const char* const suffix[] = { "median", "q25", "q75", "iqr", "q01", "q99" };
+  static const char* const label[] = { "median", "25% quantile", "75% quantile", "interquartile range", "1% quantile", "99% quantile" };
+
+  const std::string name = fName + "_" + suffix[what];
+  const std::string title = fName + " " + label[what] + " per channel; Channel; " + fTitle;
+  const int nChannels = fChannels.size();
+  std::unique_ptr<TH1D> h(new TH1D(name.c_str(), title.c_str(), nChannels, 0, nChannels));
+
+  size_t nFilled = 0;
+  for(int ch=0; ch<nChannels; ch++){
+    QuantileSketch const& sketch = fChannels[ch];
+    if(sketch.Count() == 0) continue;
+    nFilled++;
+    double v = 0;
+    switch(what){
+    case kMedian: v = sketch.Quantile(0.5); break;
+    case kQ25:    v = sketch.Quantile(0.25); break;
+    case kQ75:    v = sketch.Quantile(0.75); break;
+    case kIQR:    v = sketch.Quantile(0.75) - sketch.Quantile(0.25); break;
+    case kQ01:    v = sketch.Quantile(0.01); break;
+    case kQ99:    v = sketch.Quantile(0.99); break;
+    }
+    h->SetBinContent(ch+1, v);
+  }
+  h->SetEntries(nFilled);   // channels that saw anything
+  return h;
+}
+
+std::unique_ptr<TH1D> sn::ChannelQuantiles::MakePlaneTH1(int plane)
+{
+  static const char* const planeName[] = { "U", "V", "Y" };
+
+  const std::string name = fName + "_" + planeName[plane];
+  const std::string title = fName + " quantiles " + planeName[plane] + " plane; Fraction of ROIs; " + fTitle;
+  std::unique_ptr<TH1D> h(new TH1D(name.c_str(), title.c_str(), 101, -0.005, 1.005));
+  QuantileSketch& sketch = fPlanes[plane];
+  if(sketch.Count() == 0) return h;
+  sketch.Compress();
+  for(int i=0; i<=100; i++)
+    h->SetBinContent(i+1, sketch.Quantile(i/100.));
+  h->SetEntries(sketch.Count());
+  return h;
+}
+
+void sn::ChannelQuantiles::Print(std::ostream& out)
+{
+  static const char* const planeName[] = { "U", "V", "Y" };
+
+  const std::streamsize precision = out.precision();
+  out << fName << " (" << fTitle << ")" << std::endl;
+  out << "  plane      ROIs     median        IQR         1%        99%" << std::endl;
+  for(int p=0; p<3; p++){
+    QuantileSketch& sketch = fPlanes[p];
+    sketch.Compress();
+    out << "  " << std::setw(5) << planeName[p] << std::setw(10) << sketch.Count();
+    if(sketch.Count() > 0){
+      out << std::fixed << std::setprecision(2)
+          << std::setw(11) << sketch.Quantile(0.5)
+          << std::setw(11) << sketch.Quantile(0.75) - sketch.Quantile(0.25)
+          << std::setw(11) << sketch.Quantile(0.01)
+          << std::setw(11) << sketch.Quantile(0.99);
+      out.unsetf(std::ios::floatfield);
+      out.precision(precision);
+    }
+    out << std::endl;
+  }
+  if(fOutside || fNonFinite)
+    out << "  (" << fOutside << " values from unknown channels and " << fNonFinite << " NaN/inf left out)" << std::endl;
+}
+
+void sn::ChannelQuantiles::Write()
+{
+  for(Summary what : { kMedian, kQ25, kQ75, kIQR, kQ01, kQ99 })
+    MakeTH1(what)->Write();
+  for(int p=0; p<3; p++)
+    MakePlaneTH1(p)->Write();
+}
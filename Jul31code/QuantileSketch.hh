@@ -0,0 +1,140 @@
+//***************************
+//    quantile sketches of the baseline differences
+//
+//    QuantileSketch is a merging t-digest (Dunning): the values are kept as a
+//    sorted list of centroids (mean, weight) whose size is bounded by the
+//    compression, small in the middle of the distribution and single values in
+//    the tails, so the median and the 1%/99% quantiles both come out well.
+//    New values are buffered and merged in in batches; two sketches merge by
+//    putting their centroids together. The buffer and the merge scratch keep
+//    their room from one batch to the next, so a merge allocates nothing.
+//    Quantile() reads the centroids only: Compress() first.
+//
+//    ChannelQuantiles keeps one per channel and one per plane, so the baseline
+//    differences can be followed over thousands of events in a fixed amount of
+//    memory, and hands back the per-channel median, quartiles and tails as
+//    TH1Ds over the channels.
+//***************************
+
+#ifndef SN_QUANTILESKETCH_HH
+#define SN_QUANTILESKETCH_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <cmath>
+#include <stdint.h>
+
+//some ROOT includes
+#include "TH1D.h"
+
+namespace sn{
+
+  class QuantileSketch{
+
+  public:
+    // about compression/2 centroids after a merge; 50 gives ~1% of the rank around the median
+    explicit QuantileSketch(float compression = 50);
+
+    void Add(double v){
+      if(fCount == 0 || v < fMin) fMin = v;
+      if(fCount == 0 || v > fMax) fMax = v;
+      fCount++;
+      fBuffer.push_back(Centroid{float(v), 1});
+      if(fBuffer.size() >= BufferSize()) Compress();
+    }
+
+    // add another sketch's values, as if they had been added here
+    void Merge(QuantileSketch const& other);
+
+    // merge the buffered values into the centroids (done on the way anyway)
+    void Compress();
+
+    // the value below which a fraction q of the values are, interpolated between
+    // the centroids; NaN if the sketch is empty. Throws std::runtime_error if
+    // there are values left in the buffer (not Compress()ed)
+    double Quantile(double q) const;
+
+    uint64_t Count() const { return fCount; }
+    double Min() const { return fMin; }
+    double Max() const { return fMax; }
+    size_t NCentroids() const { return fCentroids.size(); }
+    size_t Bytes() const { return (fCentroids.capacity() + fBuffer.capacity() + fScratch.capacity())*sizeof(Centroid); }
+
+  private:
+    struct Centroid{
+      float mean;
+      uint32_t weight;
+    };
+
+    size_t BufferSize() const { return size_t(2*fCompression); }
+
+    float fCompression;
+    uint64_t fCount;
+    float fMin, fMax;
+    std::vector<Centroid> fCentroids;   // sorted by mean
+    std::vector<Centroid> fBuffer;      // not merged yet
+    std::vector<Centroid> fScratch;     // centroids and buffer sorted together, in Compress()
+  };
+
+  class ChannelQuantiles{
+
+  public:
+    static constexpr size_t kNChannels = 8256;
+
+    // the title is the quantity, as on the y axis of the TH2 it stands for ("ADC")
+    ChannelQuantiles(const char* name, const char* title, size_t nChannels = kNChannels,
+                     float compression = 50, float planeCompression = 200);
+
+    // U, V and Y the way the analyses split them: channel <= 2400, <= 4800, the rest
+    static int Plane(int channel) { return channel <= 2400 ? 0 : (channel <= 4800 ? 1 : 2); }
+
+    // one value of a channel; channels outside [0,nChannels) and NaN/inf are only counted
+    void Fill(int channel, double v){
+      if(channel < 0 || size_t(channel) >= fChannels.size()){ fOutside++; return; }
+      if(!std::isfinite(v)){ fNonFinite++; return; }
+      fChannels[channel].Add(v);
+      fPlanes[Plane(channel)].Add(v);
+    }
+
+    // add another worker's values
+    void Merge(ChannelQuantiles const& other);
+
+    // flush all the buffers; the summaries below do it once before going through the channels
+    void Compress();
+
+    const char* GetName() const { return fName.c_str(); }
+    size_t NChannels() const { return fChannels.size(); }
+    QuantileSketch const& Channel(size_t channel) const { return fChannels[channel]; }
+    QuantileSketch const& PlaneSketch(int plane) const { return fPlanes[plane]; }
+    size_t NOutside() const { return fOutside; }
+    size_t NNonFinite() const { return fNonFinite; }
+
+    size_t Bytes() const;
+
+    enum Summary { kMedian, kQ25, kQ75, kIQR, kQ01, kQ99 };
+    // one summary over the channels, booked in gDirectory as <name>_median, <name>_q25, ...
+    std::unique_ptr<TH1D> MakeTH1(Summary what);
+    // the quantile function of a plane in 1% steps, <name>_U/V/Y
+    std::unique_ptr<TH1D> MakePlaneTH1(int plane);
+
+    // median, IQR and tails of each plane
+    void Print(std::ostream& out = std::cout);
+
+    // all of the above, one at a time, into gDirectory
+    void Write();
+
+  private:
+    std::string fName;
+    std::string fTitle;
+    std::vector<QuantileSketch> fChannels;
+    std::vector<QuantileSketch> fPlanes;
+    size_t fOutside;
+    size_t fNonFinite;
+  };
+
+}
+
+#endif
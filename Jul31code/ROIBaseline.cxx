@@ -0,0 +1,153 @@
+//***************************
+//    baseline of an ROI from its zero-suppression pre- and postsamples
+//***************************
+
+#include "ROIBaseline.hh"
+
+//some standard C++ includes
+#include <cmath>
+#include <limits>
+
+namespace {
+
+  // ROIs per batch: every array below is [sample][lane], so each step of the
+  // algorithm is a loop over the lanes the compiler can keep in vector registers
+  const size_t kLanes = 8;
+  const size_t kRows = 8;   // the sorting network sorts 8 values; presamples get padded
+
+  const float kMedianCut = 15; // Maximum absolute difference between a sample and the median to be considered as baseline
+  const float kNoBaseline = -4095;
+
+  typedef float Rows[kRows][kLanes];
+
+  inline void CompareExchange(float* a, float* b){
+    for(size_t l=0; l<kLanes; l++){
+      const float lo = a[l] < b[l] ? a[l] : b[l];
+      const float hi = a[l] < b[l] ? b[l] : a[l];
+      a[l] = lo;
+      b[l] = hi;
+    }
+  }
+
+  // optimal 19 comparator network for 8 inputs
+  inline void Sort8(Rows& r){
+    CompareExchange(r[0],r[2]); CompareExchange(r[1],r[3]); CompareExchange(r[4],r[6]); CompareExchange(r[5],r[7]);
+    CompareExchange(r[0],r[4]); CompareExchange(r[1],r[5]); CompareExchange(r[2],r[6]); CompareExchange(r[3],r[7]);
+    CompareExchange(r[0],r[1]); CompareExchange(r[2],r[3]); CompareExchange(r[4],r[5]); CompareExchange(r[6],r[7]);
+    CompareExchange(r[2],r[4]); CompareExchange(r[3],r[5]);
+    CompareExchange(r[1],r[4]); CompareExchange(r[3],r[6]);
+    CompareExchange(r[1],r[2]); CompareExchange(r[3],r[4]); CompareExchange(r[5],r[6]);
+  }
+
+  // the samples that aren't > 1 (1e-44 and similar swizzler errors) go to the end as +inf,
+  // so after sorting the first n rows are exactly what std::sort made of the good ones
+  inline void SortGood(Rows const& raw, size_t nSamples, Rows& sorted, int* nGood){
+    const float inf = std::numeric_limits<float>::infinity();
+    for(size_t l=0; l<kLanes; l++) nGood[l] = 0;
+    for(size_t k=0; k<kRows; k++){
+      for(size_t l=0; l<kLanes; l++){
+        const bool good = k < nSamples && raw[k][l] > 1;
+        sorted[k][l] = good ? raw[k][l] : inf;
+        nGood[l] += good;
+      }
+    }
+    Sort8(sorted);
+  }
+
+  // as in the original: (a + b)/2. for an even count, in float then double then back
+  inline float Median(Rows const& sorted, int n, size_t l){
+    if(n == 0) return std::numeric_limits<float>::quiet_NaN();
+    if(n % 2 == 0){
+      const float sum = sorted[n/2 - 1][l] + sorted[n/2][l];
+      return sum/2.;
+    }
+    return sorted[n/2][l];
+  }
+
+  // where the ROIs come from. Gather puts the 7 presamples of ROI i into
+  // pre[k][l] = ROI[begin+k] and the 8 postsamples into post[k][l] = ROI[end-8+k], the last
+  // 8 samples of the ROI: end_index() is one past its last sample, as in all the stages
+  struct ViewSource{
+    sn::ROIView const* rois;
+    size_t Begin(size_t i) const { return rois[i].begin_index(); }
+    size_t End(size_t i) const { return rois[i].end_index(); }
+    void Gather(size_t i, Rows& pre, Rows& post, size_t l) const {
+      sn::ROIView const& ROI = rois[i];
+      for(size_t k=0; k<sn::kZSPresamples; k++) pre[k][l] = ROI[ROI.begin_index() + k];
+      for(size_t k=0; k<sn::kZSPostsamples; k++) post[k][l] = ROI[ROI.end_index() - sn::kZSPostsamples + k];
+    }
+  };
+
+  template<typename Source>
+  void Estimate(Source const& rois, size_t nROIs, sn::ROIBaseline* out)
+  {
+    using namespace sn;
+
+    Rows pre, post, sortedPre, sortedPost;
+    int nPre[kLanes], nPost[kLanes];
+    float medianPre[kLanes], medianPost[kLanes];
+    float prebaseline[kLanes], postbaseline[kLanes];
+    int preSample[kLanes], postSample[kLanes];
+
+    for(size_t first=0; first<nROIs; first+=kLanes){
+      const size_t nLanes = nROIs - first < kLanes ? nROIs - first : kLanes;
+
+      for(size_t l=0; l<kLanes; l++){
+        for(size_t k=0; k<kRows; k++){ pre[k][l] = 0; post[k][l] = 0; }
+        if(l < nLanes) rois.Gather(first+l, pre, post, l);
+      }
+
+      SortGood(pre, kZSPresamples, sortedPre, nPre);
+      SortGood(post, kZSPostsamples, sortedPost, nPost);
+      for(size_t l=0; l<kLanes; l++){
+        medianPre[l] = Median(sortedPre, nPre[l], l);
+        medianPost[l] = Median(sortedPost, nPost[l], l);
+      }
+
+      // earliest presample and last postsample close to the medians: going backwards,
+      // the last one to pass is the one the forward search stopped at
+      for(size_t l=0; l<kLanes; l++){
+        prebaseline[l] = kNoBaseline; preSample[l] = -1;
+        postbaseline[l] = kNoBaseline; postSample[l] = -1;
+      }
+      for(int k=kZSPresamples-1; k>=0; k--){
+        for(size_t l=0; l<kLanes; l++){
+          const bool close = fabs(pre[k][l] - medianPre[l]) < kMedianCut;
+          prebaseline[l] = close ? pre[k][l] : prebaseline[l];
+          preSample[l] = close ? k : preSample[l];
+        }
+      }
+      for(size_t k=0; k<kZSPostsamples; k++){   // post[kZSPostsamples-1] is the last tick of the ROI
+        for(size_t l=0; l<kLanes; l++){
+          const bool close = fabs(post[k][l] - medianPost[l]) < kMedianCut;
+          postbaseline[l] = close ? post[k][l] : postbaseline[l];
+          postSample[l] = close ? int(k) : postSample[l];
+        }
+      }
+
+      for(size_t l=0; l<nLanes; l++){
+        ROIBaseline& b = out[first+l];
+        b.medianPre = medianPre[l];
+        b.medianPost = medianPost[l];
+        b.prebaseline = prebaseline[l];
+        b.postbaseline = postbaseline[l];
+        b.pretick = preSample[l] < 0 ? size_t(-1) : rois.Begin(first+l) + preSample[l];
+        b.postick = postSample[l] < 0 ? size_t(-1) : rois.End(first+l) - (kZSPostsamples - postSample[l]);
+
+        // Linear interpolation for baseline (size_t ticks and all, as before)
+        const size_t pretick = b.pretick;
+        const size_t postick = b.postick;
+        const float slope = (b.postbaseline - b.prebaseline)/(postick - pretick);
+        const float intercept = b.prebaseline - slope*pretick;
+        b.slope = slope;
+        b.intercept = intercept;
+      }
+    }
+  }
+
+}
+
+void sn::EstimateBaselines(ROIView const* rois, size_t nROIs, ROIBaseline* out)
+{
+  Estimate(ViewSource{rois}, nROIs, out);
+}
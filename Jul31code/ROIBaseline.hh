@@ -0,0 +1,46 @@
+//***************************
+//    baseline of an ROI from its zero-suppression pre- and postsamples
+//
+//    the algorithm that used to be pasted into baselines, flippingbit and flippingdecon:
+//    median of the good (> 1 ADC) presamples and postsamples, first presample and last
+//    postsample within medianCut of their median, straight line through those two.
+//    Here it runs on a batch of ROIs at a time, one ROI per lane, with the medians taken
+//    by a fixed sorting network, and without allocating anything. The postsamples are
+//    the last 8 samples of the ROI; the pasted version read one past the end for them.
+//***************************
+
+#ifndef SN_ROIBASELINE_HH
+#define SN_ROIBASELINE_HH
+
+#include <stdlib.h>
+
+#include "ROIView.h"
+
+namespace sn{
+
+  const size_t kZSPresamples = 7;
+  const size_t kZSPostsamples = 8;
+
+  struct ROIBaseline{
+    float medianPre;      // median of the good presamples (NaN if there are none)
+    float medianPost;     // median of the good postsamples (NaN if there are none)
+    float prebaseline;    // first presample close to the median (-4095 if none is)
+    float postbaseline;   // last postsample close to the median (-4095 if none is)
+    size_t pretick;       // and their ticks ((size_t)-1 if none)
+    size_t postick;
+    float slope;          // the baseline is slope*tick + intercept
+    float intercept;
+  };
+
+  // baselines of rois[0] ... rois[nROIs-1] into out[0] ... out[nROIs-1]
+  void EstimateBaselines(ROIView const* rois, size_t nROIs, ROIBaseline* out);
+
+  inline ROIBaseline EstimateBaseline(ROIView const& roi){
+    ROIBaseline baseline;
+    EstimateBaselines(&roi, 1, &baseline);
+    return baseline;
+  }
+
+}
+
+#endif
@@ -0,0 +1,70 @@
+//***************************
+//    everything waveanalysis looks at in an ROI, in one pass over its samples
+//***************************
+
+#include "ROIFeatures.hh"
+
+//some standard C++ includes
+#include <limits>
+
+void sn::ROIFeatureTable::clear()
+{
+  channel.clear(); firstTick.clear(); length.clear();
+  mean.clear(); variance.clear(); integral.clear(); minimum.clear(); maximum.clear();
+  firstSample.clear(); lastSample.clear(); firstRise.clear(); lastFall.clear();
+  diffToInterpolMin.clear(); diffToInterpolMax.clear();
+  diffBegin.assign(1, 0);
+  diffToInterpol.clear();
+}
+
+void sn::ExtractROIFeatures(ROIView const& roi, ROIFeatureTable& table)
+{
+  const float* s = roi.samples;
+  const size_t n = roi.length;
+  const float first = n ? s[0] : 0;
+
+  // the sum is in the same order as TMath::Mean, so the mean comes out the same;
+  // the variance is taken around the first sample, which keeps the sums exact for ADC counts
+  double sum = 0;
+  double sumd = 0;
+  double sumd2 = 0;
+  double integral = 0;
+  float minimum = std::numeric_limits<float>::infinity();
+  float maximum = -std::numeric_limits<float>::infinity();
+  double diffMin = std::numeric_limits<double>::infinity();
+  double diffMax = -std::numeric_limits<double>::infinity();
+
+  for(size_t k=0; k<n; k++){
+    const float x = s[k];
+    sum += x;
+    const double d = double(x) - first;
+    sumd += d;
+    sumd2 += d*d;
+    integral += x - first;
+    minimum = x < minimum ? x : minimum;
+    maximum = x > maximum ? x : maximum;
+
+    if(k > 0 && k+1 < n){
+      const double difftoint = x - (( s[k+1] + s[k-1] )/2);
+      table.diffToInterpol.push_back(difftoint);
+      diffMin = difftoint < diffMin ? difftoint : diffMin;
+      diffMax = difftoint > diffMax ? difftoint : diffMax;
+    }
+  }
+
+  table.channel.push_back(roi.channel);
+  table.firstTick.push_back(roi.firstTick);
+  table.length.push_back(n);
+  table.mean.push_back(sum/n);
+  table.variance.push_back(n > 1 ? (sumd2 - sumd*sumd/n)/(n-1) : 0.);
+  table.integral.push_back(integral);
+  table.minimum.push_back(minimum);
+  table.maximum.push_back(maximum);
+  table.firstSample.push_back(first);
+  table.lastSample.push_back(s[n-1]);
+  table.firstRise.push_back(s[7] - first);
+  table.lastFall.push_back(s[n-9] - s[n-1]);
+  table.diffToInterpolMin.push_back(diffMin);
+  table.diffToInterpolMax.push_back(diffMax);
+  table.diffBegin.push_back(table.diffToInterpol.size());
+}
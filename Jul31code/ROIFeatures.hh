@@ -0,0 +1,55 @@
+//***************************
+//    everything waveanalysis looks at in an ROI, in one pass over its samples
+//
+//    the features go into a struct-of-arrays table, one row per ROI, so the
+//    histograms can be filled from plain arrays afterwards. The per-tick
+//    differences to the interpolation are kept too (all ROIs end to end,
+//    row r owns diffToInterpol[diffBegin[r] ... diffBegin[r+1]-1]).
+//
+//    "last" is the ROI's last sample, ROI[end_index()-1] (see ROIView.h):
+//    nothing reads past the ROI's length samples, so the compact buffers of
+//    RawROIStore and SNROICache are read the same way as the art wires.
+//***************************
+
+#ifndef SN_ROIFEATURES_HH
+#define SN_ROIFEATURES_HH
+
+#include <vector>
+#include <stdlib.h>
+
+#include "ROIView.h"
+
+namespace sn{
+
+  struct ROIFeatureTable{
+    std::vector<unsigned int> channel;
+    std::vector<size_t> firstTick;
+    std::vector<size_t> length;
+
+    std::vector<double> mean;            // what TMath::Mean gave
+    std::vector<double> variance;        // sample variance (n-1), 0 for fewer than two samples
+    std::vector<double> integral;        // sum of ROI[t]-ROI[first] over first ... last
+    std::vector<float>  minimum;
+    std::vector<float>  maximum;
+
+    std::vector<float>  firstSample;     // ROI[first]
+    std::vector<float>  lastSample;      // ROI[last]
+    std::vector<float>  firstRise;       // ROI[first+7]-ROI[first]: first sample passing the threshold
+    std::vector<float>  lastFall;        // ROI[last-8]-ROI[last]: last sample passing the threshold
+
+    std::vector<double> diffToInterpolMin;   // ROI[t] - (ROI[t+1]+ROI[t-1])/2 for first < t < last
+    std::vector<double> diffToInterpolMax;
+    std::vector<size_t> diffBegin;           // nROIs+1 offsets into diffToInterpol
+    std::vector<double> diffToInterpol;
+
+    ROIFeatureTable() { clear(); }
+    size_t size() const { return channel.size(); }
+    void clear();
+  };
+
+  // appends the row of one ROI to table
+  void ExtractROIFeatures(ROIView const& roi, ROIFeatureTable& table);
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+//***************************
+//    non-owning views of the ROIs of a recob::Wire
+//
+//    wire.SignalROI() hands back a reference to the sparse_vector, but
+//    'auto zsROIs = wire.SignalROI();' and 'auto ROI = *iROI;' copy all of
+//    it for every channel of every event. Loop over sn::ROIs(wire) instead:
+//
+//      for (auto const& ROI : sn::ROIs(wire_vec[i])) { ... ROI[tick] ... }
+//
+//    ROI keeps the same interface as a sparse_vector range: begin_index(),
+//    end_index() and ROI[tick] with the absolute tick number. end_index() is
+//    one past the last sample, which is ROI[end_index()-1]; the stores that
+//    rebuild wires (RawROIStore, SNROICache) keep nothing after it.
+//***************************
+
+#ifndef SN_ROIVIEW_H
+#define SN_ROIVIEW_H
+
+#include <stdlib.h>
+#include <cstddef>
+#include <iterator>
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+namespace sn{
+
+  // one ROI: channel, first tick, length and a pointer to its contiguous samples
+  struct ROIView{
+    unsigned int channel;
+    size_t firstTick;
+    size_t length;
+    const float* samples;
+
+    size_t begin_index() const { return firstTick; }
+    size_t end_index() const { return firstTick + length; }
+    size_t size() const { return length; }
+
+    // indexed by absolute tick, like ROI[tick] on the sparse_vector range
+    float operator[](size_t tick) const { return samples[tick - firstTick]; }
+
+    const float* begin() const { return samples; }
+    const float* end() const { return samples + length; }
+  };
+
+  // the ROIs of one wire, iterated in place
+  class WireROIs{
+
+  public:
+    typedef recob::Wire::RegionsOfInterest_t::range_const_iterator range_iterator;
+
+    class iterator{
+    public:
+      typedef std::input_iterator_tag iterator_category;
+      typedef ROIView value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef ROIView const* pointer;
+      typedef ROIView reference;
+
+      iterator(range_iterator it, unsigned int channel) : fIt(it), fChannel(channel) {}
+
+      ROIView operator*() const {
+        ROIView roi;
+        roi.channel = fChannel;
+        roi.firstTick = fIt->begin_index();
+        roi.length = fIt->size();
+        roi.samples = roi.length ? &*(fIt->begin()) : nullptr;
+        return roi;
+      }
+      iterator& operator++() { ++fIt; return *this; }
+      bool operator==(iterator const& other) const { return fIt == other.fIt; }
+      bool operator!=(iterator const& other) const { return fIt != other.fIt; }
+
+    private:
+      range_iterator fIt;
+      unsigned int fChannel;
+    };
+
+    explicit WireROIs(recob::Wire const& wire)
+      : fROIs(wire.SignalROI()), fChannel(wire.Channel()) {}
+
+    iterator begin() const { return iterator(fROIs.begin_range(), fChannel); }
+    iterator end() const { return iterator(fROIs.end_range(), fChannel); }
+    size_t size() const { return fROIs.n_ranges(); }
+
+  private:
+    recob::Wire::RegionsOfInterest_t const& fROIs;
+    unsigned int fChannel;
+  };
+
+  inline WireROIs ROIs(recob::Wire const& wire) { return WireROIs(wire); }
+
+}
+
+#endif
@@ -0,0 +1,166 @@
+//***************************
+//    the "sndaq" ROIs of one event as int16 ADC counts
+//***************************
+
+#include "RawROIStore.hh"
+#include "ROIView.h"
+
+//some standard C++ includes
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // an sndaq sample we can give back exactly from an int16 (as in SNROICache)
+  inline bool IsADC(float v){
+    return v >= -32768.f && v <= 32767.f && std::nearbyint(v) == v && !(v == 0 && std::signbit(v));
+  }
+
+}
+
+void sn::RawROIStore::clear()
+{
+  fChannel.clear();
+  fWireROI.assign(1, 0);
+  fFirstTick.clear();
+  fLength.clear();
+  fSample0.assign(1, 0);
+  fFlags.clear();
+  fADC.clear();
+  fBad.clear();
+  fBadIndex.clear();
+  fBadValue.clear();
+}
+
+void sn::RawROIStore::Fill(std::vector<recob::Wire> const& wires)
+{
+  clear();
+
+  // the sizes first, so nothing moves while the samples go in
+  size_t nROIs = 0, nSamples = 0;
+  for(auto const& wire : wires){
+    for(auto const& roi : sn::ROIs(wire)){
+      nROIs++;
+      nSamples += roi.length;
+    }
+  }
+  fChannel.reserve(wires.size());
+  fWireROI.reserve(wires.size()+1);
+  fFirstTick.reserve(nROIs);
+  fLength.reserve(nROIs);
+  fSample0.reserve(nROIs+1);
+  fFlags.reserve(nROIs);
+  fADC.resize(nSamples);
+  fBad.assign((nSamples + 63)/64, 0);
+
+  uint64_t sample = 0;
+  for(auto const& wire : wires){
+    fChannel.push_back(wire.Channel());
+    for(auto const& roi : sn::ROIs(wire)){
+      fFirstTick.push_back(roi.firstTick);
+      fLength.push_back(roi.length);
+
+      fFlags.push_back(PutSamples(roi.samples, roi.length, sample));
+      sample += roi.length;
+      fSample0.push_back(sample);
+    }
+    fWireROI.push_back(fFirstTick.size());
+  }
+}
+
+uint8_t sn::RawROIStore::PutSamples(float const* samples, size_t n, uint64_t sample)
+{
+  uint8_t flags = kNarrow;
+  int16_t* adc = fADC.data() + sample;
+  for(size_t k=0; k<n; k++){
+    const float v = samples ? samples[k] : 0.f;
+    if(IsADC(v)){
+      adc[k] = int16_t(v);
+      if(adc[k] < -8192 || adc[k] > 8191) flags &= ~kNarrow;
+      continue;
+    }
+    adc[k] = 0;
+    flags |= kHasBad;
+    fBad[(sample+k)/64] |= uint64_t(1) << ((sample+k)%64);
+    fBadIndex.push_back(sample+k);
+    fBadValue.push_back(v);
+  }
+  return flags;
+}
+
+void sn::RawROIStore::AddWire(unsigned int channel)
+{
+  fChannel.push_back(channel);
+  fWireROI.push_back(fFirstTick.size());
+}
+
+void sn::RawROIStore::AddROI(size_t firstTick, int16_t const* adc, size_t length)
+{
+  const uint64_t sample = fSample0.back();
+  fFirstTick.push_back(firstTick);
+  fLength.push_back(length);
+  fADC.insert(fADC.end(), adc, adc + length);
+  fBad.resize((fADC.size() + 63)/64, 0);
+
+  uint8_t flags = kNarrow;
+  for(size_t k=0; k<length; k++)
+    if(adc[k] < -8192 || adc[k] > 8191){ flags &= ~kNarrow; break; }
+  fFlags.push_back(flags);
+  fSample0.push_back(sample + length);
+  fWireROI.back() = fFirstTick.size();
+}
+
+void sn::RawROIStore::AddROI(size_t firstTick, float const* samples, size_t length)
+{
+  const uint64_t sample = fSample0.back();
+  fFirstTick.push_back(firstTick);
+  fLength.push_back(length);
+  fADC.resize(sample + length);
+  fBad.resize((fADC.size() + 63)/64, 0);
+  fFlags.push_back(PutSamples(samples, length, sample));
+  fSample0.push_back(sample + length);
+  fWireROI.back() = fFirstTick.size();
+}
+
+void sn::RawROIStore::GetWires(std::vector<recob::Wire>& wires, size_t nTicks) const
+{
+  wires.clear();
+  wires.reserve(NWires());
+  std::vector<float> samples;
+  for(size_t w=0; w<NWires(); w++){
+    recob::Wire::RegionsOfInterest_t rois;
+    rois.resize(nTicks);
+    for(size_t r=FirstROI(w); r<EndROI(w); r++){
+      GetFloats(r, samples);
+      rois.add_range(FirstTick(r), samples);
+    }
+    // MicroBooNE: U 0-2399, V 2400-4799, Y from 4800 on
+    const unsigned int channel = Channel(w);
+    const geo::View_t view = channel < 2400 ? geo::kU : (channel < 4800 ? geo::kV : geo::kZ);
+    wires.emplace_back(rois, channel, view);
+  }
+}
+
+float sn::RawROIStore::BadValue(uint64_t sample) const
+{
+  const auto it = std::lower_bound(fBadIndex.begin(), fBadIndex.end(), sample);
+  return fBadValue[it - fBadIndex.begin()];
+}
+
+void sn::RawROIStore::GetFloats(size_t roi, std::vector<float>& out) const
+{
+  const size_t n = Length(roi);
+  int16_t const* adc = ADC(roi);
+  out.resize(n);
+  for(size_t k=0; k<n; k++) out[k] = adc[k];
+  if(HasBad(roi))
+    for(size_t k=0; k<n; k++) if(IsBad(roi, k)) out[k] = BadValue(fSample0[roi] + k);
+}
+
+size_t sn::RawROIStore::Bytes() const
+{
+  return fChannel.capacity()*sizeof(unsigned int) + fWireROI.capacity()*sizeof(uint64_t)
+    + (fFirstTick.capacity() + fLength.capacity())*sizeof(uint32_t) + fSample0.capacity()*sizeof(uint64_t)
+    + fFlags.capacity() + fADC.capacity()*sizeof(int16_t) + fBad.capacity()*sizeof(uint64_t)
+    + fBadIndex.capacity()*sizeof(uint64_t) + fBadValue.capacity()*sizeof(float);
+}
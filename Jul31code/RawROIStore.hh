@@ -0,0 +1,98 @@
+//***************************
+//    the "sndaq" ROIs of one event as int16 ADC counts
+//
+//    the raw wires are 12 bit ADC counts stored as floats. RawROIStore converts
+//    them once per event into one int16 array (half the memory and bandwidth,
+//    twice the lanes per vector), ROI after ROI, with the wire and ROI tables
+//    next to it. A sample that is not an ADC count (the 1e-44 swizzler errors,
+//    NaN, anything not a whole number in the int16 range) is stored as 0, flagged
+//    in a bitmask, and kept as it was on the side, so Sample() still gives back
+//    exactly the float of the wire.
+//***************************
+
+#ifndef SN_RAWROISTORE_HH
+#define SN_RAWROISTORE_HH
+
+//some standard C++ includes
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+namespace sn{
+
+  class RawROIStore{
+
+  public:
+    RawROIStore() { clear(); }
+
+    // the store of these wires, replacing what was there (the memory is kept for the next event)
+    void Fill(std::vector<recob::Wire> const& wires);
+    void clear();
+
+    // or one wire at a time (SNStream): a wire, then its ROIs in order
+    void AddWire(unsigned int channel);
+    void AddROI(size_t firstTick, int16_t const* adc, size_t length);
+    // the same from floats, the ones that are not ADC counts go to the side as in Fill
+    void AddROI(size_t firstTick, float const* samples, size_t length);
+
+    // the wires back as recob::Wire, nTicks long, with the view from the channel number
+    void GetWires(std::vector<recob::Wire>& wires, size_t nTicks) const;
+
+    size_t NWires() const { return fChannel.size(); }
+    size_t NROIs() const { return fFirstTick.size(); }
+    size_t NSamples() const { return fADC.size(); }
+    size_t NBad() const { return fBadIndex.size(); }
+
+    unsigned int Channel(size_t wire) const { return fChannel[wire]; }
+    // the ROIs of wire 'wire' are FirstROI(wire) ... EndROI(wire)-1, in the order of the wire
+    size_t FirstROI(size_t wire) const { return fWireROI[wire]; }
+    size_t EndROI(size_t wire) const { return fWireROI[wire+1]; }
+
+    size_t FirstTick(size_t roi) const { return fFirstTick[roi]; }
+    size_t Length(size_t roi) const { return fLength[roi]; }
+    // Length(roi) samples, the flagged ones as 0
+    int16_t const* ADC(size_t roi) const { return fADC.data() + fSample0[roi]; }
+
+    // does the ROI have samples that are not ADC counts?
+    bool HasBad(size_t roi) const { return fFlags[roi] & kHasBad; }
+    // are all its samples within [-8192,8191], so that the int16 kernels can't overflow?
+    bool Narrow(size_t roi) const { return fFlags[roi] & kNarrow; }
+    bool IsBad(size_t roi, size_t k) const {
+      const uint64_t i = fSample0[roi] + k;
+      return (fBad[i/64] >> (i%64)) & 1;
+    }
+
+    // sample k of the ROI (0 ... Length(roi)-1), exactly the float of the wire
+    float Sample(size_t roi, size_t k) const {
+      return IsBad(roi, k) ? BadValue(fSample0[roi] + k) : float(ADC(roi)[k]);
+    }
+    // the same for all of them
+    void GetFloats(size_t roi, std::vector<float>& out) const;
+
+    size_t Bytes() const;
+
+  private:
+    enum Flags { kHasBad = 1, kNarrow = 2 };
+
+    float BadValue(uint64_t sample) const;
+    // converts n samples into fADC[sample] ... (already there), flagging the bad ones; returns the flags
+    uint8_t PutSamples(float const* samples, size_t n, uint64_t sample);
+
+    std::vector<unsigned int> fChannel;   // per wire
+    std::vector<uint64_t> fWireROI;       // nWires+1
+    std::vector<uint32_t> fFirstTick;     // per ROI
+    std::vector<uint32_t> fLength;
+    std::vector<uint64_t> fSample0;       // nROIs+1
+    std::vector<uint8_t> fFlags;
+    std::vector<int16_t> fADC;            // per sample
+    std::vector<uint64_t> fBad;           // bit per sample
+    std::vector<uint64_t> fBadIndex;      // the flagged samples, sorted,
+    std::vector<float> fBadValue;         // and what they were
+  };
+
+}
+
+#endif
@@ -16,7 +16,7 @@
 #include <stdlib.h>
 #include <string>
 #include <vector>
-#include <chrono>
+#include <memory>
 
 //some ROOT includes
 #include "TInterpreter.h"
@@ -38,12 +38,16 @@
 //"larsoft" object includes
 #include "lardataobj/RecoBase/Wire.h"
 
+#include "SNOptions.h"
+#include "EventImage.hh"
+#include "EventPyramid.hh"
+#include "SNMemory.hh"
+#include "SNMetrics.hh"
+
 //convenient for us! let's not bother with art and std namespaces!
 using namespace art;
 using namespace std;
 
-using namespace std::chrono;
-
 
 
 int main(int argc, char** argv) {
@@ -52,7 +56,8 @@ int main(int argc, char** argv) {
   
   //We specify our files in a list of file names!
   //Note: multiple files allowed. Just separate by comma.
-  vector<string> filenames { argv[1] };
+  sn::SNOptions opt = sn::ParseOptions(argc, argv);
+  vector<string> filenames = opt.filenames;   // lists, globs and @list.txt too
 
   //We need to specify the "input tag" for our collection of optical flashes.
   //This is like the module label, except it can also include process name
@@ -80,7 +85,8 @@ int main(int argc, char** argv) {
   //
   //In a for loop, that looks like this:
 
-  size_t _maxEvts = 100;
+  size_t _maxEvts = opt.maxEvents ? opt.maxEvents : 100;   // -n 500 for the 500 event overlay
+  if(!opt.metricsFile.empty()) sn::SNMetrics::Enable();   // -T: where the time goes
   size_t evCtr = 0;
 	
 // canvas to draw histograns to
@@ -88,15 +94,23 @@ int main(int argc, char** argv) {
   TCanvas *c5 = new TCanvas("c5","c5",1000,600);
   
 	
-// histogram that will plot 100 events together	
-  TH2F* allevent = new TH2F("all","100 events; Channel; Tick",8256,0,8256,6400,0,6400); 
-  allevent->GetXaxis()->SetRangeUser(0,8256);
-  allevent->GetZaxis()->SetRangeUser(0,120000);
+// image that will plot 100 events together	
+// (the ROIs added as they are, no zero padding; the TH2F "all" is made from it for drawing)
+  sn::EventImage allevent(8256,6400);
+
+// the overlay after every event, as a pyramid from level 3 (1032 x 800 cells) on: the frames of
+// the animation, drawn afterwards by renderframes, in parallel and away from this loop
+  const string framesFile = Form("%zuevents_frames.snpyr", _maxEvts);
+  sn::EventPyramidWriter frames(framesFile, 8256, 6400, 3);
+
+// each event on its own as a display pyramid, for DrawEventPyramid.cc (-P file)
+  std::unique_ptr<sn::EventPyramidWriter> pyramid;
+  if(!opt.pyramidFile.empty()) pyramid.reset(new sn::EventPyramidWriter(opt.pyramidFile, 8256, 6400));
   
   for (gallery::Event ev(filenames) ; !ev.atEnd(); ev.next()) {
     if(evCtr >= _maxEvts) break;
 
-    auto t_begin = high_resolution_clock::now();
+    sn::SNEventTimer eventTimer;
 
     // int run = ev.eventAuxiliary().run();
     //int event = ev.eventAuxiliary().event();
@@ -109,7 +123,11 @@ int main(int argc, char** argv) {
     //Now, we want to get a "valid handle" (which is like a pointer to our collection")
     //We use auto, cause it's annoying to write out the fill type. But it's like
     //vector<recob::Wire>* object.
-    auto const& wire_handle = ev.getValidHandle< vector<recob::Wire> >(wire_tag);
+    vector<recob::Wire> const* wire_handle;
+    {
+      sn::ScopedTimer timer(sn::kRead);
+      wire_handle = ev.getValidHandle< vector<recob::Wire> >(wire_tag).product();
+    }
 
     //We can now treat this like a pointer, or dereference it to have it be like a vector.
     //I (Wes) for some reason prefer the latter, so I always like to do ...
@@ -141,21 +159,27 @@ int main(int argc, char** argv) {
     //the 'source' directory. Look at that file and see what you can access.
 
     cout << "Beginning of loop over wires" << endl;
+
+    sn::EventImage thisevent(8256,6400);
+    size_t nROIs = 0;
     
     //We can use a range-based for loop for ease.
+    { sn::ScopedTimer timer(sn::kFill);   // the images
     for( auto const& wire : wire_vec){
       //cout << "\nwire.Signal().size() " << wire.Signal().size();
       //cout << "\nwire.NSignal() " << wire.NSignal();
       //cout << "\nwire.View() " << wire.View();
-      int channel = wire.Channel();
+      //int channel = wire.Channel();
       //cout << "\nwire.Channel() " << channel << endl;
       // test SignalROI()
 
+      //to plot all events overlapped: straight from the ROIs, without the zero-padded wire.Signal() copy
+      allevent.AddWire(wire);
+      if(pyramid) thisevent.AddWire(wire);
+      nROIs += wire.SignalROI().n_ranges();
       // Loop over the zero-padded vector
-      std::vector<float> zeroPaddedWire = wire.Signal();
-      for( size_t tick = 0; tick < zeroPaddedWire.size(); tick++ ){
-	//to plot all events overlapped
-	allevent->Fill(channel, tick, zeroPaddedWire[tick]);
+      //std::vector<float> zeroPaddedWire = wire.Signal();
+      //for( size_t tick = 0; tick < zeroPaddedWire.size(); tick++ ){
 	// fill each plane separately
 	//if (channel <= 2400)
 	//{hTickWireu->Fill(channel, tick, zeroPaddedWire[tick]);}
@@ -163,17 +187,19 @@ int main(int argc, char** argv) {
 	// {hTickWirev->Fill(channel, tick, zeroPaddedWire[tick]);}
 	//else  
 	//{hTickWirey->Fill(channel, tick, zeroPaddedWire[tick]);}
-      }
+      //}
     } //cout << "End of loop over wires" << endl;
+    }
+
+    sn::ScopedTimer writeTimer(sn::kWrite);   // the display and the frame, to the end of the event
+    if(pyramid) pyramid->AddEvent(ev.eventAuxiliary().run(), ev.eventAuxiliary().event(), thisevent);
 
     f_output.cd();
         
     //cout << "Drawing u plane" << endl;
 
-    c5->cd();
-    allevent->Draw("colz");
-    gStyle->SetOptStat(0);
-    c5->Print("100events.gif+30");
+    // the events so far, one frame of the animation
+    frames.AddEvent(ev.eventAuxiliary().run(), ev.eventAuxiliary().event(), allevent);
 
     // c4->cd(1);
     //hTickWireu->Draw("colz");
@@ -207,14 +233,21 @@ int main(int argc, char** argv) {
     //delete c4;
     //delete allevent;
 
-    auto t_end = high_resolution_clock::now();
-    duration<double,std::milli> time_total_ms(t_end-t_begin);
-    //cout << "\tEvent took " << time_total_ms.count() << " ms to process." << endl;
+    if(eventTimer) eventTimer.Done(sn::WireBytes(wire_vec), nROIs, sn::WireBytes(wire_vec));
     evCtr++;
   } //end loop over events!
 
   //  //only for overlapping plot
   f_output.cd();
+  // the final overlay, with its statistics, is the one written
+  const string title = Form("%zu events; Channel; Tick", _maxEvts);
+  TH2F* frame = allevent.MakeTH2F("all", title.c_str()).release();
+  frame->GetXaxis()->SetRangeUser(0,8256);
+  frame->GetZaxis()->SetRangeUser(0,120000);
+  c5->cd();
+  frame->Draw("colz");
+  gStyle->SetOptStat(0);
+  c5->Print(Form("%zuevents.png", _maxEvts));
   //c4->cd();
   //allevent->Draw("colz");
   //gStyle->SetOptStat(0);
@@ -223,9 +256,24 @@ int main(int argc, char** argv) {
   //delete c4;
   //delete allevent;
 
-  c5->Print("100events.gif++");
+  frames.Close();
+  cout << "wrote " << frames.NEvents() << " frames to " << framesFile << ", for the animation: renderframes "
+       << framesFile << " " << Form("%zuevents.gif", _maxEvts) << endl;
+  if(pyramid){
+    pyramid->Close();
+    cout << "wrote " << pyramid->NEvents() << " event displays (" << pyramid->NTiles() << " tiles, "
+         << pyramid->Bytes()/(1<<20) << " MB) to " << opt.pyramidFile << endl;
+  }
  //and ... write to file!
   f_output.Write();
   f_output.Close();
 
+  if(sn::SNMetrics::Enabled()){
+    sn::SNMetrics::Report(cout);
+    if(opt.metricsFile != "-"){
+      sn::SNMetrics::Write(opt.metricsFile);
+      cout << "wrote the metrics to " << opt.metricsFile << endl;
+    }
+  }
+
 }
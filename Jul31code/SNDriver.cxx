@@ -0,0 +1,455 @@
+//***************************
+//    single pass driver for the SN wire analyses
+//***************************
+
+#include "SNDriver.hh"
+#include "RawROIStore.hh"
+#include "SNMetrics.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+
+//some ROOT includes
+#include "TH1.h"
+
+//"art" includes (canvas, and gallery)
+#include "gallery/Event.h"
+#include "gallery/ValidHandle.h"
+
+sn::SNDriver::SNDriver()
+  //Check the contents of your file by setting up a version of uboonecode, and
+  //running an event dump:
+  //  'lar -c eventdump.fcl -s MyInputFile_1.root -n 1'
+  : fWireTag { "sndaq", "", "SupernovaAssembler" }   // before deconvolution
+  , fWireTagDecon { "sndeco", "", "CalDataSN" }     // after deconvolution
+  , fNWorkers(1)
+  , fNChannelThreads(1)
+  , fPrefetchDepth(0)
+  , fPrefetchBytes(0)
+  , fMetrics(false)
+  , fMaxEvents(0)
+{}
+
+sn::SNDriver::~SNDriver()
+{
+  // histograms go before the files they live in
+  fPool.reset();
+  fStages.clear();
+  fFiles.clear();
+}
+
+void sn::SNDriver::SetMetrics(std::string const& report)
+{
+  fMetrics = true;
+  fMetricsFile = report == "-" ? "" : report;
+}
+
+namespace {
+
+  // what an event counts for in the metrics
+  size_t CountROIs(sn::SNEvent const& evt){
+    if(evt.raw) return evt.raw->NROIs();
+    size_t nROIs = 0;
+    for(auto const& wire : *evt.wires) nROIs += wire.SignalROI().n_ranges();
+    return nROIs;
+  }
+
+  size_t ProductBytes(sn::SNEvent const& evt){
+    return sn::WireBytes(*evt.wires) + (evt.wires_d ? sn::WireBytes(*evt.wires_d) : 0);
+  }
+
+}
+
+void sn::SNDriver::CheckStage(std::string const& output_name, size_t bytes) const
+{
+  MemoryBudget::Book(output_name.empty() ? "(no file)" : output_name, bytes);
+  MemoryBudget::Release(bytes);   // booked for real by BookStage(), once it is constructed
+}
+
+void sn::SNDriver::BookStage(std::string const& output_name, std::vector<TH1*> const& hists)
+{
+  size_t bytes = 0;
+  for(TH1 const* h : hists) bytes += HistBytes(*h);
+  fStageNames.push_back(output_name.empty() ? "(no file)" : output_name);
+  fBookedBytes.push_back(bytes);
+  MemoryBudget::Book(fStageNames.back(), bytes, hists);
+}
+
+size_t sn::SNDriver::WorkerBytes() const
+{
+  size_t bytes = 0;   // each worker books the same as the stages did
+  for(size_t b : fBookedBytes) bytes += b;
+  return bytes;
+}
+
+size_t sn::SNDriver::WorkersInBudget(size_t nWorkers) const
+{
+  const size_t bytes = WorkerBytes();
+  size_t n = 0;
+  while(n < nWorkers && MemoryBudget::TryBook(bytes)) n++;
+  if(n >= 2) return n;
+  MemoryBudget::Release(n*bytes);   // on one thread the booked stages do it themselves
+  return 1;
+}
+
+void sn::SNDriver::ReleaseWorkers(size_t nWorkers) const
+{
+  MemoryBudget::Release(nWorkers*WorkerBytes());
+}
+
+void sn::SNDriver::cdStage(size_t i_s)
+{
+  if(fFiles[i_s]) fFiles[i_s]->cd();
+  else gROOT->cd();
+}
+
+bool sn::SNDriver::CanRunParallel() const
+{
+  for(auto const& stage : fStages)
+    if(!stage->RunsInParallel()) return false;
+  return true;
+}
+
+bool sn::SNDriver::WantEntry(std::vector<SNStage*> const& stages, size_t entry, bool& needDecon) const
+{
+  bool needWires = false;
+  needDecon = false;
+  for(auto const* stage : stages){
+    if(entry >= MaxEvents(*stage)) continue;
+    needWires = true;
+    if(stage->UsesDeconvolved()) needDecon = true;
+  }
+  return needWires;
+}
+
+void sn::SNDriver::ProcessStages(std::vector<SNStage*> const& stages, SNEvent& evt, bool cdFiles, RawROIStore& raw)
+{
+  // the int16 copy of the raw wires, made once if any stage of this event reads it (a stream has it already)
+  for(auto const* stage : stages){
+    if(evt.raw) break;
+    if(evt.entry >= MaxEvents(*stage) || !stage->UsesRawStore()) continue;
+    ScopedTimer timer(kDecode);
+    raw.Fill(*evt.wires);
+    evt.raw = &raw;
+    break;
+  }
+
+  for(size_t i_s=0; i_s<stages.size(); i_s++){
+    if(evt.entry >= MaxEvents(*stages[i_s])) continue;
+    if(cdFiles) cdStage(i_s);
+    stages[i_s]->ProcessEvent(evt);
+  }
+}
+
+void sn::SNDriver::EventLoop(std::vector<std::string> const& filenames,
+                             std::vector<SNStage*> const& stages,
+                             size_t worker, size_t nWorkers, bool cdFiles,
+                             ChannelPool* pool, size_t firstEntry)
+{
+  if(fCache){
+    CacheEventLoop(stages, worker, nWorkers, cdFiles, pool);
+    return;
+  }
+
+  if(fStream){
+    StreamEventLoop(stages, worker, nWorkers, cdFiles, pool);
+    return;
+  }
+
+  if(fPrefetchDepth > 0){
+    PrefetchEventLoop(filenames, stages, worker, nWorkers, cdFiles, pool, firstEntry);
+    return;
+  }
+
+  RawROIStore raw;   // reused from event to event
+  size_t entry = firstEntry;
+  for (gallery::Event ev(filenames) ; !ev.atEnd(); ev.next(), entry++) {
+
+    // stop reading once every stage has seen all the events it wants
+    bool needDecon = false;
+    if(!WantEntry(stages, entry, needDecon)) break;
+
+    // somebody else's event
+    if(entry % nWorkers != worker) continue;
+
+    SNEventTimer eventTimer;
+    SNEvent evt;
+    evt.entry = entry;
+    evt.run = ev.eventAuxiliary().run();
+    evt.event = ev.eventAuxiliary().event();
+    evt.pool = pool;
+
+    // the one and only read/decode of the wires for this event
+    {
+      ScopedTimer timer(kRead);
+      evt.wires = ev.getValidHandle< std::vector<recob::Wire> >(fWireTag).product();
+      evt.wires_d = nullptr;
+      evt.raw = nullptr;
+      if(needDecon)
+        evt.wires_d = ev.getValidHandle< std::vector<recob::Wire> >(fWireTagDecon).product();
+    }
+
+    ProcessStages(stages, evt, cdFiles, raw);
+    if(eventTimer){
+      const size_t bytes = ProductBytes(evt);   // what was read is what is in memory
+      eventTimer.Done(bytes, CountROIs(evt), bytes);
+    }
+  } //end loop over events!
+}
+
+void sn::SNDriver::PrefetchEventLoop(std::vector<std::string> const& filenames,
+                                     std::vector<SNStage*> const& stages,
+                                     size_t worker, size_t nWorkers, bool cdFiles,
+                                     ChannelPool* pool, size_t firstEntry)
+{
+  // the same selection as EventLoop, only on the read-ahead thread
+  EventPrefetcher prefetcher(filenames, fWireTag, fWireTagDecon,
+                             [this, &stages](size_t entry, bool& needDecon){ return WantEntry(stages, entry, needDecon); },
+                             fPrefetchDepth, fPrefetchBytes, firstEntry, worker, nWorkers);
+
+  RawROIStore raw;
+  std::unique_ptr<PrefetchedEvent> pe;
+  for(;;){
+    // the latency counts from when we start waiting for the event
+    SNEventTimer eventTimer;
+    {
+      ScopedTimer timer(kRead);
+      if(!prefetcher.Next(pe)) break;
+    }
+
+    SNEvent evt;
+    evt.entry = pe->entry;
+    evt.run = pe->run;
+    evt.event = pe->event;
+    evt.pool = pool;
+    evt.wires = &pe->wires;
+    evt.wires_d = pe->hasDecon ? &pe->wires_d : nullptr;
+    evt.raw = nullptr;
+
+    ProcessStages(stages, evt, cdFiles, raw);
+    if(eventTimer) eventTimer.Done(pe->bytes, CountROIs(evt), pe->bytes);
+  }
+}
+
+void sn::SNDriver::CacheEventLoop(std::vector<SNStage*> const& stages,
+                                  size_t worker, size_t nWorkers, bool cdFiles,
+                                  ChannelPool* pool)
+{
+  // every worker rebuilds its events into its own vectors, the mapped file is shared
+  std::vector<recob::Wire> wires;
+  std::vector<recob::Wire> wires_d;
+  RawROIStore raw;
+
+  for (size_t entry = worker; entry < fCache->NEvents(); entry += nWorkers) {
+
+    bool needDecon = false;
+    if(!WantEntry(stages, entry, needDecon)) break;
+
+    SNEventTimer eventTimer;
+    SNEvent evt;
+    evt.entry = entry;
+    evt.run = fCache->Run(entry);
+    evt.event = fCache->Event(entry);
+    evt.pool = pool;
+
+    {
+      ScopedTimer timer(kDecode);
+      fCache->GetWires(entry, SNROICache::kRaw, wires);
+      evt.wires = &wires;
+      evt.wires_d = nullptr;
+      evt.raw = nullptr;
+      if(needDecon){
+        fCache->GetWires(entry, SNROICache::kDecon, wires_d);
+        evt.wires_d = &wires_d;
+      }
+    }
+
+    ProcessStages(stages, evt, cdFiles, raw);
+    if(eventTimer){
+      const size_t bytes = ProductBytes(evt);   // what was read is what is in memory
+      eventTimer.Done(bytes, CountROIs(evt), bytes);
+    }
+  }
+}
+
+void sn::SNDriver::StreamEventLoop(std::vector<SNStage*> const& stages,
+                                   size_t worker, size_t nWorkers, bool cdFiles,
+                                   ChannelPool* pool)
+{
+  // decoded straight into the int16 store, the wires are made from it for the stages that want them
+  RawROIStore raw;
+  std::vector<recob::Wire> wires;
+
+  for (size_t entry = worker; entry < fStream->NEvents(); entry += nWorkers) {
+
+    bool needDecon = false;
+    if(!WantEntry(stages, entry, needDecon)) break;
+
+    SNEventTimer eventTimer;
+    SNEvent evt;
+    evt.entry = entry;
+    evt.run = fStream->Run(entry);
+    evt.event = fStream->Event(entry);
+    evt.pool = pool;
+
+    {
+      ScopedTimer timer(kDecode);
+      fStream->GetEvent(entry, raw, pool);
+      raw.GetWires(wires, fStream->NTicks());
+    }
+    evt.wires = &wires;
+    evt.wires_d = nullptr;   // checked in Run(): nobody asks for them
+    evt.raw = &raw;
+
+    ProcessStages(stages, evt, cdFiles, raw);
+    if(eventTimer) eventTimer.Done(fStream->Bytes(entry), raw.NROIs(), raw.Bytes() + WireBytes(wires));
+  }
+}
+
+std::vector<size_t> sn::SNDriver::FirstEntries(std::vector<std::string> const& filenames) const
+{
+  size_t maxEvents = 0;
+  for(auto const& stage : fStages) maxEvents = std::max(maxEvents, MaxEvents(*stage));
+
+  // no need to open the files nobody is going to look at
+  std::vector<size_t> first;
+  size_t entries = 0;
+  for(auto const& filename : filenames){
+    first.push_back(entries);
+    if(entries >= maxEvents) continue;
+    gallery::Event ev({ filename });
+    if(!ev.atEnd()) entries += ev.numberOfEventsInFile();
+  }
+  return first;
+}
+
+void sn::SNDriver::Run(std::vector<std::string> const& filenames)
+{
+  if(fMetrics) SNMetrics::Enable();
+
+  const size_t nStages = fStages.size();
+  std::vector<SNStage*> stages;
+  for(auto const& stage : fStages) stages.push_back(stage.get());
+
+  // an ROI cache made by sncache instead of the art files?
+  fCache.reset();
+  if(filenames.size() == 1 && SNROICache::IsCache(filenames[0])){
+    std::cout << "Reading the wires from the ROI cache " << filenames[0] << std::endl;
+    fCache.reset(new SNROICache(filenames[0]));
+  }
+
+  // or a binary SN stream, which only has the wires before deconvolution
+  fStream.reset();
+  if(filenames.size() == 1 && SNStream::IsStream(filenames[0])){
+    std::cout << "Decoding the SN stream " << filenames[0] << std::endl;
+    fStream.reset(new SNStream(filenames[0]));
+    for(auto const* stage : stages)
+      if(stage->UsesDeconvolved())
+        throw std::runtime_error("SNDriver: " + filenames[0] + " has no deconvolved wires, an analysis needs them");
+  }
+
+  size_t nWorkers = fNWorkers;
+  if(nWorkers > 1 && !CanRunParallel()){
+    std::cout << "Not all the analyses can run event-parallel, using one thread." << std::endl;
+    nWorkers = 1;
+  }
+  if(nWorkers > 1){
+    const size_t fit = WorkersInBudget(nWorkers);
+    if(fit < nWorkers)
+      std::cout << "The histograms of only " << fit << " of the " << nWorkers
+                << " event workers fit in the memory budget, using " << fit << " thread" << (fit > 1 ? "s." : ".") << std::endl;
+    nWorkers = fit;
+  }
+
+  // the read-ahead threads use ROOT next to the stages (the cache is read in place, no need there)
+  if(fCache || fStream) fPrefetchDepth = 0;
+  if(fPrefetchDepth > 0) ROOT::EnableThreadSafety();
+
+  if(nWorkers <= 1){
+    if(fNChannelThreads > 1) fPool.reset(new ChannelPool(fNChannelThreads));
+    EventLoop(filenames, stages, 0, 1, true, fPool.get());
+  }
+  else{
+    ROOT::EnableThreadSafety();
+
+    // every worker fills its own copy of the histograms, none of them in a file
+    const bool addDirectory = TH1::AddDirectoryStatus();
+    TH1::AddDirectory(kFALSE);
+
+    std::vector< std::vector< std::unique_ptr<SNStage> > > workerStages(nWorkers);
+    std::vector< std::vector<SNStage*> > workerPtrs(nWorkers);
+    for(size_t w=0; w<nWorkers; w++){
+      for(size_t i_s=0; i_s<nStages; i_s++){
+        workerStages[w].emplace_back(fStages[i_s]->NewWorker());
+        workerPtrs[w].push_back(workerStages[w].back().get());
+      }
+    }
+
+    std::vector<std::thread> threads;
+    if(!fCache && !fStream && filenames.size() > 1){
+      // a file per worker at a time, each with its own gallery::Event; entry numbers stay
+      // those of the whole list, so MaxEvents() means the same as on one thread.
+      // Worker w always reads files w, w+nWorkers, ..., so every worker gets the same
+      // events on every run and the merges below come out the same each time
+      std::cout << "Reading " << filenames.size() << " files on " << nWorkers << " threads." << std::endl;
+      const std::vector<size_t> firstEntry = FirstEntries(filenames);
+      for(size_t w=0; w<nWorkers; w++)
+        threads.emplace_back([this, &filenames, &workerPtrs, &firstEntry, w, nWorkers](){
+            bool needDecon;
+            for(size_t f = w; f < filenames.size(); f += nWorkers){
+              if(!WantEntry(workerPtrs[w], firstEntry[f], needDecon)) continue;
+              EventLoop({ filenames[f] }, workerPtrs[w], 0, 1, false, nullptr, firstEntry[f]);
+            }
+          });
+    }
+    else{
+      // one input: deal the events out round robin
+      for(size_t w=0; w<nWorkers; w++)
+        threads.emplace_back([this, &filenames, &workerPtrs, w, nWorkers](){
+            EventLoop(filenames, workerPtrs[w], w, nWorkers, false, nullptr);
+          });
+    }
+    for(auto& t : threads) t.join();
+
+    TH1::AddDirectory(addDirectory);
+
+    // add everything up into the booked stages, in worker order, deleting each worker's
+    // copies (their histograms are members, out of any directory) as soon as they are in
+    for(size_t w=0; w<nWorkers; w++){
+      for(size_t i_s=0; i_s<nStages; i_s++)
+        fStages[i_s]->Merge(*workerStages[w][i_s]);
+      workerStages[w].clear();
+      workerPtrs[w].clear();
+    }
+
+    // and their room in the budget goes to the dense TH2s of Finish()
+    ReleaseWorkers(nWorkers);
+  }
+
+  // what the histograms have grown to, before Finish() makes the TH2s
+  if(fMetrics)
+    for(size_t i_s=0; i_s<nStages; i_s++)
+      SNMetrics::AddHistogramSet(fStageNames[i_s], fBookedBytes[i_s], fStages[i_s]->SparseBytes());
+
+  //and ... write to file!
+  for(size_t i_s=0; i_s<nStages; i_s++){
+    ScopedTimer timer(kWrite);
+    cdStage(i_s);
+    fStages[i_s]->Finish();
+    if(fFiles[i_s]){
+      fFiles[i_s]->Write();
+      fFiles[i_s]->Close();
+    }
+  }
+
+  if(fMetrics){
+    SNMetrics::Report(std::cout);
+    if(!fMetricsFile.empty()){
+      SNMetrics::Write(fMetricsFile);
+      std::cout << "wrote the metrics to " << fMetricsFile << std::endl;
+    }
+  }
+}
@@ -0,0 +1,162 @@
+//***************************
+//    single pass driver for the SN wire analyses:
+//    reads every event once and hands the wires to all registered stages
+//***************************
+
+#ifndef SN_SNDRIVER_HH
+#define SN_SNDRIVER_HH
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <set>
+#include <algorithm>
+#include <stdlib.h>
+
+//some ROOT includes
+#include "TROOT.h"
+#include "TFile.h"
+
+//"art" includes (canvas, and gallery)
+#include "canvas/Utilities/InputTag.h"
+
+#include "SNStage.hh"
+#include "ChannelPool.hh"
+#include "SNROICache.hh"
+#include "SNStream.hh"
+#include "EventPrefetcher.hh"
+#include "SNMemory.hh"
+
+namespace sn{
+
+  class SNDriver{
+
+  public:
+    SNDriver();
+    ~SNDriver();
+
+    // opens the stage's output file (no file if the name is empty) and books the stage inside it.
+    // Under a memory budget (SetMemoryBudget) a stage whose histograms don't fit is refused:
+    // std::runtime_error, saying which histograms to make sparse
+    template<typename Stage>
+    Stage& AddStage(std::string const& output_name);
+
+    // with more than one worker the events are dealt out round robin to that many threads
+    // (whole files when there are several input files: worker w reads files w, w+nWorkers, ...),
+    // each with its own gallery::Event and its own copy of the stages, merged into the one
+    // output file at the end.
+    // Only used when every stage supports it (SNStage::RunsInParallel), otherwise we run serially.
+    void SetWorkers(size_t nWorkers) { fNWorkers = nWorkers; }
+
+    // threads to split the wires of each event over, for the stages that use ForEachWireChunk.
+    // Lowers the latency of a single event; only used when running on one event worker.
+    void SetChannelThreads(size_t nThreads) { fNChannelThreads = nThreads; }
+
+    // read up to 'depth' events (and at most maxMB of wires) ahead on a background thread,
+    // per event worker. 0 reads every event when it is its turn
+    void SetPrefetch(size_t depth, size_t maxMB) { fPrefetchDepth = depth; fPrefetchBytes = maxMB << 20; }
+
+    // time the stages and the events of the job (SNMetrics.hh): the summary is printed at
+    // the end of Run(), and written to 'report' (.json or .csv) unless it is empty or "-"
+    void SetMetrics(std::string const& report);
+
+    // at most this much for the histograms (SNMemory.hh); before the stages are added. 0: no limit
+    void SetMemoryBudget(size_t MB) { MemoryBudget::SetLimit(MB << 20); }
+
+    // no stage looks at more than n events, even if its MaxEvents() is more. 0: their own
+    void SetMaxEvents(size_t n) { fMaxEvents = n; }
+
+    // the event loop: every stage sees every event until it has had its MaxEvents() (or SetMaxEvents()'s).
+    // A single file made by sncache is read through SNROICache instead of gallery,
+    // a binary SN stream (snstream, SNStream.hh) is decoded by SNStream.
+    void Run(std::vector<std::string> const& filenames);
+
+  private:
+    art::InputTag fWireTag;
+    art::InputTag fWireTagDecon;
+    size_t fNWorkers;
+    size_t fNChannelThreads;
+    size_t fPrefetchDepth;
+    size_t fPrefetchBytes;
+    bool fMetrics;
+    std::string fMetricsFile;
+    size_t fMaxEvents;
+
+    // the files have to outlive the histograms booked in them, so they are declared first
+    std::vector< std::unique_ptr<TFile> > fFiles;
+    std::vector< std::unique_ptr<SNStage> > fStages;
+    std::unique_ptr<ChannelPool> fPool;
+    std::unique_ptr<SNROICache> fCache;
+    std::unique_ptr<SNStream> fStream;
+    std::vector<std::string> fStageNames;
+    std::vector<size_t> fBookedBytes;   // by the constructor of each stage, in its output file
+
+    void cdStage(size_t i_s);
+    // the events the stage gets: its MaxEvents(), capped by SetMaxEvents()
+    size_t MaxEvents(SNStage const& stage) const {
+      return fMaxEvents ? std::min(fMaxEvents, stage.MaxEvents()) : stage.MaxEvents();
+    }
+    // throws like BookStage() if a stage booking about 'bytes' would not fit in the budget
+    void CheckStage(std::string const& output_name, size_t bytes) const;
+    // counts (and books under the budget) the histograms the last stage booked in gDirectory
+    void BookStage(std::string const& output_name, std::vector<TH1*> const& hists);
+    // how many event workers' copies of the stages fit in the memory budget, at most nWorkers;
+    // they stay booked until ReleaseWorkers()
+    size_t WorkersInBudget(size_t nWorkers) const;
+    void ReleaseWorkers(size_t nWorkers) const;
+    size_t WorkerBytes() const;   // what one worker's copy of the stages books
+    bool CanRunParallel() const;
+
+    // entry number of the first event of each file within the whole list
+    // (only counted as far as any stage wants to go)
+    std::vector<size_t> FirstEntries(std::vector<std::string> const& filenames) const;
+
+    // does any stage still want this entry, and does one of them want the deconvolved wires?
+    bool WantEntry(std::vector<SNStage*> const& stages, size_t entry, bool& needDecon) const;
+    void ProcessStages(std::vector<SNStage*> const& stages, SNEvent& evt, bool cdFiles, RawROIStore& raw);
+
+    // loop over the events of one worker: entries worker, worker+nWorkers, ...
+    // cdFiles is set for the booked stages, whose histograms live in the output files.
+    // firstEntry is the entry number of the first event of filenames within the whole input
+    void EventLoop(std::vector<std::string> const& filenames,
+                   std::vector<SNStage*> const& stages,
+                   size_t worker, size_t nWorkers, bool cdFiles,
+                   ChannelPool* pool, size_t firstEntry = 0);
+    // the same, with the wires read ahead by an EventPrefetcher
+    void PrefetchEventLoop(std::vector<std::string> const& filenames,
+                           std::vector<SNStage*> const& stages,
+                           size_t worker, size_t nWorkers, bool cdFiles,
+                           ChannelPool* pool, size_t firstEntry);
+    // the same, reading fCache
+    void CacheEventLoop(std::vector<SNStage*> const& stages,
+                        size_t worker, size_t nWorkers, bool cdFiles,
+                        ChannelPool* pool);
+    // the same, decoding fStream
+    void StreamEventLoop(std::vector<SNStage*> const& stages,
+                         size_t worker, size_t nWorkers, bool cdFiles,
+                         ChannelPool* pool);
+  };
+
+}
+
+template<typename Stage>
+Stage& sn::SNDriver::AddStage(std::string const& output_name)
+{
+  TFile* f_output = nullptr;
+  if(!output_name.empty())
+    f_output = new TFile(output_name.c_str(),"RECREATE"); // becomes gDirectory, so the stage's histograms go in it
+  else
+    gROOT->cd();
+  fFiles.emplace_back(f_output);
+
+  // refused on the estimate before the histograms are allocated, then booked with what they really take
+  CheckStage(output_name, Stage::BookingBytes());
+  const std::vector<TH1*> booked = BookedHists(gDirectory);
+  const std::set<TH1*> before(booked.begin(), booked.end());
+  Stage* stage = new Stage();
+  fStages.emplace_back(stage);
+  BookStage(output_name, BookedHists(gDirectory, before));
+  return *stage;
+}
+
+#endif
@@ -0,0 +1,177 @@
+//***************************
+//    synthetic "sndaq" events, for benchmarks and tests without MicroBooNE files
+//***************************
+
+#include "SNGenerator.hh"
+#include "ROIBaseline.hh"
+
+//some standard C++ includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+  // splitmix64: the seeds of the channels, and the random numbers within one
+  inline uint64_t Mix(uint64_t x){
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  struct Rng{
+    uint64_t state;
+    explicit Rng(uint64_t seed) : state(seed) {}
+    uint64_t Next() { return Mix(state++); }
+    double Uniform() { return (Next() >> 11)*(1.0/9007199254740992.0); }   // [0,1)
+  };
+
+  inline uint64_t ChannelSeed(uint64_t seed, size_t event, unsigned int channel){
+    return Mix(Mix(Mix(seed) ^ event) ^ channel);
+  }
+
+  // samples until the next swizzler error, for a probability p per sample
+  inline size_t DenormalGap(Rng& rng, double p){
+    if(p <= 0) return std::numeric_limits<size_t>::max();
+    if(p >= 1) return 0;
+    const double gap = std::floor(std::log(1 - rng.Uniform())/std::log1p(-p));
+    return gap < 1e18 ? size_t(gap) : std::numeric_limits<size_t>::max();
+  }
+
+}
+
+sn::SNGenerator::SNGenerator(SNGeneratorConfig const& config)
+  : fConfig(config)
+  , fNoise(kNoise)
+  , fShapes(2*kWidths*kShapeTicks, 0)
+  , fLength(kWidths)
+{
+  // the noise, Box-Muller from its own stream of the seed
+  Rng rng(Mix(fConfig.seed ^ 0x6e6f697365ULL));
+  for(size_t i=0; i<kNoise; i+=2){
+    const double r = std::sqrt(-2*std::log(1 - rng.Uniform()));
+    const double phi = 2*M_PI*rng.Uniform();
+    fNoise[i] = std::lrint(fConfig.noiseRMS*r*std::cos(phi));
+    fNoise[i+1] = std::lrint(fConfig.noiseRMS*r*std::sin(phi));
+  }
+
+  // the pulses: a gaussian on the collection plane, its derivative (positive lobe first) on the
+  // induction planes, +-4 sigma around the middle
+  for(size_t w=0; w<kWidths; w++){
+    const double sigma = fConfig.widthMin + (fConfig.widthMax - fConfig.widthMin)*(w + 0.5)/kWidths;
+    fLength[w] = std::min<size_t>(kShapeTicks, std::ceil(8*sigma) + 1);
+    const double middle = (fLength[w] - 1)/2.;
+    for(size_t k=0; k<fLength[w]; k++){
+      const double x = (k - middle)/sigma;
+      fShapes[(0*kWidths + w)*kShapeTicks + k] = std::exp(-x*x/2);
+      fShapes[(1*kWidths + w)*kShapeTicks + k] = -x*std::exp(-(x*x - 1)/2);
+    }
+  }
+}
+
+void sn::SNGenerator::Generate(size_t event, RawROIStore& store, SNTruth* truth) const
+{
+  store.clear();
+  if(truth) truth->clear();
+  Scratch scratch;
+  for(size_t channel=0; channel<fConfig.nChannels; channel++)
+    GenerateChannel(event, channel, scratch, store, truth);
+}
+
+void sn::SNGenerator::GenerateChannel(size_t event, unsigned int channel, Scratch& scratch,
+                                      RawROIStore& store, SNTruth* truth) const
+{
+  Rng rng(ChannelSeed(fConfig.seed, event, channel));
+  store.AddWire(channel);
+  if(fConfig.roisPerChannel <= 0) return;
+
+  // MicroBooNE: U 0-2399, V 2400-4799, Y from 4800 on
+  const bool collection = channel >= 4800;
+  const float planeBaseline = channel < 2400 ? fConfig.baselineU : (collection ? fConfig.baselineY : fConfig.baselineV);
+  const int baseline = std::lrint(planeBaseline + fConfig.baselineSpread*(2*rng.Uniform() - 1));
+  const double meanGap = fConfig.nTicks/fConfig.roisPerChannel;
+  auto gap = [&rng, meanGap](){ return size_t(-meanGap*std::log(1 - rng.Uniform())); };
+  size_t untilDenormal = DenormalGap(rng, fConfig.denormalProbability);
+
+  for(size_t t = gap(); ; ){
+    const size_t w = rng.Next() % kWidths;
+    const size_t length = fLength[w];
+    const size_t total = kZSPresamples + length + kZSPostsamples;
+    if(t + total > fConfig.nTicks) break;
+
+    // cut at a frame boundary (an ROI is much shorter than a frame, so there is at most one)
+    size_t cut = total;
+    for(size_t b : fConfig.frameBoundaries)
+      if(b > t && b < t + total) cut = b - t;
+
+    // baseline + noise, and the pulse between the pre- and postsamples
+    const float amplitude = fConfig.amplitudeMin + (fConfig.amplitudeMax - fConfig.amplitudeMin)*rng.Uniform();
+    float const* shape = &fShapes[((collection ? 0 : 1)*kWidths + w)*kShapeTicks];
+    scratch.adc.resize(total);
+    int16_t* adc = scratch.adc.data();
+    for(size_t k=0; k<total; k+=5){   // 5 noise samples from the 12 bit pieces of one number
+      uint64_t bits = rng.Next();
+      for(size_t j=k; j<k+5 && j<total; j++, bits >>= 12) adc[j] = baseline + fNoise[bits & (kNoise - 1)];
+    }
+    for(size_t k=0; k<length; k++){   // rounded half away from 0, without a call into libm
+      const float v = amplitude*shape[k];
+      adc[kZSPresamples + k] += int(v < 0 ? v - 0.5f : v + 0.5f);
+    }
+
+    if(rng.Uniform() < fConfig.flipProbability){
+      const size_t k = kZSPresamples + rng.Next() % length;
+      const int bit = fConfig.flipMinBit + rng.Next() % (fConfig.flipMaxBit - fConfig.flipMinBit + 1);
+      adc[k] ^= int16_t(1 << bit);
+      if(truth && k != cut) truth->flips.push_back(SNFlipTruth{ channel, t + k, bit });   // not on the sample dropped below
+    }
+
+    scratch.denormals.clear();
+    for(size_t k = 0; untilDenormal < total - k; ){
+      k += untilDenormal;
+      scratch.denormals.push_back(k++);
+      untilDenormal = DenormalGap(rng, fConfig.denormalProbability);
+    }
+    if(scratch.denormals.empty()) untilDenormal -= total;
+    else untilDenormal -= total - scratch.denormals.back() - 1;
+
+    // the part after the boundary starts a tick later, without the sample on the boundary:
+    // sparse_vector::add_range joins adjacent ranges, so GetWires would make one ROI of them again
+    const size_t second = std::min(cut + 1, total);
+    const size_t nFirst = std::lower_bound(scratch.denormals.begin(), scratch.denormals.end(), cut) - scratch.denormals.begin();
+    const size_t nSkip = std::lower_bound(scratch.denormals.begin(), scratch.denormals.end(), second) - scratch.denormals.begin();
+    AddROI(t, adc, cut, scratch.denormals.data(), nFirst, scratch, store);
+    if(second < total){
+      for(size_t i=nSkip; i<scratch.denormals.size(); i++) scratch.denormals[i] -= second;
+      AddROI(t + second, adc + second, total - second, scratch.denormals.data() + nSkip, scratch.denormals.size() - nSkip, scratch, store);
+    }
+
+    if(truth){
+      truth->nROIs += second < total ? 2 : 1;
+      truth->nSplit += cut < total;
+      truth->nSamples += cut + (total - second);
+      truth->nDenormals += nFirst + (scratch.denormals.size() - nSkip);
+    }
+    t += total + 1 + gap();   // and a tick between ROIs, for the same reason
+  }
+}
+
+void sn::SNGenerator::AddROI(size_t firstTick, int16_t const* adc, size_t length, size_t const* denormals, size_t nDenormals,
+                             Scratch& scratch, RawROIStore& store) const
+{
+  if(nDenormals == 0){
+    store.AddROI(firstTick, adc, length);
+    return;
+  }
+
+  // the swizzler errors are floats, 1e-45 ... 4e-44
+  scratch.samples.assign(adc, adc + length);
+  for(size_t i=0; i<nDenormals; i++){
+    const uint32_t pattern = 1 + (adc[denormals[i]] & 0x1f);
+    float v;
+    std::memcpy(&v, &pattern, sizeof(v));
+    scratch.samples[denormals[i]] = v;
+  }
+  store.AddROI(firstTick, scratch.samples.data(), length);
+}
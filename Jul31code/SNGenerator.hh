@@ -0,0 +1,99 @@
+//***************************
+//    synthetic "sndaq" events, for benchmarks and tests without MicroBooNE files
+//
+//    SNGenerator makes the ROIs of all 8256 channels of an event straight into a
+//    RawROIStore (recob::Wires from there with GetWires): every ROI is the 7 zero
+//    suppression presamples, a pulse (bipolar on the induction planes U and V,
+//    unipolar on the collection plane Y) and the 8 postsamples, on the baseline of
+//    its plane plus gaussian noise. On top of that, as in the real data:
+//      - flipped bits: one sample of some ROIs gets a bit 2^k flipped
+//      - frame boundaries: an ROI that would go over one (ticks 1600 and 4800) is cut there,
+//        into two ROIs a tick apart (the sample on the boundary is left out)
+//      - swizzler errors: some samples are denormal floats (1e-45 ... 4e-44) instead of ADCs
+//    what was put in where is in SNTruth. The event only depends on the seed, the
+//    event number and the configuration, channel by channel, so events can be made
+//    on any number of threads and come out the same.
+//***************************
+
+#ifndef SN_SNGENERATOR_HH
+#define SN_SNGENERATOR_HH
+
+//some standard C++ includes
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "RawROIStore.hh"
+
+namespace sn{
+
+  struct SNGeneratorConfig{
+    size_t nChannels = 8256;
+    size_t nTicks = 6400;
+    std::vector<size_t> frameBoundaries{1600, 4800};
+    float baselineU = 2048;             // ADC, per plane
+    float baselineV = 2048;
+    float baselineY = 400;
+    float baselineSpread = 20;          // channel to channel, uniform +-
+    float noiseRMS = 2.5;               // ADC
+    double roisPerChannel = 4;          // mean number of ROIs of a channel in an event
+    float amplitudeMin = 10;            // pulse height, uniform (ADC)
+    float amplitudeMax = 200;
+    float widthMin = 1.5;               // pulse sigma, uniform (ticks)
+    float widthMax = 4;
+    double flipProbability = 0.01;      // per ROI
+    int flipMinBit = 5;                 // the bit flipped is one of 2^5 ... 2^10
+    int flipMaxBit = 10;
+    double denormalProbability = 1e-5;  // per sample
+    uint64_t seed = 1;
+  };
+
+  struct SNFlipTruth{
+    unsigned int channel;
+    size_t tick;
+    int bit;
+  };
+
+  struct SNTruth{
+    size_t nROIs = 0;
+    size_t nSamples = 0;
+    size_t nSplit = 0;       // ROIs cut at a frame boundary (counted once; both parts are in nROIs)
+    size_t nDenormals = 0;
+    std::vector<SNFlipTruth> flips;
+
+    void clear() { *this = SNTruth(); }
+  };
+
+  class SNGenerator{
+
+  public:
+    explicit SNGenerator(SNGeneratorConfig const& config = SNGeneratorConfig());
+
+    SNGeneratorConfig const& Config() const { return fConfig; }
+
+    // event 'event' into store (refilled), and what was put in into truth if given
+    void Generate(size_t event, RawROIStore& store, SNTruth* truth = nullptr) const;
+
+  private:
+    enum { kNoise = 4096, kShapeTicks = 64, kWidths = 16 };
+
+    // reused from channel to channel
+    struct Scratch{
+      std::vector<int16_t> adc;
+      std::vector<float> samples;
+      std::vector<size_t> denormals;   // positions in adc
+    };
+
+    void GenerateChannel(size_t event, unsigned int channel, Scratch& scratch, RawROIStore& store, SNTruth* truth) const;
+    void AddROI(size_t firstTick, int16_t const* adc, size_t length, size_t const* denormals, size_t nDenormals,
+                Scratch& scratch, RawROIStore& store) const;
+
+    SNGeneratorConfig fConfig;
+    std::vector<int16_t> fNoise;   // kNoise gaussian samples, rounded to ADC
+    std::vector<float> fShapes;    // [unipolar, bipolar][width][tick], peak 1
+    std::vector<size_t> fLength;   // ticks of the pulse of each width
+  };
+
+}
+
+#endif
@@ -0,0 +1,135 @@
+//***************************
+//    what the histograms and the events take in memory, and a budget for it
+//***************************
+
+#include "SNMemory.hh"
+
+//some standard C++ includes
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/resource.h>
+
+//some ROOT includes
+#include "TH1.h"
+#include "TH2.h"
+#include "TH1F.h"
+#include "TH1D.h"
+#include "TH1I.h"
+#include "TH2F.h"
+#include "TH2I.h"
+#include "TH2S.h"
+#include "TList.h"
+#include "TDirectory.h"
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+size_t sn::MemoryBudget::fLimit = 0;
+std::atomic<size_t> sn::MemoryBudget::fBooked(0);
+
+size_t sn::HistBytes(TH1 const& h)
+{
+  // the bin contents are the TArray the histogram class derives from
+  size_t binBytes = sizeof(double);
+  if(dynamic_cast<TArrayF const*>(&h)) binBytes = sizeof(float);
+  else if(dynamic_cast<TArrayI const*>(&h)) binBytes = sizeof(int);
+  else if(dynamic_cast<TArrayS const*>(&h)) binBytes = sizeof(short);
+  return size_t(h.GetNcells())*binBytes + size_t(h.GetSumw2N())*sizeof(double);
+}
+
+size_t sn::HistBytes(int nbinsx, int nbinsy, size_t binBytes)
+{
+  const size_t nCells = size_t(nbinsx+2)*(nbinsy > 0 ? size_t(nbinsy+2) : 1);
+  return nCells*binBytes + (TH1::GetDefaultSumw2() ? nCells*sizeof(double) : 0);
+}
+
+std::string sn::SparseEquivalent(TH1 const& h)
+{
+  if(h.GetDimension() != 2) return "";
+  const bool integer = dynamic_cast<TArrayI const*>(&h) || dynamic_cast<TArrayS const*>(&h);
+  return std::string(integer ? "sn::SparseTH2I" : "sn::SparseTH2F") + " (SparseHist2D.hh),"
+    + " or sn::ChannelStats/sn::ChannelQuantiles if only the per channel mean or quantiles are looked at";
+}
+
+size_t sn::WireBytes(std::vector<recob::Wire> const& wires)
+{
+  size_t bytes = wires.capacity()*sizeof(recob::Wire);
+  for(auto const& wire : wires){
+    auto const& rois = wire.SignalROI();
+    for(auto iROI = rois.begin_range(); iROI != rois.end_range(); ++iROI)
+      bytes += iROI->size()*sizeof(float) + sizeof(*iROI);
+  }
+  return bytes;
+}
+
+size_t sn::ResidentBytes()
+{
+  // second field of /proc/self/statm: resident pages
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if(!statm) return 0;
+  unsigned long size = 0, resident = 0;
+  const int n = fscanf(statm, "%lu %lu", &size, &resident);
+  fclose(statm);
+  return n == 2 ? resident*size_t(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+size_t sn::PeakResidentBytes()
+{
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  return size_t(usage.ru_maxrss)*1024;   // kB on Linux
+}
+
+bool sn::MemoryBudget::TryBook(size_t bytes)
+{
+  size_t booked = fBooked.load(std::memory_order_relaxed);
+  do{
+    if(fLimit && booked + bytes > fLimit) return false;
+  } while(!fBooked.compare_exchange_weak(booked, booked + bytes, std::memory_order_relaxed));
+  return true;
+}
+
+void sn::MemoryBudget::Book(std::string const& what, size_t bytes, std::vector<TH1*> const& hists)
+{
+  if(TryBook(bytes)) return;
+
+  std::ostringstream message;
+  message << "MemoryBudget: " << what << " needs " << (bytes >> 20) << " MB, only "
+          << ((fLimit - std::min(fLimit, Booked())) >> 20) << " MB of the " << (fLimit >> 20) << " MB budget are left.";
+
+  // the biggest first, up to 5 of them
+  std::vector<TH1*> biggest(hists);
+  std::sort(biggest.begin(), biggest.end(), [](TH1 const* a, TH1 const* b){ return HistBytes(*a) > HistBytes(*b); });
+  if(biggest.size() > 5) biggest.resize(5);
+  for(TH1 const* h : biggest){
+    message << "\n  " << h->GetName() << ": " << (HistBytes(*h) >> 20) << " MB";
+    const std::string sparse = SparseEquivalent(*h);
+    if(!sparse.empty()) message << ", book it as " << sparse;
+  }
+  throw std::runtime_error(message.str());
+}
+
+sn::DenseBooking::DenseBooking(std::string const& what, size_t bytes)
+  : fBytes(bytes)
+  , fBooked(MemoryBudget::TryBook(bytes))
+{
+  if(!fBooked)
+    std::cout << "MemoryBudget: no room left for the " << (bytes >> 20) << " MB dense copy of "
+              << what << ", it is skipped" << std::endl;
+}
+
+std::vector<TH1*> sn::BookedHists(TDirectory* dir, std::set<TH1*> const& before)
+{
+  std::vector<TH1*> hists;
+  TList* list = dir ? dir->GetList() : nullptr;
+  if(!list) return hists;
+  for(int i=0; i<list->GetSize(); i++){
+    TH1* h = dynamic_cast<TH1*>(list->At(i));
+    if(h && !before.count(h)) hists.push_back(h);
+  }
+  return hists;
+}
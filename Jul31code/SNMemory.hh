@@ -0,0 +1,94 @@
+//***************************
+//    what the histograms and the events take in memory, and a budget for it
+//
+//    a dense TH2F over 8256 channels and 4096 value bins is 136 MB before
+//    anybody fills it, and every event-parallel worker books its own copy.
+//    HistBytes() is what a ROOT histogram takes once booked (bins and sumw2),
+//    ResidentBytes() what the whole process has in memory now (SNMetrics
+//    samples it after every event, next to the WireBytes() of the event).
+//
+//    MemoryBudget is off unless given a limit (the programs' -M option, see
+//    SNOptions.h). Then every booking goes through Book(), which refuses what
+//    would take the bookings past the limit: with an exception naming the
+//    biggest histograms and what to use instead (SparseTH2F/I, see SparseHist2D.hh,
+//    or the per-channel summaries of ChannelStats.hh and QuantileSketch.hh),
+//    or with false from TryBook() where a stage can go on without. The dense TH2s
+//    made from the sparse ones at the end of the job go through a DenseBooking.
+//***************************
+
+#ifndef SN_SNMEMORY_HH
+#define SN_SNMEMORY_HH
+
+//some standard C++ includes
+#include <atomic>
+#include <set>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+class TH1;
+class TDirectory;
+namespace recob{ class Wire; }
+
+namespace sn{
+
+  // bins (under/overflow included) and sumw2 of a booked histogram
+  size_t HistBytes(TH1 const& h);
+  // the same ahead of booking it: nbinsx (x nbinsy, 0 for a TH1) bins of binBytes each
+  size_t HistBytes(int nbinsx, int nbinsy, size_t binBytes);
+
+  // what to book instead of h if it is too big ("" if there is nothing sparse for it)
+  std::string SparseEquivalent(TH1 const& h);
+
+  // about how much memory a wire product takes
+  size_t WireBytes(std::vector<recob::Wire> const& wires);
+
+  // resident set of the process now, and the most it has been (0 where we can't tell)
+  size_t ResidentBytes();
+  size_t PeakResidentBytes();
+
+  class MemoryBudget{
+
+  public:
+    // 0: no limit, and Book() only counts
+    static void SetLimit(size_t bytes) { fLimit = bytes; }
+    static size_t Limit() { return fLimit; }
+    static size_t Booked() { return fBooked.load(std::memory_order_relaxed); }
+
+    // books 'bytes' for 'what' (an output file, a worker, ...) if they fit, or throws
+    // std::runtime_error listing the biggest of 'hists' with their sparse equivalents
+    static void Book(std::string const& what, size_t bytes, std::vector<TH1*> const& hists = {});
+    // the same, only saying no instead of throwing
+    static bool TryBook(size_t bytes);
+    static void Release(size_t bytes) { fBooked -= bytes; }
+
+  private:
+    static size_t fLimit;
+    static std::atomic<size_t> fBooked;
+  };
+
+  // the room for a dense copy made at the end of the job (the TH2 of a sparse histogram),
+  // booked for as long as the DenseBooking lives. If it doesn't fit, it tests false and
+  // has said so: the copy of 'what' is to be skipped
+  class DenseBooking{
+
+  public:
+    DenseBooking(std::string const& what, size_t bytes);
+    ~DenseBooking() { if(fBooked) MemoryBudget::Release(fBytes); }
+
+    DenseBooking(DenseBooking const&) = delete;
+    DenseBooking& operator=(DenseBooking const&) = delete;
+
+    explicit operator bool() const { return fBooked; }
+
+  private:
+    size_t fBytes;
+    bool fBooked;
+  };
+
+  // the histograms booked in dir, leaving out those already in 'before'
+  std::vector<TH1*> BookedHists(TDirectory* dir, std::set<TH1*> const& before = {});
+
+}
+
+#endif
@@ -0,0 +1,271 @@
+//***************************
+//    where the time and the memory of a job go: per stage timers, per event latencies and memory
+//***************************
+
+#include "SNMetrics.hh"
+#include "SNMemory.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+  // event latencies: bucket 0 is below 1 us, bucket k (from 1) up to 2^(k/4) us, 4 buckets an
+  // octave up to 2^31 us (36 min); the last one takes the rest
+  const size_t kLatencyBuckets = 126;
+
+  inline size_t LatencyBucket(uint64_t ns){
+    if(ns < 1000) return 0;
+    const size_t k = size_t(4*std::log2(ns*1e-3)) + 1;
+    return std::min(k, kLatencyBuckets - 1);
+  }
+
+  inline double BucketUpperMs(size_t k){ return std::exp2(k/4.)*1e-3; }
+
+  // what one thread counted
+  struct Slot{
+    uint64_t ns[sn::kNMetricStages] = {};
+    uint64_t calls[sn::kNMetricStages] = {};
+    uint64_t events = 0;
+    uint64_t eventNs = 0;
+    uint64_t maxEventNs = 0;
+    uint64_t bytes = 0;
+    uint64_t rois = 0;
+    uint64_t latency[kLatencyBuckets] = {};
+    uint64_t productBytes = 0;
+    uint64_t maxProductBytes = 0;
+    std::vector< std::pair<uint64_t, uint64_t> > rss;   // (ns since the start, bytes) after every event
+
+    void clear() { *this = Slot(); }
+  };
+
+  struct HistogramSet{
+    std::string name;
+    size_t booked;
+    size_t sparse;
+  };
+
+  // every slot ever handed out; they stay when their thread ends, for the report
+  std::mutex gSlotsMutex;
+  std::vector< std::unique_ptr<Slot> > gSlots;
+  uint64_t gStart = 0;   // when the job was Enable()d
+  std::vector<HistogramSet> gHistogramSets;
+
+  Slot& LocalSlot(){
+    thread_local Slot* slot = nullptr;
+    if(!slot){
+      std::lock_guard<std::mutex> lock(gSlotsMutex);
+      gSlots.emplace_back(new Slot());
+      slot = gSlots.back().get();
+    }
+    return *slot;
+  }
+
+  // all the slots added up
+  Slot Total(){
+    Slot total;
+    std::lock_guard<std::mutex> lock(gSlotsMutex);
+    for(auto const& s : gSlots){
+      for(size_t i=0; i<sn::kNMetricStages; i++){
+        total.ns[i] += s->ns[i];
+        total.calls[i] += s->calls[i];
+      }
+      total.events += s->events;
+      total.eventNs += s->eventNs;
+      total.maxEventNs = std::max(total.maxEventNs, s->maxEventNs);
+      total.bytes += s->bytes;
+      total.rois += s->rois;
+      for(size_t k=0; k<kLatencyBuckets; k++) total.latency[k] += s->latency[k];
+      total.productBytes += s->productBytes;
+      total.maxProductBytes = std::max(total.maxProductBytes, s->maxProductBytes);
+      total.rss.insert(total.rss.end(), s->rss.begin(), s->rss.end());
+    }
+    std::sort(total.rss.begin(), total.rss.end());
+    return total;
+  }
+
+  // the upper edge of the bucket the q quantile of the latencies is in (no more than the slowest event)
+  double LatencyQuantileMs(Slot const& total, double q){
+    if(total.events == 0) return 0;
+    const uint64_t rank = std::max<uint64_t>(1, std::ceil(q*total.events));
+    uint64_t seen = 0;
+    for(size_t k=0; k<kLatencyBuckets; k++){
+      seen += total.latency[k];
+      if(seen >= rank) return std::min(BucketUpperMs(k), total.maxEventNs*1e-6);
+    }
+    return total.maxEventNs*1e-6;
+  }
+
+  uint64_t MaxRSS(Slot const& total){
+    uint64_t rss = 0;
+    for(auto const& sample : total.rss) rss = std::max(rss, sample.second);
+    return rss;
+  }
+
+}
+
+std::atomic<bool> sn::SNMetrics::fEnabled(false);
+
+void sn::SNMetrics::Enable(bool on)
+{
+  {
+    std::lock_guard<std::mutex> lock(gSlotsMutex);
+    for(auto& s : gSlots) s->clear();
+    gHistogramSets.clear();
+  }
+  gStart = Now();
+  fEnabled.store(on, std::memory_order_relaxed);
+}
+
+void sn::SNMetrics::AddTime(MetricStage stage, uint64_t ns)
+{
+  Slot& s = LocalSlot();
+  s.ns[stage] += ns;
+  s.calls[stage]++;
+}
+
+void sn::SNMetrics::AddEvent(uint64_t ns, size_t bytes, size_t rois, size_t productBytes)
+{
+  const uint64_t rss = ResidentBytes();   // a read of /proc, a few us
+  Slot& s = LocalSlot();
+  s.events++;
+  s.eventNs += ns;
+  s.maxEventNs = std::max(s.maxEventNs, ns);
+  s.bytes += bytes;
+  s.rois += rois;
+  s.latency[LatencyBucket(ns)]++;
+  s.productBytes += productBytes;
+  s.maxProductBytes = std::max<uint64_t>(s.maxProductBytes, productBytes);
+  s.rss.emplace_back(Now() - gStart, rss);
+}
+
+void sn::SNMetrics::AddHistogramSet(std::string const& name, size_t bookedBytes, size_t sparseBytes)
+{
+  std::lock_guard<std::mutex> lock(gSlotsMutex);
+  gHistogramSets.push_back(HistogramSet{ name, bookedBytes, sparseBytes });
+}
+
+const char* sn::SNMetrics::StageName(MetricStage stage)
+{
+  static const char* names[kNMetricStages] = { "read", "decode", "baseline", "flipscan", "fill", "write" };
+  return names[stage];
+}
+
+void sn::SNMetrics::Report(std::ostream& out)
+{
+  const Slot total = Total();
+  const double wall = (Now() - gStart)*1e-9;
+  const double perEvent = total.events ? 1e-6/total.events : 0;   // ns -> ms per event
+
+  char line[256];
+  snprintf(line, sizeof(line), "%llu events in %.3f s (%.3g events/s), %llu bytes of input (%.3g MB/s), %llu ROIs (%.1f bytes/ROI)",
+           (unsigned long long)total.events, wall, wall > 0 ? total.events/wall : 0.,
+           (unsigned long long)total.bytes, wall > 0 ? total.bytes/wall/1e6 : 0.,
+           (unsigned long long)total.rois, total.rois ? double(total.bytes)/total.rois : 0.);
+  out << line << std::endl;
+  snprintf(line, sizeof(line), "%-10s %12s %12s %12s", "stage", "time (s)", "calls", "ms/event");
+  out << line << std::endl;
+  for(size_t i=0; i<kNMetricStages; i++){
+    snprintf(line, sizeof(line), "%-10s %12.3f %12llu %12.3f", StageName(MetricStage(i)), total.ns[i]*1e-9,
+             (unsigned long long)total.calls[i], total.ns[i]*perEvent);
+    out << line << std::endl;
+  }
+  snprintf(line, sizeof(line), "event latency (ms): mean %.3f, median %.3f, 90%% %.3f, 99%% %.3f, max %.3f",
+           total.eventNs*perEvent, LatencyQuantileMs(total, 0.5), LatencyQuantileMs(total, 0.9),
+           LatencyQuantileMs(total, 0.99), total.maxEventNs*1e-6);
+  out << line << std::endl;
+
+  const double MB = 1./(1 << 20);
+  snprintf(line, sizeof(line), "memory (MB): resident at most %.1f after an event, %.1f at the peak; wires of an event %.1f on average, %.1f at most",
+           MaxRSS(total)*MB, PeakResidentBytes()*MB, total.events ? total.productBytes*MB/total.events : 0., total.maxProductBytes*MB);
+  out << line << std::endl;
+  if(!gHistogramSets.empty()){
+    snprintf(line, sizeof(line), "%-30s %12s %12s", "histograms", "booked (MB)", "sparse (MB)");
+    out << line << std::endl;
+    for(auto const& set : gHistogramSets){
+      snprintf(line, sizeof(line), "%-30s %12.1f %12.1f", set.name.c_str(), set.booked*MB, set.sparse*MB);
+      out << line << std::endl;
+    }
+  }
+  if(MemoryBudget::Limit()){
+    snprintf(line, sizeof(line), "memory budget (MB): %.1f booked of %.1f", MemoryBudget::Booked()*MB, MemoryBudget::Limit()*MB);
+    out << line << std::endl;
+  }
+}
+
+void sn::SNMetrics::Write(std::string const& path)
+{
+  const Slot total = Total();
+  const double wall = (Now() - gStart)*1e-9;
+  const double perEvent = total.events ? 1e-6/total.events : 0;
+
+  std::ofstream out(path);
+  if(!out) throw std::runtime_error("SNMetrics: can't write " + path);
+
+  const double quantiles[] = { 0.5, 0.9, 0.99 };
+  const char* quantileNames[] = { "p50", "p90", "p99" };
+
+  if(path.size() > 4 && path.compare(path.size()-4, 4, ".csv") == 0){
+    // one value a line: what,name,value
+    out << "what,name,value\n";
+    out << "job,events," << total.events << "\n" << "job,wall_s," << wall << "\n"
+        << "job,bytes," << total.bytes << "\n" << "job,rois," << total.rois << "\n";
+    for(size_t i=0; i<kNMetricStages; i++){
+      out << "stage_s," << StageName(MetricStage(i)) << "," << total.ns[i]*1e-9 << "\n";
+      out << "stage_calls," << StageName(MetricStage(i)) << "," << total.calls[i] << "\n";
+    }
+    out << "latency_ms,mean," << total.eventNs*perEvent << "\n";
+    for(size_t q=0; q<3; q++) out << "latency_ms," << quantileNames[q] << "," << LatencyQuantileMs(total, quantiles[q]) << "\n";
+    out << "latency_ms,max," << total.maxEventNs*1e-6 << "\n";
+    for(size_t k=0; k<kLatencyBuckets; k++)
+      if(total.latency[k]) out << "latency_events," << BucketUpperMs(k) << "," << total.latency[k] << "\n";
+    out << "memory,rss_max," << MaxRSS(total) << "\n" << "memory,rss_peak," << PeakResidentBytes() << "\n"
+        << "memory,product_bytes," << total.productBytes << "\n" << "memory,product_bytes_max," << total.maxProductBytes << "\n"
+        << "memory,budget," << MemoryBudget::Limit() << "\n" << "memory,budget_booked," << MemoryBudget::Booked() << "\n";
+    for(auto const& set : gHistogramSets)
+      out << "hist_booked," << set.name << "," << set.booked << "\n" << "hist_sparse," << set.name << "," << set.sparse << "\n";
+    for(auto const& sample : total.rss) out << "rss," << sample.first*1e-9 << "," << sample.second << "\n";
+  }
+  else{
+    out << "{\n  \"events\": " << total.events << ",\n  \"wall_s\": " << wall
+        << ",\n  \"bytes\": " << total.bytes << ",\n  \"rois\": " << total.rois
+        << ",\n  \"bytes_per_roi\": " << (total.rois ? double(total.bytes)/total.rois : 0.)
+        << ",\n  \"stages\": [\n";
+    for(size_t i=0; i<kNMetricStages; i++)
+      out << "    { \"name\": \"" << StageName(MetricStage(i)) << "\", \"s\": " << total.ns[i]*1e-9
+          << ", \"calls\": " << total.calls[i] << ", \"ms_per_event\": " << total.ns[i]*perEvent << " }"
+          << (i+1 < kNMetricStages ? "," : "") << "\n";
+    out << "  ],\n  \"latency_ms\": { \"mean\": " << total.eventNs*perEvent;
+    for(size_t q=0; q<3; q++) out << ", \"" << quantileNames[q] << "\": " << LatencyQuantileMs(total, quantiles[q]);
+    out << ", \"max\": " << total.maxEventNs*1e-6 << " },\n";
+    // the filled buckets, as [upper edge (ms), events]
+    out << "  \"latency_histogram\": [";
+    bool first = true;
+    for(size_t k=0; k<kLatencyBuckets; k++){
+      if(!total.latency[k]) continue;
+      out << (first ? " " : ", ") << "[" << BucketUpperMs(k) << ", " << total.latency[k] << "]";
+      first = false;
+    }
+    out << " ],\n";
+    out << "  \"memory\": { \"rss_max\": " << MaxRSS(total) << ", \"rss_peak\": " << PeakResidentBytes()
+        << ", \"product_bytes\": " << total.productBytes << ", \"product_bytes_max\": " << total.maxProductBytes
+        << ", \"budget\": " << MemoryBudget::Limit() << ", \"budget_booked\": " << MemoryBudget::Booked() << " },\n";
+    out << "  \"histograms\": [";
+    for(size_t i=0; i<gHistogramSets.size(); i++)
+      out << (i ? ", " : " ") << "{ \"name\": \"" << gHistogramSets[i].name << "\", \"booked\": " << gHistogramSets[i].booked
+          << ", \"sparse\": " << gHistogramSets[i].sparse << " }";
+    // after every event, as [s since the start, bytes]
+    out << " ],\n  \"rss\": [";
+    for(size_t i=0; i<total.rss.size(); i++)
+      out << (i ? ", " : " ") << "[" << total.rss[i].first*1e-9 << ", " << total.rss[i].second << "]";
+    out << " ]\n}\n";
+  }
+}
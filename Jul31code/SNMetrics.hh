@@ -0,0 +1,109 @@
+//***************************
+//    where the time and the memory of a job go: per stage timers, per event latencies and memory
+//
+//    off unless SNMetrics::Enable() was called (the programs' -T option, see
+//    SNOptions.h). Switched off, a ScopedTimer or an SNEventTimer is one relaxed
+//    atomic load and nothing else, so they can stay in the loops for good.
+//
+//    Every thread adds up into its own slot (no locks, no shared cache lines),
+//    the slots are summed for the report once the threads are done. Stage times
+//    are summed over the threads: with -t 8 the baselines of one event can take
+//    8 s of thread time in 1 s of wall time.
+//
+//    With every event the resident memory of the process is sampled too, next to
+//    the size of the event's wires (SNMemory.hh); the driver adds what the
+//    histograms of each output file take at the end.
+//
+//    At the end of the job: Report() prints the summary table, Write() puts the
+//    same into a .json or .csv file (by the extension) for the comparison scripts.
+//***************************
+
+#ifndef SN_SNMETRICS_HH
+#define SN_SNMETRICS_HH
+
+//some standard C++ includes
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace sn{
+
+  // what the time is spent on; an event's latency is counted on its own (SNEventTimer)
+  enum MetricStage{
+    kRead,       // the wires out of the art file (gallery, or waiting for the read-ahead)
+    kDecode,     // ROI cache, SN stream and int16 store into wires and ROIs
+    kBaseline,   // EstimateBaselines
+    kFlipScan,   // looking for flipped bits
+    kFill,       // histogram fills (the FillBuffer replays)
+    kWrite,      // Finish() and the output files at the end of the job
+    kNMetricStages
+  };
+
+  class SNMetrics{
+
+  public:
+    static bool Enabled() { return fEnabled.load(std::memory_order_relaxed); }
+
+    // starts (again) from nothing: zeroes the counters and the wall clock of the job
+    static void Enable(bool on = true);
+
+    static void AddTime(MetricStage stage, uint64_t ns);
+    // one event done, 'ns' after it was started, with that many bytes of input and ROIs,
+    // and its products taking productBytes in memory
+    static void AddEvent(uint64_t ns, size_t bytes, size_t rois, size_t productBytes);
+    // the histograms of one output file: booked (dense, the bins are there from the start)
+    // and kept otherwise (sparse tiles, per event histograms; what they have grown to)
+    static void AddHistogramSet(std::string const& name, size_t bookedBytes, size_t sparseBytes);
+
+    // only once the threads that counted are done
+    static void Report(std::ostream& out);
+    static void Write(std::string const& path);   // throws std::runtime_error if it can't
+
+    static const char* StageName(MetricStage stage);
+
+    static uint64_t Now() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+  private:
+    static std::atomic<bool> fEnabled;
+  };
+
+  // the time from here to the end of the scope goes to 'stage'
+  class ScopedTimer{
+
+  public:
+    explicit ScopedTimer(MetricStage stage)
+      : fStage(stage), fStart(SNMetrics::Enabled() ? SNMetrics::Now() : 0) {}
+    ~ScopedTimer(){ if(fStart) SNMetrics::AddTime(fStage, SNMetrics::Now() - fStart); }
+
+    ScopedTimer(ScopedTimer const&) = delete;
+    ScopedTimer& operator=(ScopedTimer const&) = delete;
+
+  private:
+    MetricStage fStage;
+    uint64_t fStart;
+  };
+
+  // the latency of one event, from where it is made to Done(); an event that is
+  // never Done() (not ours after all, the end of the input) isn't counted.
+  // Tests true when counting, so the bytes and ROIs are only added up then
+  class SNEventTimer{
+
+  public:
+    SNEventTimer() : fStart(SNMetrics::Enabled() ? SNMetrics::Now() : 0) {}
+    explicit operator bool() const { return fStart != 0; }
+    void Done(size_t bytes, size_t rois, size_t productBytes) const {
+      if(fStart) SNMetrics::AddEvent(SNMetrics::Now() - fStart, bytes, rois, productBytes);
+    }
+
+  private:
+    uint64_t fStart;
+  };
+
+}
+
+#endif
@@ -0,0 +1,135 @@
+//***************************
+//    command line of the SN wire analysis programs
+//
+//    prog [-j nEventWorkers] [-t nChannelThreads] [-p prefetchDepth] [-m prefetchMB] [-H] [-n maxEvents] [-P display.snpyr]
+//         [-T metrics.json|metrics.csv|-] [-M budgetMB] file [file ...]
+//
+//    every file argument can be a single file, a comma separated list, a glob
+//    ("run14662/*.root", quoted so the shell leaves it alone) or @list.txt with
+//    one of those per line (empty lines and lines starting with # are skipped)
+//***************************
+
+#ifndef SN_SNOPTIONS_H
+#define SN_SNOPTIONS_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <glob.h>
+
+namespace sn{
+
+  struct SNOptions{
+    std::vector<std::string> filenames;
+    size_t nEventWorkers = 1;     // -j: whole events in parallel
+    size_t nChannelThreads = 1;   // -t: the wires of one event in parallel
+    size_t prefetchDepth = 0;     // -p: events read ahead in the background (0: off, each read when its turn comes)
+    size_t prefetchMB = 512;      // -m: and at most this much of them
+    bool fullHists = false;       // -H: the full channel x quantity TH2s next to the per-channel summaries
+    size_t maxEvents = 0;         // -n: events to look at, at most the stages' own number (0: theirs)
+    std::string pyramidFile;      // -P: the event displays into this file too (ReadSNSwizzledData, see EventPyramid.hh)
+    std::string metricsFile;      // -T: time the stages and events (SNMetrics.hh), the summary into this file ("-": printed only)
+    size_t memoryMB = 0;          // -M: at most this much for the histograms, refuse to book more (SNMemory.hh; 0: no limit)
+  };
+
+  // appends the files 'arg' stands for (see above) to filenames
+  inline void ExpandFileArgument(std::string const& arg, std::vector<std::string>& filenames, int depth = 0){
+    if(arg.empty()) return;
+
+    if(arg[0] == '@'){
+      if(depth > 8){
+        std::cerr << "Giving up on " << arg << ", the file lists include each other." << std::endl;
+        return;
+      }
+      std::ifstream list(arg.substr(1));
+      if(!list){
+        std::cerr << "Can't open the file list " << arg.substr(1) << std::endl;
+        return;
+      }
+      std::string line;
+      while(std::getline(list, line)){
+        const size_t first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos || line[first] == '#') continue;
+        const size_t last = line.find_last_not_of(" \t\r");
+        ExpandFileArgument(line.substr(first, last+1-first), filenames, depth+1);
+      }
+      return;
+    }
+
+    if(arg.find(',') != std::string::npos){
+      std::stringstream items(arg);
+      std::string item;
+      while(std::getline(items, item, ',')) ExpandFileArgument(item, filenames, depth);
+      return;
+    }
+
+    if(arg.find_first_of("*?[") != std::string::npos){
+      glob_t matches;
+      if(glob(arg.c_str(), 0, nullptr, &matches) == 0){   // sorted, so the runs come in order
+        for(size_t i=0; i<matches.gl_pathc; i++) filenames.push_back(matches.gl_pathv[i]);
+      }
+      else
+        std::cerr << "No files match " << arg << std::endl;
+      globfree(&matches);
+      return;
+    }
+
+    filenames.push_back(arg);
+  }
+
+  inline SNOptions ParseOptions(int argc, char** argv){
+    SNOptions opt;
+    for(int i=1; i<argc; i++){
+      std::string arg(argv[i]);
+      if((arg == "-j" || arg == "-t") && i+1 < argc){
+        const int n = atoi(argv[++i]);
+        if(n < 1){
+          std::cerr << "Ignoring " << arg << " " << argv[i] << ", need at least one thread." << std::endl;
+          continue;
+        }
+        if(arg == "-j") opt.nEventWorkers = n;
+        else opt.nChannelThreads = n;
+      }
+      else if((arg == "-p" || arg == "-m") && i+1 < argc){
+        const int n = atoi(argv[++i]);
+        if(n < 0 || (arg == "-m" && n == 0)){
+          std::cerr << "Ignoring " << arg << " " << argv[i] << std::endl;
+          continue;
+        }
+        if(arg == "-p") opt.prefetchDepth = n;
+        else opt.prefetchMB = n;
+      }
+      else if(arg == "-H")
+        opt.fullHists = true;
+      else if(arg == "-P" && i+1 < argc)
+        opt.pyramidFile = argv[++i];
+      else if(arg == "-T" && i+1 < argc)
+        opt.metricsFile = argv[++i];
+      else if(arg == "-M" && i+1 < argc){
+        const int n = atoi(argv[++i]);
+        if(n < 1){
+          std::cerr << "Ignoring -M " << argv[i] << ", need at least 1 MB." << std::endl;
+          continue;
+        }
+        opt.memoryMB = n;
+      }
+      else if(arg == "-n" && i+1 < argc){
+        const int n = atoi(argv[++i]);
+        if(n < 1){
+          std::cerr << "Ignoring -n " << argv[i] << ", need at least one event." << std::endl;
+          continue;
+        }
+        opt.maxEvents = n;
+      }
+      else
+        ExpandFileArgument(arg, opt.filenames);
+    }
+    return opt;
+  }
+
+}
+
+#endif
@@ -0,0 +1,364 @@
+//***************************
+//    columnar ROI cache of the SN wire products
+//***************************
+
+#include "SNROICache.hh"
+
+//some standard C++ includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+//for mmap
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+  const char kMagic[8] = { 'S','N','R','O','I','C','\0','\1' };
+  const uint32_t kVersion = 1;
+  const uint64_t kAlign = 64;
+
+  struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t nSections;
+    uint64_t nEvents;
+  };
+
+  struct SectionEntry{
+    char name[24];
+    uint64_t offset;
+    uint64_t bytes;
+  };
+
+  const char* Prefix(sn::SNROICache::Product p) { return p == sn::SNROICache::kRaw ? "raw." : "deco."; }
+
+  // an sndaq sample we can give back exactly from an int16
+  bool IsADC(float v){
+    return v >= -32768.f && v <= 32767.f && std::nearbyint(v) == v && !(v == 0 && std::signbit(v));
+  }
+
+}
+
+//-------------------------------------------------------------------------------------------------
+// reader
+
+bool sn::SNROICache::IsCache(std::string const& path)
+{
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if(!f) return false;
+  char magic[8];
+  const bool ok = std::fread(magic, 1, 8, f) == 8 && std::memcmp(magic, kMagic, 8) == 0;
+  std::fclose(f);
+  return ok;
+}
+
+sn::SNROICache::SNROICache(std::string const& path)
+  : fPath(path)
+  , fMap(nullptr)
+  , fMapSize(0)
+  , fNEvents(0)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) throw std::runtime_error("SNROICache: can't open " + path);
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)){
+    close(fd);
+    throw std::runtime_error("SNROICache: " + path + " is too short to be a cache");
+  }
+  fMapSize = st.st_size;
+  fMap = mmap(nullptr, fMapSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);   // the mapping keeps the file
+  if(fMap == MAP_FAILED){
+    fMap = nullptr;
+    throw std::runtime_error("SNROICache: can't map " + path);
+  }
+
+  char const* base = static_cast<char const*>(fMap);
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if(std::memcmp(header.magic, kMagic, 8) != 0 || header.version != kVersion){
+    munmap(fMap, fMapSize);
+    throw std::runtime_error("SNROICache: " + path + " is not a version " + std::to_string(kVersion) + " cache");
+  }
+  fNEvents = header.nEvents;
+
+  if(sizeof(FileHeader) + header.nSections*sizeof(SectionEntry) > fMapSize){
+    munmap(fMap, fMapSize);
+    throw std::runtime_error("SNROICache: " + path + " is truncated");
+  }
+  for(size_t s=0; s<header.nSections; s++){
+    SectionEntry entry;
+    std::memcpy(&entry, base + sizeof(FileHeader) + s*sizeof(SectionEntry), sizeof(entry));
+    entry.name[sizeof(entry.name)-1] = '\0';
+    fSections[entry.name] = std::make_pair(entry.offset, entry.bytes);
+  }
+
+  try{
+    fRun = Column<uint32_t>("event.run", fNEvents);
+    fEvent = Column<uint32_t>("event.event", fNEvents);
+    fFlags = Column<uint8_t>("event.flags", fNEvents);
+
+    for(int p=0; p<2; p++){
+      const std::string pre = Prefix(Product(p));
+      Columns& c = fCols[p];
+      c.evwire = Column<uint64_t>(pre+"evwire", fNEvents+1);
+      const size_t nWires = c.evwire[fNEvents];
+      c.channel = Column<uint32_t>(pre+"channel", nWires);
+      c.view = Column<uint8_t>(pre+"view", nWires);
+      c.nticks = Column<uint32_t>(pre+"nticks", nWires);
+      c.wireroi = Column<uint64_t>(pre+"wireroi", nWires+1);
+      const size_t nROIs = c.wireroi[nWires];
+      c.begin = Column<uint32_t>(pre+"begin", nROIs);
+      c.length = Column<uint32_t>(pre+"length", nROIs);
+      c.sample0 = Column<uint64_t>(pre+"sample0", nROIs+1);
+      const size_t nSamples = c.sample0[nROIs];
+      if(p == kRaw){
+        c.adc = Column<int16_t>(pre+"adc", nSamples);
+        c.nBad = fSections.count(pre+"badidx") ? fSections[pre+"badidx"].second/sizeof(uint64_t) : 0;
+        c.badidx = Column<uint64_t>(pre+"badidx", c.nBad, false);
+        c.badval = Column<float>(pre+"badval", c.nBad, false);
+      }
+      else
+        c.value = Column<float>(pre+"value", nSamples);
+    }
+  }
+  catch(...){
+    munmap(fMap, fMapSize);
+    throw;
+  }
+}
+
+sn::SNROICache::~SNROICache()
+{
+  if(fMap) munmap(fMap, fMapSize);
+}
+
+template<typename T>
+T const* sn::SNROICache::Column(std::string const& name, size_t count, bool required) const
+{
+  auto it = fSections.find(name);
+  if(it == fSections.end()){
+    if(required || count) throw std::runtime_error("SNROICache: " + fPath + " has no column " + name);
+    return nullptr;
+  }
+  const uint64_t offset = it->second.first;
+  const uint64_t bytes = it->second.second;
+  if(bytes != count*sizeof(T) || offset + bytes > fMapSize || offset % alignof(T) != 0)
+    throw std::runtime_error("SNROICache: column " + name + " of " + fPath + " is damaged");
+  return reinterpret_cast<T const*>(static_cast<char const*>(fMap) + offset);
+}
+
+size_t sn::SNROICache::NROIs(size_t entry, Product p) const
+{
+  Columns const& c = fCols[p];
+  return c.wireroi[c.evwire[entry+1]] - c.wireroi[c.evwire[entry]];
+}
+
+void sn::SNROICache::GetWires(size_t entry, Product p, std::vector<recob::Wire>& wires) const
+{
+  if(entry >= fNEvents)
+    throw std::runtime_error("SNROICache: no entry " + std::to_string(entry) + " in " + fPath);
+  if(!HasProduct(entry, p))
+    throw std::runtime_error(std::string("SNROICache: entry ") + std::to_string(entry) + " of " + fPath
+                             + " has no " + (p == kRaw ? "sndaq" : "sndeco") + " wires");
+
+  Columns const& c = fCols[p];
+  wires.clear();
+  wires.reserve(c.evwire[entry+1] - c.evwire[entry]);
+
+  // the bad samples are sorted, so we walk along them with the ROIs
+  uint64_t const* bad = c.badidx;
+  uint64_t const* badEnd = c.badidx + c.nBad;
+  if(c.nBad){
+    const uint64_t first = c.sample0[c.wireroi[c.evwire[entry]]];
+    bad = std::lower_bound(c.badidx, badEnd, first);
+  }
+
+  std::vector<float> samples;
+  for(uint64_t w = c.evwire[entry]; w < c.evwire[entry+1]; w++){
+    recob::Wire::RegionsOfInterest_t rois;
+    rois.resize(c.nticks[w]);
+    for(uint64_t r = c.wireroi[w]; r < c.wireroi[w+1]; r++){
+      const uint64_t s0 = c.sample0[r];
+      const uint32_t n = c.length[r];
+      if(p == kRaw){
+        samples.resize(n);
+        for(uint32_t k=0; k<n; k++) samples[k] = c.adc[s0+k];
+        for(; bad != badEnd && *bad < s0+n; bad++)
+          samples[*bad - s0] = c.badval[bad - c.badidx];
+      }
+      else
+        samples.assign(c.value + s0, c.value + s0 + n);
+      rois.add_range(c.begin[r], samples);
+    }
+    wires.emplace_back(rois, c.channel[w], geo::View_t(c.view[w]));
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// writer
+
+sn::SNROICacheWriter::SNROICacheWriter(std::string const& path)
+  : fPath(path)
+  , fClosed(false)
+  , fNEvents(0)
+  , fNBad(0)
+  , fNWires{0,0}
+  , fNROIs{0,0}
+  , fNSamples{0,0}
+{
+  // declare every column up front, so even empty ones end up in the file
+  Append<uint32_t>("event.run", nullptr, 0);
+  Append<uint32_t>("event.event", nullptr, 0);
+  Append<uint8_t>("event.flags", nullptr, 0);
+  for(int p=0; p<2; p++){
+    const std::string pre = Prefix(SNROICache::Product(p));
+    Append<uint64_t>(pre+"evwire", 0);
+    Append<uint32_t>(pre+"channel", nullptr, 0);
+    Append<uint8_t>(pre+"view", nullptr, 0);
+    Append<uint32_t>(pre+"nticks", nullptr, 0);
+    Append<uint64_t>(pre+"wireroi", 0);
+    Append<uint32_t>(pre+"begin", nullptr, 0);
+    Append<uint32_t>(pre+"length", nullptr, 0);
+    Append<uint64_t>(pre+"sample0", 0);
+    if(p == SNROICache::kRaw){
+      Append<int16_t>(pre+"adc", nullptr, 0);
+      Append<uint64_t>(pre+"badidx", nullptr, 0);
+      Append<float>(pre+"badval", nullptr, 0);
+    }
+    else
+      Append<float>(pre+"value", nullptr, 0);
+  }
+}
+
+sn::SNROICacheWriter::~SNROICacheWriter()
+{
+  if(!fClosed){
+    for(auto& s : fSpools) if(s.second.f) std::fclose(s.second.f);
+  }
+}
+
+template<typename T>
+void sn::SNROICacheWriter::Append(std::string const& name, T const* data, size_t n)
+{
+  Spool& spool = fSpools[name];
+  if(!spool.f){
+    spool.f = std::tmpfile();
+    if(!spool.f) throw std::runtime_error("SNROICacheWriter: can't make a temporary file for " + name);
+    spool.elemSize = sizeof(T);
+    fOrder.push_back(name);
+  }
+  if(n && std::fwrite(data, sizeof(T), n, spool.f) != n)
+    throw std::runtime_error("SNROICacheWriter: can't write column " + name);
+  spool.count += n;
+}
+
+void sn::SNROICacheWriter::AddEvent(int run, int event,
+                                    std::vector<recob::Wire> const& wires,
+                                    std::vector<recob::Wire> const* wires_d)
+{
+  Append<uint32_t>("event.run", run);
+  Append<uint32_t>("event.event", event);
+  Append<uint8_t>("event.flags", (1u << SNROICache::kRaw) | (wires_d ? (1u << SNROICache::kDecon) : 0u));
+
+  AddProduct(SNROICache::kRaw, &wires);
+  AddProduct(SNROICache::kDecon, wires_d);
+  fNEvents++;
+}
+
+void sn::SNROICacheWriter::AddProduct(SNROICache::Product p, std::vector<recob::Wire> const* wires)
+{
+  const std::string pre = Prefix(p);
+
+  if(wires){
+    for(auto const& wire : *wires){
+      auto const& rois = wire.SignalROI();
+      Append<uint32_t>(pre+"channel", wire.Channel());
+      Append<uint8_t>(pre+"view", wire.View());
+      Append<uint32_t>(pre+"nticks", rois.size());
+
+      for(auto iROI = rois.begin_range(); iROI != rois.end_range(); ++iROI){
+        auto const& data = iROI->data();
+        Append<uint32_t>(pre+"begin", iROI->begin_index());
+        Append<uint32_t>(pre+"length", data.size());
+
+        if(p == SNROICache::kRaw){
+          // ADC counts fit in an int16; anything else goes to the side, exactly as it was
+          fADC.resize(data.size());
+          for(size_t k=0; k<data.size(); k++){
+            if(IsADC(data[k])) fADC[k] = (int16_t)data[k];
+            else{
+              fADC[k] = 0;
+              Append<uint64_t>(pre+"badidx", fNSamples[p]+k);
+              Append<float>(pre+"badval", data[k]);
+              fNBad++;
+            }
+          }
+          Append(pre+"adc", fADC.data(), fADC.size());
+        }
+        else
+          Append(pre+"value", data.data(), data.size());
+
+        fNSamples[p] += data.size();
+        fNROIs[p]++;
+        Append<uint64_t>(pre+"sample0", fNSamples[p]);
+      }
+      fNWires[p]++;
+      Append<uint64_t>(pre+"wireroi", fNROIs[p]);
+    }
+  }
+  Append<uint64_t>(pre+"evwire", fNWires[p]);
+}
+
+void sn::SNROICacheWriter::Close()
+{
+  if(fClosed) return;
+  fClosed = true;
+
+  // header, section table, then the columns one after the other
+  std::vector<SectionEntry> table(fOrder.size());
+  uint64_t offset = sizeof(FileHeader) + table.size()*sizeof(SectionEntry);
+  for(size_t s=0; s<fOrder.size(); s++){
+    Spool const& spool = fSpools[fOrder[s]];
+    std::memset(&table[s], 0, sizeof(SectionEntry));
+    std::strncpy(table[s].name, fOrder[s].c_str(), sizeof(table[s].name)-1);
+    offset = (offset + kAlign-1)/kAlign*kAlign;
+    table[s].offset = offset;
+    table[s].bytes = spool.count*spool.elemSize;
+    offset += table[s].bytes;
+  }
+
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, 8);
+  header.version = kVersion;
+  header.nSections = table.size();
+  header.nEvents = fNEvents;
+
+  std::FILE* out = std::fopen(fPath.c_str(), "wb");
+  if(!out) throw std::runtime_error("SNROICacheWriter: can't open " + fPath);
+  std::fwrite(&header, sizeof(header), 1, out);
+  std::fwrite(table.data(), sizeof(SectionEntry), table.size(), out);
+
+  std::vector<char> buffer(1 << 20);
+  for(size_t s=0; s<fOrder.size(); s++){
+    std::FILE* in = fSpools[fOrder[s]].f;
+    const long pos = std::ftell(out);
+    for(long k=pos; k<(long)table[s].offset; k++) std::fputc(0, out);
+
+    std::rewind(in);
+    size_t n;
+    while((n = std::fread(buffer.data(), 1, buffer.size(), in)) > 0)
+      std::fwrite(buffer.data(), 1, n, out);
+    std::fclose(in);
+    fSpools[fOrder[s]].f = nullptr;
+  }
+
+  const bool failed = std::ferror(out);
+  std::fclose(out);
+  if(failed) throw std::runtime_error("SNROICacheWriter: error writing " + fPath);
+}
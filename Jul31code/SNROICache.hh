@@ -0,0 +1,141 @@
+//***************************
+//    columnar ROI cache of the SN wire products
+//
+//    sncache converts the "sndaq" and "sndeco" wires of a run into one flat file,
+//    and SNROICache maps it into memory and hands back the same vector<recob::Wire>
+//    that getValidHandle gave, without going through ROOT and the decompressor again.
+//
+//    every column is a plain array in the file, 64 byte aligned, found by name:
+//      event.run, event.event, event.flags      one entry per event
+//      <p>.evwire                               first wire of each event (nEvents+1)
+//      <p>.channel, <p>.view, <p>.nticks        one entry per wire
+//      <p>.wireroi                              first ROI of each wire (nWires+1)
+//      <p>.begin, <p>.length                    one entry per ROI (begin tick, number of ticks)
+//      <p>.sample0                              first sample of each ROI (nROIs+1)
+//      <p>.adc / <p>.value                      the samples: int16 for sndaq, float for sndeco
+//      <p>.badidx, <p>.badval                   sndaq samples that are not an int16 ADC, stored exactly
+//    with <p> = raw (sndaq) or deco (sndeco). Everything is in the byte order of the writing host.
+//***************************
+
+#ifndef SN_SNROICACHE_HH
+#define SN_SNROICACHE_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <stdint.h>
+#include <stdlib.h>
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+namespace sn{
+
+  class SNROICache{
+
+  public:
+    enum Product { kRaw = 0, kDecon = 1 };   // sndaq, sndeco
+
+    explicit SNROICache(std::string const& path);   // throws std::runtime_error if it is not a cache
+    ~SNROICache();
+    SNROICache(SNROICache const&) = delete;
+    SNROICache& operator=(SNROICache const&) = delete;
+
+    // does the file start like a cache? (so the programs can take caches and art files alike)
+    static bool IsCache(std::string const& path);
+
+    size_t NEvents() const { return fNEvents; }
+    int Run(size_t entry) const { return fRun[entry]; }
+    int Event(size_t entry) const { return fEvent[entry]; }
+    bool HasProduct(size_t entry, Product p) const { return fFlags[entry] & (1u << p); }
+
+    size_t NWires(size_t entry, Product p) const { return fCols[p].evwire[entry+1] - fCols[p].evwire[entry]; }
+    size_t NROIs(size_t entry, Product p) const;
+
+    // the wires of one event as getValidHandle< vector<recob::Wire> > gave them.
+    // 'wires' is refilled, so a worker can keep using the same vector
+    void GetWires(size_t entry, Product p, std::vector<recob::Wire>& wires) const;
+
+  private:
+    struct Columns{
+      uint64_t const* evwire = nullptr;
+      uint32_t const* channel = nullptr;
+      uint8_t  const* view = nullptr;
+      uint32_t const* nticks = nullptr;
+      uint64_t const* wireroi = nullptr;
+      uint32_t const* begin = nullptr;
+      uint32_t const* length = nullptr;
+      uint64_t const* sample0 = nullptr;
+      int16_t  const* adc = nullptr;     // raw
+      float    const* value = nullptr;   // deco
+      uint64_t const* badidx = nullptr;
+      float    const* badval = nullptr;
+      size_t nBad = 0;
+    };
+
+    template<typename T>
+    T const* Column(std::string const& name, size_t count, bool required = true) const;
+
+    std::string fPath;
+    void* fMap;
+    size_t fMapSize;
+    size_t fNEvents;
+    std::map< std::string, std::pair<uint64_t,uint64_t> > fSections;   // name -> (offset, bytes)
+
+    uint32_t const* fRun;
+    uint32_t const* fEvent;
+    uint8_t const* fFlags;
+    Columns fCols[2];
+  };
+
+  // writes a cache one event at a time; the columns are spooled to temporary files and
+  // put together behind the header in Close()
+  class SNROICacheWriter{
+
+  public:
+    explicit SNROICacheWriter(std::string const& path);
+    ~SNROICacheWriter();
+    SNROICacheWriter(SNROICacheWriter const&) = delete;
+    SNROICacheWriter& operator=(SNROICacheWriter const&) = delete;
+
+    // wires_d may be null if the event has no "sndeco" product
+    void AddEvent(int run, int event,
+                  std::vector<recob::Wire> const& wires,
+                  std::vector<recob::Wire> const* wires_d);
+
+    void Close();
+
+    size_t NEvents() const { return fNEvents; }
+    size_t NBadSamples() const { return fNBad; }   // sndaq samples that did not fit in an int16
+
+  private:
+    struct Spool{
+      std::FILE* f = nullptr;
+      uint64_t count = 0;
+      uint32_t elemSize = 0;
+    };
+
+    template<typename T>
+    void Append(std::string const& name, T const* data, size_t n);
+    template<typename T>
+    void Append(std::string const& name, T value) { Append(name, &value, 1); }
+
+    void AddProduct(SNROICache::Product p, std::vector<recob::Wire> const* wires);
+
+    std::string fPath;
+    bool fClosed;
+    size_t fNEvents;
+    size_t fNBad;
+    uint64_t fNWires[2];
+    uint64_t fNROIs[2];
+    uint64_t fNSamples[2];
+    std::vector<std::string> fOrder;
+    std::map<std::string, Spool> fSpools;
+    std::vector<int16_t> fADC;   // scratch for one ROI
+  };
+
+}
+
+#endif
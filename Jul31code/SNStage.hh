@@ -0,0 +1,74 @@
+//***************************
+//    common interface of the SN wire analyses
+//    each analysis is a stage that SNDriver hands the wires of every event to,
+//    so the "sndaq" product is read and decoded once no matter how many stages run
+//***************************
+
+#ifndef SN_SNSTAGE_HH
+#define SN_SNSTAGE_HH
+
+#include <vector>
+#include <stdlib.h>
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+namespace sn{
+
+  class ChannelPool;
+  class RawROIStore;
+
+  // what a stage gets to see of one event
+  struct SNEvent{
+    size_t entry;  // position of the event in the input, counting from 0
+    int run;
+    int event;
+    std::vector<recob::Wire> const* wires;    // "sndaq", before deconvolution
+    std::vector<recob::Wire> const* wires_d;  // "sndeco", after deconvolution (null unless a stage asked for it)
+    ChannelPool* pool;                        // threads to split the wires over (null: one thread), see ForEachWireChunk
+    RawROIStore const* raw;                   // "sndaq" as int16 (null unless a stage asked for it)
+  };
+
+  class SNStage{
+
+  public:
+    virtual ~SNStage(){}
+
+    // how many events this stage wants to look at (the old _maxEvts)
+    virtual size_t MaxEvents() const = 0;
+
+    // does the stage need the deconvolved wires too?
+    virtual bool UsesDeconvolved() const { return false; }
+
+    // does the stage read the raw wires from the int16 store (SNEvent::raw)? Building it
+    // costs a pass over every event, so only for kernels that run on the int16s
+    virtual bool UsesRawStore() const { return false; }
+
+    // called once per event, with the stage's output file as the current directory
+    virtual void ProcessEvent(SNEvent const& evt) = 0;
+
+    // draw, fit and write at the end of the job, again inside the stage's output file
+    virtual void Finish() = 0;
+
+    // about what the constructor books in the output file (HistBytes(nbinsx, nbinsy, ...) of
+    // each histogram member, SNMemory.hh), for the driver to check the memory budget before
+    // constructing the stage. Stages with histogram members hide this one with their own
+    static size_t BookingBytes() { return 0; }
+
+    // what the histograms that grow while filling take now (sparse tiles, histograms kept
+    // per event); those booked in the output file are counted by the driver (SNMemory.hh)
+    virtual size_t SparseBytes() { return 0; }
+
+    // event-parallel running: an empty copy of the stage for one worker thread,
+    // booked outside of any file, and adding a worker's copy back in at the end.
+    // The copy keeps its histograms as members (or in unique_ptrs): the driver owns it
+    // and deletes it, histograms and all, right after its Merge().
+    // Stages that can't run on several threads (they draw canvases per ROI, ...) say so here.
+    virtual bool RunsInParallel() const { return false; }
+    virtual SNStage* NewWorker() const { return nullptr; }
+    virtual void Merge(SNStage& /*worker*/) {}
+  };
+
+}
+
+#endif
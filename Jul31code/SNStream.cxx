@@ -0,0 +1,463 @@
+//***************************
+//    binary supernova stream: the "sndaq" ROIs frame by frame, without art
+//***************************
+
+#include "SNStream.hh"
+#include "ChannelPool.hh"
+
+//some standard C++ includes
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+//for mmap
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace {
+
+  const char kMagic[8] = { 'S','N','S','T','R','M','\0','\1' };
+  const uint32_t kVersion = 1;
+  const uint32_t kFrameSync = 0x52464e53;   // "SNFR"
+  const uint16_t kGoesOn = 0x8000;
+  const size_t kChunkChannels = 256;        // channels of a frame per decoding task
+
+  struct FileHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t ticksPerFrame;
+    uint32_t framesPerEvent;
+    uint32_t unused;
+  };
+
+  struct FrameHeader{
+    uint32_t sync;
+    uint32_t run;
+    uint32_t event;
+    uint32_t frame;
+    uint32_t nChannels;
+    uint32_t unused;
+    uint64_t bytes;
+  };
+
+  const size_t kMaxReported = 10;           // differences printed by CheckStreamEvent
+
+  struct ChannelEntry{
+    uint32_t channel;
+    uint32_t offset;
+  };
+
+  inline uint32_t Zigzag(int delta) { return (uint32_t(delta) << 1) ^ uint32_t(delta >> 31); }
+  inline int Unzigzag(uint32_t z) { return int(z >> 1) ^ -int(z & 1); }
+
+  inline ChannelEntry Entry(char const* payload, size_t i){
+    ChannelEntry e;
+    std::memcpy(&e, payload + i*sizeof(ChannelEntry), sizeof(e));
+    return e;
+  }
+
+  // one packet as decoded: ticks within the frame, samples in Chunk::samples
+  struct Packet{
+    uint32_t tick;
+    uint32_t length;
+    uint64_t sample0;
+    bool goesOn;
+  };
+
+  // channels [first, last) of one frame: packets of channel i are channelPacket[i-first] ...
+  struct Chunk{
+    std::vector<uint64_t> channelPacket;
+    std::vector<Packet> packets;
+    std::vector<int16_t> samples;
+    const char* error = nullptr;   // the pool's tasks can't throw, so the message waits here
+  };
+
+  // the blocks of channels [first, last) of a frame
+  void DecodeChannels(char const* payload, uint64_t bytes, size_t nChannels, size_t first, size_t last, Chunk& out)
+  {
+    out.channelPacket.assign(1, 0);
+    out.packets.clear();
+    out.samples.clear();
+    out.error = nullptr;
+
+    for(size_t i=first; i<last; i++){
+      const uint64_t begin = Entry(payload, i).offset;
+      const uint64_t end = i+1 < nChannels ? Entry(payload, i+1).offset : bytes;
+      if(begin + 2 > end || end > bytes){ out.error = "a channel block is out of its frame"; return; }
+      uint8_t const* p = reinterpret_cast<uint8_t const*>(payload) + begin;
+      uint8_t const* pEnd = reinterpret_cast<uint8_t const*>(payload) + end;
+
+      uint16_t nPackets;
+      std::memcpy(&nPackets, p, 2);
+      p += 2;
+      for(uint16_t k=0; k<nPackets; k++){
+        if(p + 4 > pEnd){ out.error = "a packet is cut off"; return; }
+        uint16_t tick, n;
+        std::memcpy(&tick, p, 2);
+        std::memcpy(&n, p+2, 2);
+        p += 4;
+        Packet packet{ tick, uint32_t(n & ~kGoesOn), out.samples.size(), (n & kGoesOn) != 0 };
+
+        // the samples, each from the one before
+        out.samples.resize(packet.sample0 + packet.length);
+        int16_t* s = out.samples.data() + packet.sample0;
+        int prev = 0;
+        for(uint32_t j=0; j<packet.length; j++){
+          if(p >= pEnd){ out.error = "the samples of a packet are cut off"; return; }
+          const uint8_t b = *p++;
+          if(b < 0x80)
+            prev += Unzigzag(b);
+          else if(b < 0xc0){
+            if(p >= pEnd){ out.error = "the samples of a packet are cut off"; return; }
+            prev += Unzigzag(uint32_t(b & 0x3f) << 8 | *p++);
+          }
+          else if(b == 0xc0){
+            if(p + 2 > pEnd){ out.error = "the samples of a packet are cut off"; return; }
+            int16_t v;
+            std::memcpy(&v, p, 2);
+            p += 2;
+            prev = v;
+          }
+          else{ out.error = "a sample has an unknown code"; return; }
+          s[j] = int16_t(prev);
+        }
+        out.packets.push_back(packet);
+      }
+      out.channelPacket.push_back(out.packets.size());
+    }
+  }
+
+}
+
+//-------------------------------------------------------------------------------------------------
+// reader
+
+bool sn::SNStream::IsStream(std::string const& path)
+{
+  std::FILE* f = std::fopen(path.c_str(), "rb");
+  if(!f) return false;
+  char magic[8];
+  const bool ok = std::fread(magic, 1, 8, f) == 8 && std::memcmp(magic, kMagic, 8) == 0;
+  std::fclose(f);
+  return ok;
+}
+
+sn::SNStream::SNStream(std::string const& path)
+  : fPath(path)
+  , fMap(nullptr)
+  , fMapSize(0)
+  , fTicksPerFrame(0)
+  , fFramesPerEvent(0)
+{
+  const int fd = open(path.c_str(), O_RDONLY);
+  if(fd < 0) throw std::runtime_error("SNStream: can't open " + path);
+  struct stat st;
+  if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FileHeader)){
+    close(fd);
+    throw std::runtime_error("SNStream: " + path + " is too short to be a stream");
+  }
+  fMapSize = st.st_size;
+  fMap = mmap(nullptr, fMapSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);   // the mapping keeps the file
+  if(fMap == MAP_FAILED){
+    fMap = nullptr;
+    throw std::runtime_error("SNStream: can't map " + path);
+  }
+
+  char const* base = static_cast<char const*>(fMap);
+  FileHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if(std::memcmp(header.magic, kMagic, 8) != 0 || header.version != kVersion
+     || header.ticksPerFrame == 0 || header.framesPerEvent == 0){
+    munmap(fMap, fMapSize);
+    throw std::runtime_error("SNStream: " + path + " is not a version " + std::to_string(kVersion) + " stream");
+  }
+  fTicksPerFrame = header.ticksPerFrame;
+  fFramesPerEvent = header.framesPerEvent;
+
+  // walk the frame headers. A frame cut off at the end (the file is still being written) ends the stream
+  size_t pos = sizeof(FileHeader);
+  while(pos + sizeof(FrameHeader) <= fMapSize){
+    FrameHeader fh;
+    std::memcpy(&fh, base + pos, sizeof(fh));
+    const bool inEvent = !fEvents.empty() && fFrames.size() - fEvents.back().firstFrame < fFramesPerEvent;
+    const bool next = fh.frame == 0 ? !inEvent
+      : inEvent && fh.frame == fFrames.size() - fEvents.back().firstFrame
+        && (int)fh.run == fEvents.back().run && (int)fh.event == fEvents.back().event
+        && fh.nChannels == fFrames[fEvents.back().firstFrame].nChannels;
+    if(fh.sync != kFrameSync || !next || fh.nChannels*sizeof(ChannelEntry) > fh.bytes){
+      munmap(fMap, fMapSize);
+      throw std::runtime_error("SNStream: " + path + " is damaged at byte " + std::to_string(pos));
+    }
+    if(pos + sizeof(FrameHeader) + fh.bytes > fMapSize) break;
+
+    if(fh.frame == 0) fEvents.push_back(EventRef{ (int)fh.run, (int)fh.event, fFrames.size() });
+    fFrames.push_back(FrameRef{ base + pos + sizeof(FrameHeader), fh.bytes, fh.nChannels });
+    pos += sizeof(FrameHeader) + fh.bytes;
+  }
+  // and so does an event without all of its frames
+  if(!fEvents.empty() && fFrames.size() - fEvents.back().firstFrame < fFramesPerEvent){
+    fFrames.resize(fEvents.back().firstFrame);
+    fEvents.pop_back();
+  }
+}
+
+sn::SNStream::~SNStream()
+{
+  if(fMap) munmap(fMap, fMapSize);
+}
+
+size_t sn::SNStream::Bytes(size_t entry) const
+{
+  size_t bytes = 0;
+  for(size_t f=0; f<fFramesPerEvent; f++) bytes += sizeof(FrameHeader) + fFrames[fEvents[entry].firstFrame + f].bytes;
+  return bytes;
+}
+
+void sn::SNStream::GetEvent(size_t entry, RawROIStore& store, ChannelPool* pool) const
+{
+  if(entry >= NEvents())
+    throw std::runtime_error("SNStream: no entry " + std::to_string(entry) + " in " + fPath);
+
+  // every frame in chunks of channels, as tasks for the pool
+  FrameRef const* frames = &fFrames[fEvents[entry].firstFrame];
+  const size_t nChannels = frames[0].nChannels;
+  const size_t nChunks = (nChannels + kChunkChannels - 1)/kChunkChannels;
+  std::vector<Chunk> chunks(fFramesPerEvent*nChunks);
+  auto decode = [&](size_t task){
+    FrameRef const& f = frames[task/nChunks];
+    const size_t first = (task%nChunks)*kChunkChannels;
+    DecodeChannels(f.payload, f.bytes, nChannels, first, std::min(first + kChunkChannels, nChannels), chunks[task]);
+  };
+  if(pool) pool->Run(chunks.size(), decode);
+  else for(size_t t=0; t<chunks.size(); t++) decode(t);
+  for(auto const& chunk : chunks)
+    if(chunk.error) throw std::runtime_error("SNStream: entry " + std::to_string(entry) + " of " + fPath + ": " + chunk.error);
+
+  // and together by channel, the frames one after the other, the split ROIs joined
+  store.clear();
+  std::vector<int16_t> roi;
+  for(size_t c=0; c<nChannels; c++){
+    const uint32_t channel = Entry(frames[0].payload, c).channel;
+    store.AddWire(channel);
+
+    size_t roiTick = 0;
+    bool open = false;
+    for(size_t f=0; f<fFramesPerEvent; f++){
+      if(Entry(frames[f].payload, c).channel != channel)
+        throw std::runtime_error("SNStream: the frames of entry " + std::to_string(entry) + " of " + fPath
+                                 + " don't have the same channels");
+      Chunk const& chunk = chunks[f*nChunks + c/kChunkChannels];
+      const size_t i = c%kChunkChannels;
+      for(uint64_t k = chunk.channelPacket[i]; k < chunk.channelPacket[i+1]; k++){
+        Packet const& p = chunk.packets[k];
+        const size_t tick = f*fTicksPerFrame + p.tick;
+        if(open && tick != roiTick + roi.size()){   // it didn't go on after all
+          store.AddROI(roiTick, roi.data(), roi.size());
+          open = false;
+        }
+        if(!open){
+          roiTick = tick;
+          roi.clear();
+        }
+        roi.insert(roi.end(), chunk.samples.begin() + p.sample0, chunk.samples.begin() + p.sample0 + p.length);
+        open = p.goesOn;
+        if(!open) store.AddROI(roiTick, roi.data(), roi.size());
+      }
+    }
+    if(open) store.AddROI(roiTick, roi.data(), roi.size());
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+// writer
+
+sn::SNStreamWriter::SNStreamWriter(std::string const& path, size_t ticksPerFrame, size_t framesPerEvent)
+  : fPath(path)
+  , fFile(nullptr)
+  , fTicksPerFrame(ticksPerFrame)
+  , fFramesPerEvent(framesPerEvent)
+  , fNEvents(0)
+  , fNBad(0)
+  , fBytes(0)
+{
+  if(ticksPerFrame == 0 || ticksPerFrame > 0x7fff || framesPerEvent == 0)
+    throw std::runtime_error("SNStreamWriter: frames of " + std::to_string(ticksPerFrame) + " ticks can't be written");
+  fFile = std::fopen(path.c_str(), "wb");
+  if(!fFile) throw std::runtime_error("SNStreamWriter: can't write " + path);
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, 8);
+  header.version = kVersion;
+  header.ticksPerFrame = ticksPerFrame;
+  header.framesPerEvent = framesPerEvent;
+  Write(&header, sizeof(header));
+}
+
+sn::SNStreamWriter::~SNStreamWriter()
+{
+  if(fFile) std::fclose(fFile);
+}
+
+void sn::SNStreamWriter::Write(void const* data, size_t bytes)
+{
+  if(std::fwrite(data, 1, bytes, fFile) != bytes)
+    throw std::runtime_error("SNStreamWriter: can't write to " + fPath);
+  fBytes += bytes;
+}
+
+void sn::SNStreamWriter::AddEvent(int run, int event, std::vector<recob::Wire> const& wires)
+{
+  fScratch.Fill(wires);
+  AddEvent(run, event, fScratch);
+}
+
+void sn::SNStreamWriter::AddEvent(int run, int event, RawROIStore const& store)
+{
+  if(!fFile) throw std::runtime_error("SNStreamWriter: " + fPath + " is closed");
+  const size_t nTicks = fTicksPerFrame*fFramesPerEvent;
+  for(size_t r=0; r<store.NROIs(); r++)
+    if(store.FirstTick(r) + store.Length(r) > nTicks)
+      throw std::runtime_error("SNStreamWriter: run " + std::to_string(run) + " event " + std::to_string(event)
+                               + " has ROIs past tick " + std::to_string(nTicks));
+
+  for(size_t f=0; f<fFramesPerEvent; f++){
+    EncodeFrame(store, f);
+    FrameHeader fh;
+    std::memset(&fh, 0, sizeof(fh));
+    fh.sync = kFrameSync;
+    fh.run = run;
+    fh.event = event;
+    fh.frame = f;
+    fh.nChannels = store.NWires();
+    fh.bytes = fPayload.size();
+    Write(&fh, sizeof(fh));
+    Write(fPayload.data(), fPayload.size());
+  }
+  fNEvents++;
+}
+
+void sn::SNStreamWriter::EncodeFrame(RawROIStore const& store, size_t frame)
+{
+  const size_t frameLow = frame*fTicksPerFrame;
+  const size_t frameHigh = frameLow + fTicksPerFrame;
+  auto put16 = [this](uint16_t v){
+    fPayload.push_back(v & 0xff);
+    fPayload.push_back(v >> 8);
+  };
+
+  fPayload.assign(store.NWires()*sizeof(ChannelEntry), 0);
+  for(size_t w=0; w<store.NWires(); w++){
+    const ChannelEntry entry{ store.Channel(w), uint32_t(fPayload.size()) };
+    std::memcpy(fPayload.data() + w*sizeof(ChannelEntry), &entry, sizeof(entry));
+
+    const size_t countAt = fPayload.size();
+    uint16_t nPackets = 0;
+    put16(0);
+    for(size_t r=store.FirstROI(w); r<store.EndROI(w); r++){
+      // the part of the ROI in this frame
+      const size_t t0 = store.FirstTick(r), t1 = t0 + store.Length(r);
+      size_t lo = std::max(t0, frameLow), hi = std::min(t1, frameHigh);
+      if(t0 == t1){   // empty, in the frame of its tick (the last one for the tick after the event)
+        if(std::min(t0/fTicksPerFrame, fFramesPerEvent-1) != frame) continue;
+        lo = hi = t0;
+      }
+      else if(lo >= hi) continue;
+
+      put16(lo - frameLow);
+      put16((hi - lo) | (t1 > frameHigh ? kGoesOn : 0));
+      int16_t const* adc = store.ADC(r);
+      int prev = 0;
+      for(size_t k = lo - t0; k < hi - t0; k++){
+        if(store.HasBad(r) && store.IsBad(r, k)) fNBad++;   // stored as 0 already
+        const int v = adc[k];
+        const uint32_t z = Zigzag(v - prev);
+        if(z < 0x80) fPayload.push_back(z);
+        else if(z < 0x4000){
+          fPayload.push_back(0x80 | (z >> 8));
+          fPayload.push_back(z & 0xff);
+        }
+        else{
+          fPayload.push_back(0xc0);
+          put16(uint16_t(v));
+        }
+        prev = v;
+      }
+      nPackets++;
+    }
+    fPayload[countAt] = nPackets & 0xff;
+    fPayload[countAt+1] = nPackets >> 8;
+  }
+  fPayload.resize((fPayload.size() + 7)/8*8, 0);
+}
+
+void sn::SNStreamWriter::Close()
+{
+  if(!fFile) return;
+  const bool ok = std::fclose(fFile) == 0;
+  fFile = nullptr;
+  if(!ok) throw std::runtime_error("SNStreamWriter: can't finish " + fPath);
+}
+
+bool sn::CheckStreamEvent(RawROIStore const& written, RawROIStore const& decoded, size_t ticksPerFrame,
+                          SNStreamCheck& check, std::ostream& out)
+{
+  const size_t before = check.nMismatches;
+  auto mismatch = [&check, &out](std::string const& what){
+    if(check.nMismatches++ < kMaxReported) out << "  " << what << std::endl;
+  };
+  check.nEvents++;
+
+  if(written.NWires() != decoded.NWires()){
+    mismatch(std::to_string(written.NWires()) + " wires written, " + std::to_string(decoded.NWires()) + " read");
+    return false;
+  }
+  for(size_t w=0; w<written.NWires(); w++){
+    const std::string wire = "channel " + std::to_string(written.Channel(w));
+    if(written.Channel(w) != decoded.Channel(w)){
+      mismatch("wire " + std::to_string(w) + ": " + wire + " written, channel " + std::to_string(decoded.Channel(w)) + " read");
+      continue;
+    }
+    const size_t nWritten = written.EndROI(w) - written.FirstROI(w);
+    const size_t nDecoded = decoded.EndROI(w) - decoded.FirstROI(w);
+    if(nWritten != nDecoded){
+      mismatch(wire + ": " + std::to_string(nWritten) + " ROIs written, " + std::to_string(nDecoded) + " read");
+      continue;
+    }
+
+    for(size_t i=0; i<nWritten; i++){
+      const size_t r = written.FirstROI(w) + i, d = decoded.FirstROI(w) + i;
+      const size_t t0 = written.FirstTick(r), length = written.Length(r);
+      const std::string roi = wire + ", ROI at tick " + std::to_string(t0);
+      check.nROIs++;
+      check.nSamples += length;
+      if(length && t0/ticksPerFrame != (t0 + length - 1)/ticksPerFrame) check.nCrossing++;
+
+      if(decoded.FirstTick(d) != t0 || decoded.Length(d) != length){
+        mismatch(roi + ": " + std::to_string(length) + " samples written, read back at tick "
+                 + std::to_string(decoded.FirstTick(d)) + " with " + std::to_string(decoded.Length(d)));
+        continue;
+      }
+
+      // as the writer encodes them: each sample against the one before, the first of each frame against 0
+      int16_t const* a = written.ADC(r);
+      int16_t const* b = decoded.ADC(d);
+      int prev = 0;
+      bool same = true;
+      for(size_t k=0; k<length; k++){
+        if((t0 + k) % ticksPerFrame == 0) prev = 0;
+        if(Zigzag(a[k] - prev) >= 0x4000) check.nWide++;
+        prev = a[k];
+        if(a[k] != b[k] && same){
+          mismatch(roi + ": sample " + std::to_string(k) + " written " + std::to_string(a[k]) + ", read " + std::to_string(b[k]));
+          same = false;
+        }
+      }
+    }
+  }
+  return check.nMismatches == before;
+}
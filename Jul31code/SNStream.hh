@@ -0,0 +1,148 @@
+//***************************
+//    binary supernova stream: the "sndaq" ROIs frame by frame, without art
+//
+//    SNStreamWriter encodes events of ROIs (a RawROIStore or the wires) into frames,
+//    SNStream maps a stream file and decodes an event straight into a RawROIStore,
+//    the channels of its frames split over a ChannelPool. SNDriver reads a stream
+//    like an art file or a cache, so the quick-look analyses run on DAQ-like files.
+//
+//    the file is a header and then frames, one after the other:
+//      file header    "SNSTRM\0\1", version, ticksPerFrame, framesPerEvent
+//      frame header   sync "SNFR", run, event, frame number in the event (0 first),
+//                     nChannels, bytes of the payload
+//      payload        nChannels x {channel, offset of its block in the payload},
+//                     then the channel blocks, padded to 8 bytes
+//      channel block  uint16 nPackets, and per packet (one ROI, zero-suppression
+//                     pre- and postsamples included): uint16 first tick in the frame,
+//                     uint16 nSamples (bit 15: the ROI goes on in the next frame),
+//                     then the samples, each as the difference to the one before
+//                     (the first to 0), zigzagged: 1 byte below 0x80, 2 bytes
+//                     0x80|high6 low8 up to 0x3fff, or 0xc0 and the int16 itself
+//    every frame of an event has the same channels in the same order, every channel
+//    a block (nPackets 0 if it has nothing). Everything is little endian, as written.
+//    An ROI across a frame boundary is split there and joined again when read, so an
+//    event comes back with the ROIs it went in with; the samples that are not ADC
+//    counts (RawROIStore::IsBad) come back as 0, the DAQ never had them.
+//    CheckStreamEvent() compares an event read back with the one written
+//    (snstream -check, snbench).
+//***************************
+
+#ifndef SN_SNSTREAM_HH
+#define SN_SNSTREAM_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <iosfwd>
+#include <stdint.h>
+#include <stdlib.h>
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+#include "RawROIStore.hh"
+
+namespace sn{
+
+  class ChannelPool;
+
+  class SNStream{
+
+  public:
+    explicit SNStream(std::string const& path);   // throws std::runtime_error if it is not a stream
+    ~SNStream();
+    SNStream(SNStream const&) = delete;
+    SNStream& operator=(SNStream const&) = delete;
+
+    // does the file start like a stream?
+    static bool IsStream(std::string const& path);
+
+    size_t NEvents() const { return fEvents.size(); }
+    int Run(size_t entry) const { return fEvents[entry].run; }
+    int Event(size_t entry) const { return fEvents[entry].event; }
+    size_t TicksPerFrame() const { return fTicksPerFrame; }
+    size_t FramesPerEvent() const { return fFramesPerEvent; }
+    size_t NTicks() const { return fTicksPerFrame*fFramesPerEvent; }   // of an event
+    size_t Bytes(size_t entry) const;   // of its frames in the file
+
+    // decodes one event into store (refilled, so a worker can keep using the same one);
+    // with a pool the channels of all its frames are decoded in parallel
+    void GetEvent(size_t entry, RawROIStore& store, ChannelPool* pool = nullptr) const;
+
+  private:
+    struct FrameRef{
+      char const* payload;
+      uint64_t bytes;
+      uint32_t nChannels;
+    };
+    struct EventRef{
+      int run;
+      int event;
+      size_t firstFrame;
+    };
+
+    std::string fPath;
+    void* fMap;
+    size_t fMapSize;
+    size_t fTicksPerFrame;
+    size_t fFramesPerEvent;
+    std::vector<FrameRef> fFrames;
+    std::vector<EventRef> fEvents;
+  };
+
+  // writes a stream one event at a time (sndaq files into streams, synthetic test data)
+  class SNStreamWriter{
+
+  public:
+    // ticksPerFrame up to 32767 (a frame of MicroBooNE's SN stream is 3200 ticks)
+    explicit SNStreamWriter(std::string const& path, size_t ticksPerFrame = 3200, size_t framesPerEvent = 2);
+    ~SNStreamWriter();
+    SNStreamWriter(SNStreamWriter const&) = delete;
+    SNStreamWriter& operator=(SNStreamWriter const&) = delete;
+
+    // every ROI has to end within the ticksPerFrame*framesPerEvent ticks of an event
+    void AddEvent(int run, int event, RawROIStore const& store);
+    void AddEvent(int run, int event, std::vector<recob::Wire> const& wires);
+
+    void Close();
+
+    size_t NEvents() const { return fNEvents; }
+    size_t NBadSamples() const { return fNBad; }   // written as 0
+    size_t Bytes() const { return fBytes; }
+
+  private:
+    void Write(void const* data, size_t bytes);
+    void EncodeFrame(RawROIStore const& store, size_t frame);
+
+    std::string fPath;
+    std::FILE* fFile;
+    size_t fTicksPerFrame;
+    size_t fFramesPerEvent;
+    size_t fNEvents;
+    size_t fNBad;
+    size_t fBytes;
+    RawROIStore fScratch;             // the wires of AddEvent
+    std::vector<uint8_t> fPayload;    // one frame
+  };
+
+  // what the checks of a stream against what went into it have covered
+  struct SNStreamCheck{
+    size_t nEvents = 0;
+    size_t nROIs = 0;
+    size_t nSamples = 0;
+    size_t nCrossing = 0;     // ROIs across a frame boundary, split in the stream and joined again
+    size_t nWide = 0;         // samples 0x4000 or more (zigzagged) from the one before: the 3 byte form
+    size_t nMismatches = 0;   // ROIs (or wires) that did not come back as they went in
+  };
+
+  // compares an event decoded from a stream with the store it was written from, wire by
+  // wire and ROI by ROI: channel, first tick, length and every sample (those that were
+  // not ADC counts as 0). Adds up what it went through in check and prints the first
+  // differences to out; true if the event came back as it went in
+  bool CheckStreamEvent(RawROIStore const& written, RawROIStore const& decoded, size_t ticksPerFrame,
+                        SNStreamCheck& check, std::ostream& out);
+
+}
+
+#endif
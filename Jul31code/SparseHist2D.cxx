@@ -0,0 +1,209 @@
+//***************************
+//    sparse 2D histogram for the channel x quantity plots
+//***************************
+
+#include "SparseHist2D.hh"
+
+//some standard C++ includes
+#include <cmath>
+#include <algorithm>
+
+sn::SparseHist2D::SparseHist2D(const char* name, const char* title,
+                               int nbinsx, double xlow, double xup,
+                               int nbinsy, double ylow, double yup)
+  : fName(name)
+  , fTitle(title)
+  , fNx(nbinsx)
+  , fNy(nbinsy)
+  , fXlow(xlow)
+  , fXup(xup)
+  , fYlow(ylow)
+  , fYup(yup)
+  , fNTilesX((nbinsx+2 + kTileBins-1) / kTileBins)
+  , fNTilesY((nbinsy+2 + kTileBins-1) / kTileBins)
+  , fSumw2(TH1::GetDefaultSumw2())
+  , fEntries(0)
+  , fTsumw(0), fTsumw2(0), fTsumwx(0), fTsumwx2(0), fTsumwy(0), fTsumwy2(0), fTsumwxy(0)
+{}
+
+void sn::SparseHist2D::AddStats(SparseHist2D const& other)
+{
+  fEntries = std::fabs(fEntries + other.fEntries);
+  fTsumw += other.fTsumw;
+  fTsumw2 += other.fTsumw2;
+  fTsumwx += other.fTsumwx;
+  fTsumwx2 += other.fTsumwx2;
+  fTsumwy += other.fTsumwy;
+  fTsumwy2 += other.fTsumwy2;
+  fTsumwxy += other.fTsumwxy;
+}
+
+void sn::SparseHist2D::PutStats(TH2& h) const
+{
+  double stats[7] = { fTsumw, fTsumw2, fTsumwx, fTsumwx2, fTsumwy, fTsumwy2, fTsumwxy };
+  h.PutStats(stats);
+  h.SetEntries(fEntries);
+}
+
+template<typename T, typename TH2Type>
+void sn::SparseTH2<T,TH2Type>::EnableSumw2()
+{
+  fSumw2 = true;
+  fTilesSumw2.resize(NTiles());
+  for(size_t tile=0; tile<fTiles.size(); tile++){
+    if(!fTiles[tile]) continue;
+    double* sumw2 = SumwTile(tile);
+    for(int cell=0; cell<kTileBins*kTileBins; cell++) sumw2[cell] = fTiles[tile][cell];
+  }
+}
+
+template<typename T, typename TH2Type>
+void sn::SparseTH2<T,TH2Type>::FillN(size_t n, double const* x, double const* y, double const* w)
+{
+  // the bins first, in a loop of their own, then the bins of the same tile go one after the other
+  std::vector<int> binx(n), biny(n);
+  for(size_t i=0; i<n; i++) binx[i] = BinX(x[i]);
+  for(size_t i=0; i<n; i++) biny[i] = BinY(y[i]);
+
+  fEntries += n;
+  for(size_t i=0; i<n; i++){
+    const size_t tile = Tile(binx[i], biny[i]);
+    const int cell = Cell(binx[i], biny[i]);
+    if(!w){
+      if(fSumw2) ++SumwTile(tile)[cell];
+      AddOne(ContentTile(tile)[cell]);
+      AddStats(binx[i], biny[i], x[i], y[i], 1);
+      continue;
+    }
+    if(!fSumw2 && w[i] != 1.0) EnableSumw2();
+    if(w[i] != 0){
+      if(fSumw2) SumwTile(tile)[cell] += w[i]*w[i];
+      AddWeight(ContentTile(tile)[cell], w[i]);
+    }
+    AddStats(binx[i], biny[i], x[i], y[i], w[i]);
+  }
+}
+
+template<typename T, typename TH2Type>
+void sn::SparseTH2<T,TH2Type>::FillColumn(double x, size_t firstY, float const* w, size_t n)
+{
+  const int binx = BinX(x);
+  const bool xInside = binx > 0 && binx <= fNx;
+  // whole ticks on an axis of unit bins from a whole number: the bin is y-low+1,
+  // the number FindBin gets to with its division
+  const bool unitY = fYup - fYlow == fNy && fYlow == std::floor(fYlow);
+
+  fEntries += n;
+  bool zeros = false;
+  size_t tile = size_t(-1);
+  Sum* content = nullptr;
+  double* sumw2 = nullptr;
+  for(size_t j=0; j<n; j++){
+    const double wj = w[j];
+    // a weight of 0 is an entry and nothing else (but turns on sumw2 like any weight other than 1)
+    if(wj == 0){ zeros = true; continue; }
+    if(!fSumw2 && (zeros || wj != 1.0)){
+      EnableSumw2();
+      tile = size_t(-1);
+    }
+
+    const double y = double(firstY+j);
+    const int biny = !unitY ? BinY(y) : (y < fYlow ? 0 : (y < fYup ? int(y-fYlow)+1 : fNy+1));
+    if(Tile(binx, biny) != tile){
+      tile = Tile(binx, biny);
+      content = ContentTile(tile);
+      sumw2 = fSumw2 ? SumwTile(tile) : nullptr;
+    }
+    const int cell = Cell(binx, biny);
+    if(sumw2) sumw2[cell] += wj*wj;
+    AddWeight(content[cell], wj);
+
+    if(xInside && biny > 0 && biny <= fNy){
+      fTsumw += wj;
+      fTsumw2 += wj*wj;
+      fTsumwx += wj*x;
+      fTsumwx2 += wj*x*x;
+      fTsumwy += wj*y;
+      fTsumwy2 += wj*y*y;
+      fTsumwxy += wj*x*y;
+    }
+  }
+  if(!fSumw2 && zeros) EnableSumw2();
+}
+
+template<typename T, typename TH2Type>
+void sn::SparseTH2<T,TH2Type>::Add(SparseTH2 const& other)
+{
+  // a bin without errors contributes its content as error^2, as in TH1::Add
+  if(!fSumw2 && other.fSumw2) EnableSumw2();
+
+  for(size_t tile=0; tile<fTiles.size(); tile++){
+    Sum const* theirs = other.fTiles[tile].get();
+    if(!theirs) continue;
+    Sum* mine = ContentTile(tile);
+    for(int cell=0; cell<kTileBins*kTileBins; cell++) mine[cell] += theirs[cell];
+    if(fSumw2){
+      double* sumw2 = SumwTile(tile);
+      double const* theirsSumw2 = other.fSumw2 ? other.fTilesSumw2[tile].get() : nullptr;
+      for(int cell=0; cell<kTileBins*kTileBins; cell++)
+        sumw2[cell] += theirsSumw2 ? theirsSumw2[cell] : double(theirs[cell]);
+    }
+  }
+
+  AddStats(other);
+}
+
+template<typename T, typename TH2Type>
+std::unique_ptr<TH2Type> sn::SparseTH2<T,TH2Type>::MakeTH2() const
+{
+  std::unique_ptr<TH2Type> h(new TH2Type(fName.c_str(), fTitle.c_str(), fNx, fXlow, fXup, fNy, fYlow, fYup));
+  if(fSumw2 && h->GetSumw2N() == 0) h->Sumw2();
+
+  T* content = h->GetArray();
+  double* sumw2 = fSumw2 ? h->GetSumw2()->GetArray() : nullptr;
+  const int nx = fNx+2, ny = fNy+2;
+  for(size_t ty=0; ty<fNTilesY; ty++){
+    for(size_t tx=0; tx<fNTilesX; tx++){
+      const size_t tile = ty*fNTilesX + tx;
+      if(!fTiles[tile]) continue;
+      const int x0 = tx*kTileBins, y0 = ty*kTileBins;
+      const int x1 = std::min(nx, x0+kTileBins), y1 = std::min(ny, y0+kTileBins);
+      for(int biny=y0; biny<y1; biny++){
+        Sum const* row = &fTiles[tile][Cell(x0,biny)];
+        for(int k=0; k<x1-x0; k++) content[size_t(biny)*nx + x0 + k] = Content(row[k]);
+        if(sumw2 && fTilesSumw2[tile])
+          std::copy(&fTilesSumw2[tile][Cell(x0,biny)], &fTilesSumw2[tile][Cell(x0,biny)] + (x1-x0), sumw2 + size_t(biny)*nx + x0);
+      }
+    }
+  }
+
+  PutStats(*h);
+  return h;
+}
+
+template<typename T, typename TH2Type>
+size_t sn::SparseTH2<T,TH2Type>::NTilesUsed() const
+{
+  size_t n = 0;
+  for(auto const& tile : fTiles) if(tile) n++;
+  return n;
+}
+
+template<typename T, typename TH2Type>
+size_t sn::SparseTH2<T,TH2Type>::Bytes() const
+{
+  size_t bytes = fTiles.size()*sizeof(fTiles[0]) + fTilesSumw2.size()*sizeof(fTilesSumw2[0]);
+  bytes += NTilesUsed()*kTileBins*kTileBins*sizeof(Sum);
+  for(auto const& tile : fTilesSumw2) if(tile) bytes += kTileBins*kTileBins*sizeof(double);
+  return bytes;
+}
+
+template<typename T, typename TH2Type>
+size_t sn::SparseTH2<T,TH2Type>::DenseBytes() const
+{
+  const size_t nCells = size_t(fNx+2)*(fNy+2);
+  return nCells*sizeof(T) + (fSumw2 ? nCells*sizeof(double) : 0);
+}
+
+template class sn::SparseTH2<float, TH2F>;
+template class sn::SparseTH2<int, TH2I>;
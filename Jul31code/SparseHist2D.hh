@@ -0,0 +1,193 @@
+//***************************
+//    sparse 2D histogram for the channel x quantity plots
+//
+//    a TH2F/TH2I over 8256 channels and a few thousand value bins is 30-70M
+//    bins, nearly all of them zero. SparseTH2 keeps the same binning in tiles
+//    of 64x64 bins (under/overflow included) that are only allocated when a
+//    fill lands in them, and turns into the real TH2 only when it gets drawn or
+//    written (MakeTH2). Bin contents, sumw2, entries and the fill statistics
+//    are kept the way TH2::Fill and TH1::Add keep them, so the TH2 comes out
+//    the same as if it had been filled directly. The integer bins add up in
+//    64 bits (adding workers together can't overflow them) and are clamped to
+//    +-INT_MAX, as TH2I does, only when the TH2I is made.
+//***************************
+
+#ifndef SN_SPARSEHIST2D_HH
+#define SN_SPARSEHIST2D_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <memory>
+#include <climits>
+#include <stdint.h>
+
+//some ROOT includes
+#include "TH2F.h"
+#include "TH2I.h"
+
+namespace sn{
+
+  // binning, statistics and tile bookkeeping; the contents are in SparseTH2
+  class SparseHist2D{
+
+  public:
+    SparseHist2D(const char* name, const char* title,
+                 int nbinsx, double xlow, double xup,
+                 int nbinsy, double ylow, double yup);
+    virtual ~SparseHist2D() {}
+
+    virtual void Fill(double x, double y) = 0;
+    virtual void Fill(double x, double y, double w) = 0;
+    // n fills at once: Fill(x[i],y[i]) in order, or Fill(x[i],y[i],w[i]) if w is given
+    virtual void FillN(size_t n, double const* x, double const* y, double const* w = nullptr) = 0;
+    // h.Add(&other); other has to be the same type and binning
+    virtual void Add(SparseHist2D const& other) = 0;
+
+    const char* GetName() const { return fName.c_str(); }
+    const char* GetTitle() const { return fTitle.c_str(); }
+    double GetEntries() const { return fEntries; }
+
+    size_t NTiles() const { return fNTilesX*fNTilesY; }
+    virtual size_t NTilesUsed() const = 0;
+    // what the tiles take now, and what the TH2 takes once it is made
+    virtual size_t Bytes() const = 0;
+    virtual size_t DenseBytes() const = 0;
+
+  protected:
+    static constexpr int kTileShift = 6;
+    static constexpr int kTileBins = 1 << kTileShift;   // per axis
+    static constexpr int kTileMask = kTileBins - 1;
+
+    // TAxis::FindBin for fixed bins: 0 underflow, nbins+1 overflow (NaN too)
+    static int FindBin(double v, int nbins, double low, double up){
+      if(v < low) return 0;
+      if(!(v < up)) return nbins+1;
+      return 1 + int(nbins*(v-low)/(up-low));
+    }
+    int BinX(double x) const { return FindBin(x, fNx, fXlow, fXup); }
+    int BinY(double y) const { return FindBin(y, fNy, fYlow, fYup); }
+    size_t Tile(int binx, int biny) const { return size_t(biny >> kTileShift)*fNTilesX + (binx >> kTileShift); }
+    static int Cell(int binx, int biny) { return ((biny & kTileMask) << kTileShift) | (binx & kTileMask); }
+
+    // TH2::Fill: the statistics only count fills inside the axes
+    // (TH1::StatOverflows is left at its default)
+    void AddStats(int binx, int biny, double x, double y, double w){
+      if(binx == 0 || binx > fNx || biny == 0 || biny > fNy) return;
+      fTsumw += w;
+      fTsumw2 += w*w;
+      fTsumwx += w*x;
+      fTsumwx2 += w*x*x;
+      fTsumwy += w*y;
+      fTsumwy2 += w*y*y;
+      fTsumwxy += w*x*y;
+    }
+    void AddStats(SparseHist2D const& other);
+    void PutStats(TH2& h) const;
+
+    std::string fName;
+    std::string fTitle;
+    int fNx, fNy;
+    double fXlow, fXup, fYlow, fYup;
+    size_t fNTilesX, fNTilesY;
+
+    bool fSumw2;   // TH1::Sumw2 is on: by default, or since the first fill with a weight other than 1
+    double fEntries;
+    double fTsumw, fTsumw2, fTsumwx, fTsumwx2, fTsumwy, fTsumwy2, fTsumwxy;
+  };
+
+  // what the tiles add up in for a bin content T: the same, but int64_t for int
+  template<typename T> struct SparseSum { typedef T type; };
+  template<> struct SparseSum<int> { typedef int64_t type; };
+
+  // T is the bin content of the TH2 it stands for: float for a TH2F, int for a TH2I
+  template<typename T, typename TH2Type>
+  class SparseTH2 final : public SparseHist2D{
+
+  public:
+    typedef typename SparseSum<T>::type Sum;
+
+    SparseTH2(const char* name, const char* title,
+              int nbinsx, double xlow, double xup,
+              int nbinsy, double ylow, double yup)
+      : SparseHist2D(name, title, nbinsx, xlow, xup, nbinsy, ylow, yup)
+      , fTiles(NTiles())
+    { if(fSumw2) fTilesSumw2.resize(NTiles()); }
+
+    // h.Fill(x,y)
+    void Fill(double x, double y) override {
+      fEntries++;
+      const int binx = BinX(x), biny = BinY(y);
+      const size_t tile = Tile(binx, biny);
+      const int cell = Cell(binx, biny);
+      if(fSumw2) ++SumwTile(tile)[cell];
+      AddOne(ContentTile(tile)[cell]);
+      AddStats(binx, biny, x, y, 1);
+    }
+
+    // h.Fill(x,y,w); a weight of 0 changes no bin, so it allocates nothing
+    void Fill(double x, double y, double w) override {
+      fEntries++;
+      const int binx = BinX(x), biny = BinY(y);
+      if(!fSumw2 && w != 1.0) EnableSumw2();
+      if(w != 0){
+        const size_t tile = Tile(binx, biny);
+        const int cell = Cell(binx, biny);
+        if(fSumw2) SumwTile(tile)[cell] += w*w;
+        AddWeight(ContentTile(tile)[cell], w);
+      }
+      AddStats(binx, biny, x, y, w);
+    }
+
+    // the bins of all n are worked out first, then the tiles are filled in order
+    void FillN(size_t n, double const* x, double const* y, double const* w = nullptr) override;
+
+    // Fill(x, firstY+i, w[i]) for i < n: a whole wire's samples into its channel column,
+    // with the x bin looked up once, the tile once per 64 ticks, and the zeros of a
+    // zero-padded wire only counted (the sums only differ from Fill's in the sign of a zero)
+    void FillColumn(double x, size_t firstY, float const* w, size_t n);
+
+    // h.Add(&other), the way TH1::Add(h,1) adds up the bins and the statistics
+    void Add(SparseTH2 const& other);
+    void Add(SparseHist2D const& other) override { Add(dynamic_cast<SparseTH2 const&>(other)); }
+
+    // the TH2 with everything filled so far, booked in gDirectory like any other.
+    // It is a full dense copy: make it when it is drawn or written, and let it go after
+    std::unique_ptr<TH2Type> MakeTH2() const;
+
+    size_t NTilesUsed() const override;
+    size_t Bytes() const override;
+    size_t DenseBytes() const override;
+
+  private:
+    static void AddOne(float& c) { c++; }
+    static void AddOne(int64_t& c) { c++; }
+    static void AddWeight(float& c, double w) { c += float(w); }
+    static void AddWeight(int64_t& c, double w) { c += int64_t(int(w)); }   // the weight truncated, as TH2I::Fill does
+    // into the TH2: TH2I::AddBinContent clamps at +-INT_MAX
+    static float Content(float c) { return c; }
+    static int Content(int64_t c) { return c > INT_MAX ? INT_MAX : (c < -INT_MAX ? -INT_MAX : int(c)); }
+
+    Sum* ContentTile(size_t tile){
+      if(!fTiles[tile]) AllocateTile(tile);
+      return fTiles[tile].get();
+    }
+    double* SumwTile(size_t tile){
+      if(!fTilesSumw2[tile]) fTilesSumw2[tile].reset(new double[kTileBins*kTileBins]());
+      return fTilesSumw2[tile].get();
+    }
+    void AllocateTile(size_t tile){ fTiles[tile].reset(new Sum[kTileBins*kTileBins]()); }
+
+    // TH1::Sumw2 on a filled histogram: the errors so far are the contents
+    void EnableSumw2();
+
+    std::vector< std::unique_ptr<Sum[]> > fTiles;
+    std::vector< std::unique_ptr<double[]> > fTilesSumw2;   // empty unless fSumw2
+  };
+
+  typedef SparseTH2<float, TH2F> SparseTH2F;
+  typedef SparseTH2<int, TH2I> SparseTH2I;
+
+}
+
+#endif
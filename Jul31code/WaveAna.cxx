@@ -0,0 +1,469 @@
+//***************************
+//    analysis of SN readout waveforms
+//    Clara Berger 6/20/18
+//***************************
+
+#include "WaveAna.hh"
+#include "ROIView.h"
+#include "ChannelPool.hh"
+#include "ROIFeatures.hh"
+#include "SNMemory.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+//some ROOT includes
+#include "TCanvas.h"
+#include "TPad.h"
+#include "TMath.h"
+#include "TLine.h"
+
+using namespace std;
+
+void sn::WaveAna::ProcessEvent(SNEvent const& evt)
+{
+  int event = evt.event;
+  auto const& wire_vec(*evt.wires);
+
+  // difference to interpolation in 3 planes
+  // kept out of the output file (only the canvas is written) and drawn at the end, so workers never touch the graphics
+  EventInterpol interpol;
+  interpol.entry = evt.entry;
+  interpol.event = event;
+
+  // they are all kept until Finish(), three TH1I of 3200 bins an event: under a memory budget,
+  // the events past it go without (everything else is still filled)
+  if(MemoryBudget::TryBook(3*(3200+2)*sizeof(int))){
+    interpol.hInterpolU.reset(new TH1I(Form("hinterpolu_event%d",event),Form("Event %d Difference to interpolation U; ADC_{i} - (ADC_{i+1} + ADC_{i-1})/2 (ADC); Frequency",event), 3200, 0, 3200));//changed from 4096 to zoom in
+    interpol.hInterpolV.reset(new TH1I(Form("hinterpolv_event%d",event),Form("Event %d Difference to interpolation V; ADC_{i} - (ADC_{i+1} + ADC_{i-1})/2 (ADC); Frequency",event ), 3200, 0, 3200));
+    interpol.hInterpolY.reset(new TH1I(Form("hinterpoly_event%d",event),Form("Event %d Difference to interpolation Y; ADC_{i} - (ADC_{i+1} + ADC_{i-1})/2 (ADC); Frequency",event), 3200, 0, 3200));
+    interpol.hInterpolU->SetDirectory(0);
+    interpol.hInterpolV->SetDirectory(0);
+    interpol.hInterpolY->SetDirectory(0);
+  }
+  else if(!fInterpolRefused){
+    std::cout << "WaveAna: the memory budget is used up, no more difference to interpolation histograms from event "
+              << event << " on" << std::endl;
+    fInterpolRefused = true;
+  }
+
+  // the wires don't depend on each other, so they may go in chunks over the channel threads
+  ForEachWireChunk(evt, [&](size_t firstWire, size_t lastWire, FillBuffer& fills){
+      ProcessWires(wire_vec, interpol, firstWire, lastWire, fills);
+    });
+
+  if(interpol.hInterpolU) fInterpol.push_back(std::move(interpol));
+}
+
+void sn::WaveAna::ProcessWires(std::vector<recob::Wire> const& wire_vec, EventInterpol& interpol, size_t firstWire, size_t lastWire, FillBuffer& fills)
+{
+  TH1I* hInterpolU = interpol.hInterpolU.get();   // null: not kept for this event (ProcessEvent)
+  TH1I* hInterpolV = interpol.hInterpolV.get();
+  TH1I* hInterpolY = interpol.hInterpolY.get();
+
+  // reused from wire to wire
+  sn::ROIFeatureTable features;
+
+  for (size_t i=firstWire; i<lastWire;i++){
+    int channel = wire_vec[i].Channel();
+
+    //cumulative length of ROIs
+    double lengthperframe=0;
+
+    // one pass over the samples of each ROI (see ROIFeatures.hh), then fill from the table
+    features.clear();
+    for (auto const& ROI : sn::ROIs(wire_vec[i]))   // no copies of the sparse_vector or its ranges
+      sn::ExtractROIFeatures(ROI, features);
+
+    for (size_t r = 0; r < features.size(); r++) {
+      const size_t firstTick = features.firstTick[r];
+      const size_t endTick = firstTick + features.length[r];
+
+
+	// histogram of first - last ROI signal for each of the 3 planes
+	// (only where the last sample isn't one of the zeros; it used to fill whatever diff was left over)
+	if (features.lastSample[r]>1){    // to make sure we're not getting any of the zeros
+	  double diff = features.firstSample[r]-features.lastSample[r];
+	  if(channel <= 2400){
+	    fills.Fill(hDiffFirstLastSampleU,diff);}
+	  else if(channel>2400 && channel <=4800){
+	    fills.Fill(hDiffFirstLastSampleV,diff);}
+	  else
+	    {fills.Fill(hDiffFirstLastSampleY,diff);}
+	}
+
+
+	// mean
+	fills.Fill(fMeanStats,channel,features.mean[r]);
+	if(fFullHists) fills.Fill(hMean,channel,features.mean[r]);
+
+
+	// variance
+	fills.Fill(fVarianceStats,channel,features.variance[r]);
+	if(fFullHists) fills.Fill(hVariance,channel,features.variance[r]);
+
+
+	// integral
+	fills.Fill(hInt,channel,features.integral[r]);
+
+
+	// first sample passing the threshold
+	double firstsample = features.firstRise[r];
+	if(channel <= 2400){
+	  fills.Fill(hFirstSamplePassingThresholdu,firstsample);}
+	else if(channel >2400 && channel <=4800){
+	  fills.Fill(hFirstSamplePassingThresholdv,firstsample);}
+	else
+	    {fills.Fill(hFirstSamplePassingThresholdy,firstsample);}
+
+
+	// last sample passing the threshold
+	double lastsample = features.lastFall[r];
+      if(channel <= 2400){
+        fills.Fill(hLastSamplePassingThresholdu,lastsample);}
+      else if(channel >2400 && channel <=4800){
+        fills.Fill(hLastSamplePassingThresholdv,lastsample);}
+      else
+	  {fills.Fill(hLastSamplePassingThresholdy,lastsample);}
+
+
+	// difference to interpolation
+	for (size_t k = features.diffBegin[r]; k < features.diffBegin[r+1]; k++ ){
+	  const double difftoint = features.diffToInterpol[k];
+	  fills.Fill(hDiffToInterpol,channel,difftoint);
+	  if(!hInterpolU) continue;
+	  if(channel <= 2400){
+	    fills.Fill(*hInterpolU,difftoint);}
+	  else if(channel >2400 && channel <=4800){
+	    fills.Fill(*hInterpolV,difftoint);}
+	  else
+	    {fills.Fill(*hInterpolY,difftoint);}
+	}
+
+	// length per frame
+	lengthperframe += endTick-firstTick;
+
+
+	// first presample
+	fills.Fill(fBaselineFirstStats,channel,features.firstSample[r]);
+	if(fFullHists) fills.Fill(hBaselineFirstSample,channel,features.firstSample[r]);
+
+
+	// last postsample
+	fills.Fill(fBaselineLastStats,channel,features.lastSample[r]);
+	if(fFullHists) fills.Fill(hBaselineLastSample,channel,features.lastSample[r]);
+	if(channel > 4800 && features.lastSample[r]>1500){
+	  fills.Add(fHighLastY,1);}
+
+
+	// tick value of first sample
+	fills.Fill(fTickStats,channel,firstTick);
+	if(fFullHists) fills.Fill(hTick,channel,firstTick);
+
+
+    } //end loop over ROI
+
+    fills.Fill(hLengthFrame,channel,(lengthperframe/6400)); //divide by 6400 the length of the event to get the ratio ROI length / frame /total event length
+
+ }//end loop over wires
+
+}
+
+void sn::WaveAna::Finish()
+{
+  std::cout << fHighLastY << " Y plane ROIs with the last sample above 1500 ADC" << std::endl;
+
+  // diff to interpolation in 3 plots, one canvas per event in the order they were read
+  std::sort(fInterpol.begin(), fInterpol.end(),
+            [](EventInterpol const& a, EventInterpol const& b){ return a.entry < b.entry; });
+  for(auto const& interpol : fInterpol){
+    int event = interpol.event;
+    TCanvas c11(Form("c_event%d",event),Form("c_event%d",event),900,400);
+    c11.Divide(3,1);
+    c11.cd(1);
+    interpol.hInterpolU->Draw("hist ][");
+    interpol.hInterpolU->GetYaxis()->SetRangeUser(0,1000);
+    c11.cd(2);
+    interpol.hInterpolV->Draw("hist ][");
+    interpol.hInterpolV->GetYaxis()->SetRangeUser(0,1000);
+    c11.cd(3);
+    interpol.hInterpolY->Draw("hist ][");
+    interpol.hInterpolY->GetYaxis()->SetRangeUser(0,1000);
+    c11.cd();
+    c11.Write();
+  }
+
+  //histograms in 3 planes for first sample -last sample
+  TCanvas c1("c1","c1",900,400);
+  c1.Divide(3,1);
+  // histogram of means
+  TCanvas c2("c2","c2",900,600);
+  //histogram of variance
+  TCanvas c3("c3","c3",900,600);
+  //histogram of the integral of the signal
+  TCanvas c4("c4","c4",900,600);
+  // first sample passing the threshold
+  TCanvas c5("c5","c5",1100,500);
+  c5.Divide(3,1);
+  // last sample passing the threshold
+  TCanvas c6("c6","c6",1100,500);
+  c6.Divide(3,1);
+  // difference to interpolation
+  TCanvas c7("c7","c7",900,600);
+  // cumulative length of ROIs per frame
+  TCanvas c8("lengthframeratio","lengthframeratio",900,600);
+  // first presample
+  TCanvas c9("c9","c9",700,900);
+  c9.Divide(1,2);
+  // distribution of tick values
+  TCanvas c10("c10","c10",900,600);
+
+  //diff
+  c1.cd(1);
+  hDiffFirstLastSampleU.Draw("hist ][");
+  hDiffFirstLastSampleU.SetLineColor(kBlack);
+  // hDiffFirstLastSampleU.GetXaxis()->SetRangeUser(-100,100);    //if you wanted to zoom in to better see the width of the plots
+  c1.cd(2);
+  hDiffFirstLastSampleV.Draw("hist ][");
+  hDiffFirstLastSampleV.SetLineColor(kBlack);
+  //hDiffFirstLastSampleV.GetXaxis()->SetRangeUser(-100,100);
+  c1.cd(3);
+  hDiffFirstLastSampleY.Draw("hist ][");
+  hDiffFirstLastSampleY.SetLineColor(kBlack);
+  //hDiffFirstLastSampleY.GetXaxis()->SetRangeUser(-100,100);
+  c1.cd();
+  c1.Write();
+  //  c1.Print("diffzoom.png");
+
+  // the sparse histograms become TH2s one at a time: each is drawn, written and let go
+  // before the next one is made, so only one of them is ever dense, and only if it fits
+  // in the memory budget (see DenseBooking in SNMemory.hh).
+  // Without SetFullHists, or without room for the TH2, the canvases show the per-channel
+  // mean +- standard deviation instead
+
+  //mean
+  {
+    DenseBooking dense(hMean.GetName(), fFullHists ? hMean.DenseBytes() : 0);
+    const bool full = fFullHists && dense;
+    std::unique_ptr<TH1> h;
+    if(full) h = hMean.MakeTH2();
+    else h = fMeanStats.MakeTH1(ChannelStats::kMean);
+    c2.cd();
+    h->Draw(full ? "colz" : "E");
+    c2.Write();
+    if(full) h->Write();
+  }
+
+  //variance
+  {
+    DenseBooking dense(hVariance.GetName(), fFullHists ? hVariance.DenseBytes() : 0);
+    const bool full = fFullHists && dense;
+    std::unique_ptr<TH1> h;
+    if(full) h = hVariance.MakeTH2();
+    else h = fVarianceStats.MakeTH1(ChannelStats::kMean);
+    c3.cd();
+    h->Draw(full ? "colz" : "E");
+    h->SetLineColor(kBlack);
+    c3.Write();
+    if(full) h->Write();
+  }
+
+  //integral
+  if(DenseBooking dense{hInt.GetName(), hInt.DenseBytes()}){
+    auto h = hInt.MakeTH2();
+    c4.cd();
+    h->Draw("colz");
+    c4.Write();
+    h->Write();
+  }
+
+  //first passing threshold
+  c5.cd(1);
+  hFirstSamplePassingThresholdu.Draw("hist ][");
+  hFirstSamplePassingThresholdu.SetLineColor(kBlack);
+  TLine line(-25,0,-25,18000);
+  line.SetLineColor(kRed);
+  line.Draw();
+  c5.cd(2);
+  hFirstSamplePassingThresholdv.Draw("hist ][");
+  hFirstSamplePassingThresholdv.SetLineColor(kBlack);
+  TLine line2(-15,0,-15,27000);
+  line2.SetLineColor(kRed);
+  line2.Draw();
+  TLine line3(15,0,15,27000);
+  line3.SetLineColor(kRed);
+  line3.Draw();
+  c5.cd(3);
+  hFirstSamplePassingThresholdy.Draw("hist ][");
+  hFirstSamplePassingThresholdy.SetLineColor(kBlack);
+  TLine line4(30,0,30,21000);
+  line4.SetLineColor(kRed);
+  line4.Draw();
+  c5.cd();
+  c5.Write();
+
+  //last passing threshold
+  c6.cd(1);
+  hLastSamplePassingThresholdu.Draw("hist ][");
+  hLastSamplePassingThresholdu.SetLineColor(kBlack);
+  c6.cd(2);
+  hLastSamplePassingThresholdv.Draw("hist ][");
+  hLastSamplePassingThresholdv.SetLineColor(kBlack);
+  c6.cd(3);
+  hLastSamplePassingThresholdy.Draw("hist ][");
+  hLastSamplePassingThresholdy.SetLineColor(kBlack);
+  c6.cd();
+  c6.Write();
+
+  //diff to interpolation
+  if(DenseBooking dense{hDiffToInterpol.GetName(), hDiffToInterpol.DenseBytes()}){
+    auto h = hDiffToInterpol.MakeTH2();
+    c7.cd();
+    h->Draw("colz");
+    for(int i=0;i<14;i++)
+      {TLine *lines = new TLine();
+        lines->SetLineColor(13);
+        lines->DrawLine(0,pow(2,i),8256,pow(2,i));
+        delete lines;}
+    c7.Write();
+    h->Write();
+  }
+
+  //ROI/frame
+  if(DenseBooking dense{hLengthFrame.GetName(), hLengthFrame.DenseBytes()}){
+    auto h = hLengthFrame.MakeTH2();
+    c8.cd();
+    h->Draw("colz");
+    c8.SetLogz();
+    c8.Print(".png");
+    c8.Write();
+    h->Write();
+  }
+
+  //first baseline
+  {
+    // both on the canvas at once
+    DenseBooking dense("hBaselineFirstSample and hBaselineLastSample",
+                       fFullHists ? hBaselineFirstSample.DenseBytes() + hBaselineLastSample.DenseBytes() : 0);
+    const bool full = fFullHists && dense;
+    std::unique_ptr<TH1> hFirst, hLast;
+    if(full){
+      hFirst = hBaselineFirstSample.MakeTH2();
+      hLast = hBaselineLastSample.MakeTH2();
+    }
+    else{
+      hFirst = fBaselineFirstStats.MakeTH1(ChannelStats::kMean);
+      hLast = fBaselineLastStats.MakeTH1(ChannelStats::kMean);
+    }
+    c9.cd(1);
+    hFirst->Draw(full ? "colz" : "E");
+    c9.cd(2);
+    hLast->Draw(full ? "colz" : "E");
+    c9.cd();
+    c9.Write();
+    if(full){
+      hFirst->Write();
+      hLast->Write();
+    }
+  }
+
+  //first tick value of sample
+  {
+    DenseBooking dense(hTick.GetName(), fFullHists ? hTick.DenseBytes() : 0);
+    const bool full = fFullHists && dense;
+    std::unique_ptr<TH1> h;
+    if(full) h = hTick.MakeTH2();
+    else h = fTickStats.MakeTH1(ChannelStats::kMean);
+    c10.cd();
+    h->Draw(full ? "colz" : "E");
+    c10.Write();
+    if(full) h->Write();
+  }
+
+  // the per-channel summaries: <name>_mean, _stddev, _min, _max, _count
+  for(ChannelStats const* stats : Stats())
+    stats->Write();
+}
+
+std::vector<TH1*> sn::WaveAna::Hists()
+{
+  return { &hDiffFirstLastSampleU,
+           &hDiffFirstLastSampleV,
+           &hDiffFirstLastSampleY,
+           &hFirstSamplePassingThresholdu,
+           &hFirstSamplePassingThresholdv,
+           &hFirstSamplePassingThresholdy,
+           &hLastSamplePassingThresholdu,
+           &hLastSamplePassingThresholdv,
+           &hLastSamplePassingThresholdy };
+}
+
+std::vector<sn::ChannelStats*> sn::WaveAna::Stats()
+{
+  return { &fMeanStats,
+           &fVarianceStats,
+           &fBaselineFirstStats,
+           &fBaselineLastStats,
+           &fTickStats };
+}
+
+std::vector<sn::SparseHist2D*> sn::WaveAna::SparseHists()
+{
+  return { &hMean,
+           &hVariance,
+           &hInt,
+           &hDiffToInterpol,
+           &hLengthFrame,
+           &hBaselineFirstSample,
+           &hBaselineLastSample,
+           &hTick };
+}
+
+sn::SNStage* sn::WaveAna::NewWorker() const
+{
+  WaveAna* worker = new WaveAna();
+  worker->fFullHists = fFullHists;
+  return worker;
+}
+
+void sn::WaveAna::Merge(SNStage& worker)
+{
+  WaveAna& other = dynamic_cast<WaveAna&>(worker);
+  std::vector<TH1*> mine = Hists();
+  std::vector<TH1*> theirs = other.Hists();
+  for(size_t i_h=0; i_h<mine.size(); i_h++)
+    mine[i_h]->Add(theirs[i_h]);
+  std::vector<SparseHist2D*> mineSparse = SparseHists();
+  std::vector<SparseHist2D*> theirsSparse = other.SparseHists();
+  for(size_t i_h=0; i_h<mineSparse.size(); i_h++)
+    mineSparse[i_h]->Add(*theirsSparse[i_h]);
+  std::vector<ChannelStats*> mineStats = Stats();
+  std::vector<ChannelStats*> theirsStats = other.Stats();
+  for(size_t i_s=0; i_s<mineStats.size(); i_s++)
+    mineStats[i_s]->Merge(*theirsStats[i_s]);
+
+  for(auto& interpol : other.fInterpol)
+    fInterpol.push_back(std::move(interpol));
+  other.fInterpol.clear();
+  fHighLastY += other.fHighLastY;
+}
+
+size_t sn::WaveAna::BookingBytes()
+{
+  // first - last sample in 3 planes, first and last sample passing threshold in 3 planes
+  return 3*HistBytes(8192, 0, sizeof(int)) + 6*HistBytes(400, 0, sizeof(int));
+}
+
+size_t sn::WaveAna::SparseBytes()
+{
+  size_t bytes = 0;
+  for(auto const* h : SparseHists()) bytes += h->Bytes();
+  for(auto const* s : Stats()) bytes += s->Bytes();
+  for(auto const& interpol : fInterpol)
+    bytes += sn::HistBytes(*interpol.hInterpolU) + sn::HistBytes(*interpol.hInterpolV) + sn::HistBytes(*interpol.hInterpolY);
+  return bytes;
+}
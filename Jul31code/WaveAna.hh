@@ -0,0 +1,112 @@
+//***************************
+//    analysis of SN readout waveforms
+//    Clara Berger 6/20/18
+//***************************
+
+#ifndef SN_WAVEANA_HH
+#define SN_WAVEANA_HH
+
+//some standard C++ includes
+#include <vector>
+#include <memory>
+
+//some ROOT includes
+#include "TH1F.h"
+#include "TH2S.h"
+
+#include "SNStage.hh"
+#include "FillBuffer.h"
+#include "SparseHist2D.hh"
+#include "ChannelStats.hh"
+
+namespace sn{
+
+  class WaveAna : public SNStage{
+
+  public:
+    size_t MaxEvents() const override { return 100; }
+    void ProcessEvent(SNEvent const& evt) override;
+    void Finish() override;
+
+    bool RunsInParallel() const override { return true; }
+    SNStage* NewWorker() const override;
+    void Merge(SNStage& worker) override;
+    size_t SparseBytes() override;
+    static size_t BookingBytes();   // the histogram members below, before they are booked
+
+    // mean, variance, first/last sample and first tick are kept per channel (ChannelStats);
+    // their full channel x quantity TH2s are only filled and written on request
+    void SetFullHists(bool full) { fFullHists = full; }
+
+  private:
+    bool fFullHists = false;
+
+    // everything that gets filled, in one list for merging
+    std::vector<TH1*> Hists();
+    // the channel x quantity plots are sparse, made into TH2s one at a time in Finish()
+    std::vector<SparseHist2D*> SparseHists();
+
+    //histograms in 3 planes for first sample -last sample
+    TH1I hDiffFirstLastSampleU{"hDiffFirstLastSampleu", "First - last ADC U; First - last (ADC); Frequency", 8192, -4096, 4096};
+    TH1I hDiffFirstLastSampleV{"hDiffFirstLastSamplev", "First - last ADC V; First - last (ADC); Frequency", 8192, -4096, 4096};
+    TH1I hDiffFirstLastSampleY{"hDiffFirstLastSampley", "First - last ADC Y; First - last (ADC); Frequency", 8192, -4096, 4096};
+
+    // per channel: mean, variance, first presample, last postsample, tick of the first sample
+    ChannelStats fMeanStats{"hMean", "Mean (ADC)"};
+    ChannelStats fVarianceStats{"hVariance", "Variance (ADC^{2})"};
+    ChannelStats fBaselineFirstStats{"hBaselineFirstSample", "First sample (ADC)"};
+    ChannelStats fBaselineLastStats{"hBaselineLastSample", "Last sample (ADC)"};
+    ChannelStats fTickStats{"hTick", "Tick"};
+    std::vector<ChannelStats*> Stats();
+
+    // histogram of means (SetFullHists)
+    SparseTH2F hMean{"hMean", "Mean; Channel; Mean (ADC)", 8256, 0, 8256, 4096, 0, 4096};
+
+    //histogram of variance (SetFullHists)
+    SparseTH2F hVariance{"hVariance", "FPGA-like variance; Channel; Variance (ADC^{2})", 8256, 0, 8256, 4096, 0, 4096};
+
+    //histogram of the integral of the signal
+    SparseTH2I hInt{"hInt", "ROI integral (baseline subtracted using 1st sample); Channel; ROI integral (ADC)", 8256, 0, 8256, 8192, -4096, 4096};
+
+    // first sample passing the threshold
+    TH1I hFirstSamplePassingThresholdu{"hFirstSamplePassingThresholdu","First sample passing U threshold - first presample ADC; ADC; Frequency",400,-200,200};
+    TH1I hFirstSamplePassingThresholdv{"hFirstSamplePassingThresholdv","First sample passing V threshold - first presample ADC; ADC; Frequency",400,-200,200};
+    TH1I hFirstSamplePassingThresholdy{"hFirstSamplePassingThresholdy","First sample passing Y threshold - first presample ADC; ADC; Frequency",400,-200,200};
+
+    // last sample passing the threshold
+    TH1I hLastSamplePassingThresholdu{"hLastSamplePassingThresholdu", "Last sample passing threshold - last postsample ADC; Channel; ADC", 400, -200, 200};
+    TH1I hLastSamplePassingThresholdv{"hLastSamplePassingThresholdv", "Last sample passing threshold - last postsample ADC; Channel; ADC", 400, -200, 200};
+    TH1I hLastSamplePassingThresholdy{"hLastSamplePassingThresholdy", "Last sample passing threshold - last postsample ADC; Channel; ADC", 400,-200, 200};
+
+    // difference to interpolation
+    SparseTH2F hDiffToInterpol{"hDiffToInterpol", "Difference to interpolation; Channel; ADC_{i} - (ADC_{i+1} + ADC_{i-1})/2 (ADC)", 8256, 0, 8256, 4096, 0, 4096};
+
+    // cumulative length of ROIs per frame
+    SparseTH2I hLengthFrame{"hLengthFrame", "Suppression Factor; Channel; Cumulative length per frame/length of frame", 8256, 0, 8256, 6400, 0, 1};
+
+    // first presample (SetFullHists)
+    SparseTH2I hBaselineFirstSample{"hBaselineFirstSample", "First presample ADC; Channel; First sample (ADC)", 8256, 0, 8256, 4096, 0, 4096};
+    SparseTH2I hBaselineLastSample{"hBaselineLastSample", "Last postsample ADC; Channel; Last sample (ADC)", 8256, 0, 8256, 4096, 0, 4096};
+
+    // distribution of tick values (SetFullHists)
+    SparseTH2F hTick{"hTick", "Tick value of first ROI sample; Channel; Tick", 8256, 0, 8256, 3200, 0, 3200};
+
+    // difference to interpolation in 3 planes for every event, drawn one canvas per event in Finish()
+    struct EventInterpol{
+      size_t entry;
+      int event;
+      std::unique_ptr<TH1I> hInterpolU, hInterpolV, hInterpolY;
+    };
+    std::vector<EventInterpol> fInterpol;
+    bool fInterpolRefused = false;   // by the memory budget (SNMemory.hh), said once
+
+    // Y plane ROIs whose last sample is above 1500 ADC, said once in Finish()
+    double fHighLastY = 0;
+
+    // the wires [firstWire,lastWire) of one event; everything shared is filled through fills
+    void ProcessWires(std::vector<recob::Wire> const& wire_vec, EventInterpol& interpol, size_t firstWire, size_t lastWire, FillBuffer& fills);
+  };
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+//***************************
+//    a bounded store of waveforms to look at after the job
+//***************************
+
+#include "WaveformSnapshots.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <map>
+#include <thread>
+
+//for fork
+#include <unistd.h>
+#include <sys/wait.h>
+
+//some ROOT includes
+#include "TROOT.h"
+#include "TSystem.h"
+#include "TH1D.h"
+#include "TCanvas.h"
+
+sn::SnapshotStore::SnapshotStore(size_t capacity, Policy policy, unsigned seed)
+  : fCapacity(capacity)
+  , fPolicy(policy)
+  , fOffered(0)
+  , fRandom(seed)
+{
+  fKept.reserve(capacity);   // the slots handed out don't move
+}
+
+sn::WaveformSnapshot* sn::SnapshotStore::Offer()
+{
+  fOffered++;
+  if(fKept.size() < fCapacity){
+    fKept.emplace_back();
+    return &fKept.back();
+  }
+  if(fPolicy == kFirst || fCapacity == 0) return nullptr;
+
+  // reservoir sampling: the n-th waveform replaces a random one with probability capacity/n
+  const size_t j = std::uniform_int_distribution<size_t>(0, fOffered-1)(fRandom);
+  if(j >= fCapacity) return nullptr;
+  fKept[j] = WaveformSnapshot();
+  return &fKept[j];
+}
+
+namespace {
+
+  // snapshots worker, worker+nWorkers, ... each to its own png
+  void DrawSnapshots(std::vector<sn::WaveformSnapshot> const& snapshots, std::vector<std::string> const& names,
+                     std::string const& dir, size_t worker, size_t nWorkers)
+  {
+    for(size_t i=worker; i<snapshots.size(); i+=nWorkers){
+      sn::WaveformSnapshot const& snap = snapshots[i];
+      TH1D horig(("roi_" + names[i]).c_str(), snap.title.c_str(), snap.nTicks, snap.firstTick, snap.firstTick + snap.nTicks);
+      for(size_t k=0; k<snap.samples.size(); k++)
+        horig.Fill((int)(snap.sampleTick + k), snap.samples[k]);
+      TCanvas c1(names[i].c_str(), "c1", 900, 600);
+      horig.Draw("hist ]");
+      c1.Print((dir + "/" + names[i] + ".png").c_str());
+    }
+  }
+
+}
+
+void sn::RenderSnapshots(std::vector<WaveformSnapshot> const& snapshots, std::string const& dir,
+                         size_t nWorkers)
+{
+  if(snapshots.empty()) return;
+
+  // every png gets its own name, so no two workers write the same file
+  std::vector<std::string> names;
+  std::map<std::string, int> seen;
+  for(auto const& snap : snapshots){
+    const int n = ++seen[snap.name];
+    names.push_back(n == 1 ? snap.name : snap.name + "_" + std::to_string(n));
+  }
+
+  gSystem->mkdir(dir.c_str(), kTRUE);
+
+  if(nWorkers == 0) nWorkers = std::thread::hardware_concurrency();
+  if(nWorkers == 0) nWorkers = 1;
+  if(nWorkers > snapshots.size()) nWorkers = snapshots.size();
+
+  const bool batch = gROOT->IsBatch();
+  gROOT->SetBatch(kTRUE);
+  const bool addDirectory = TH1::AddDirectoryStatus();
+  TH1::AddDirectory(kFALSE);
+
+  // the workers get a copy of the snapshots with the fork and only write their pngs;
+  // worker 0 is this process
+  std::vector<pid_t> workers;
+  for(size_t w=1; w<nWorkers; w++){
+    const pid_t pid = fork();
+    if(pid == 0){
+      DrawSnapshots(snapshots, names, dir, w, nWorkers);
+      _exit(0);
+    }
+    if(pid < 0){
+      std::cerr << "Can't start worker " << w << ", drawing its waveforms here" << std::endl;
+      DrawSnapshots(snapshots, names, dir, w, nWorkers);
+    }
+    else
+      workers.push_back(pid);
+  }
+  DrawSnapshots(snapshots, names, dir, 0, nWorkers);
+
+  bool failed = false;
+  for(pid_t pid : workers){
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = true;
+  }
+
+  TH1::AddDirectory(addDirectory);
+  gROOT->SetBatch(batch);
+  if(failed) std::cerr << "A worker failed, some waveforms in " << dir << "/ are missing" << std::endl;
+  std::cout << "Drew " << snapshots.size() << " waveforms into " << dir << "/" << std::endl;
+}
@@ -0,0 +1,65 @@
+//***************************
+//    a bounded store of waveforms to look at after the job
+//
+//    instead of booking a TH1D and a TCanvas for every ROI of every event (and maybe
+//    printing it), the analyses offer the ROI to a SnapshotStore. Only the ones it keeps
+//    get their samples copied, and nothing touches the graphics until RenderSnapshots
+//    draws the kept ones at the end, in several processes (ROOT's graphics are not for
+//    threads, as in renderframes).
+//***************************
+
+#ifndef SN_WAVEFORMSNAPSHOTS_HH
+#define SN_WAVEFORMSNAPSHOTS_HH
+
+//some standard C++ includes
+#include <string>
+#include <vector>
+#include <random>
+#include <stdlib.h>
+
+namespace sn{
+
+  // what the per-ROI canvas showed: a TH1D of nTicks bins from firstTick, filled with
+  // samples[k] at tick sampleTick+k (fills outside the range end up in under/overflow, as before)
+  struct WaveformSnapshot{
+    std::string name;    // canvas name, and the name of the png
+    std::string title;   // histogram title with the axis titles
+    size_t firstTick;
+    size_t nTicks;
+    size_t sampleTick;
+    std::vector<float> samples;
+  };
+
+  class SnapshotStore{
+
+  public:
+    // kFirst keeps the first 'capacity' waveforms offered, kReservoir a uniform sample of all of
+    // them (seeded, so a rerun keeps the same ones)
+    enum Policy { kFirst, kReservoir };
+
+    explicit SnapshotStore(size_t capacity = 100, Policy policy = kReservoir, unsigned seed = 14662);
+
+    // the slot for the waveform being offered, or null if it isn't kept. Fill it in before
+    // the next Offer(); whatever was in the slot is thrown away
+    WaveformSnapshot* Offer();
+
+    size_t Offered() const { return fOffered; }
+    std::vector<WaveformSnapshot> const& Kept() const { return fKept; }
+
+  private:
+    size_t fCapacity;
+    Policy fPolicy;
+    size_t fOffered;
+    std::mt19937 fRandom;
+    std::vector<WaveformSnapshot> fKept;
+  };
+
+  // draws every snapshot "hist ]" on a 900x600 canvas and prints it to <dir>/<name>.png
+  // (a name that comes up more than once gets _2, _3, ... added), in batch mode by
+  // nWorkers forked processes. 0 workers: one per core
+  void RenderSnapshots(std::vector<WaveformSnapshot> const& snapshots, std::string const& dir,
+                       size_t nWorkers = 0);
+
+}
+
+#endif
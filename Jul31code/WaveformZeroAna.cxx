@@ -0,0 +1,189 @@
+//***************************
+//    waveforms where the first sample passing threshold - last postsample is 0
+//***************************
+
+#include "WaveformZeroAna.hh"
+#include "ROIView.h"
+#include "SNMemory.hh"
+
+//some standard C++ includes
+#include <iostream>
+#include <vector>
+
+//some ROOT includes
+#include "TH1D.h"
+#include "TCanvas.h"
+#include "TPad.h"
+#include "TLine.h"
+
+using namespace std;
+
+namespace{
+
+  // h.Fill(tick, ROI[tick]) for ticks [firstTick, endTick), in one FillN; ticks and adcs are
+  // the caller's scratch, kept from one ROI to the next
+  void FillWaveform(TH1D& h, sn::ROIView const& ROI, size_t firstTick, size_t endTick,
+                    std::vector<double>& ticks, std::vector<double>& adcs){
+    ticks.clear();
+    adcs.clear();
+    for(size_t iTick = firstTick; iTick < endTick; iTick++){
+      ticks.push_back(int(iTick));
+      adcs.push_back(ROI[iTick]);
+    }
+    h.FillN(ticks.size(), ticks.data(), adcs.data());
+  }
+
+}
+
+void sn::WaveformZeroAna::ProcessEvent(SNEvent const& evt)
+{
+  int event = evt.event;
+
+  cout<<event<<endl;
+
+  auto const& wire_vec(*evt.wires);
+
+  for (unsigned int i=0; i<wire_vec.size();i++){
+    int channel = wire_vec[i].Channel();
+
+
+    for (auto const& ROI : sn::ROIs(wire_vec[i])) {   // no copies of the sparse_vector or its ranges
+	const int firstTick = ROI.begin_index();
+	const size_t lastTick = ROI.end_index() - 1;   // the ROI's last sample, end_index() is one past it
+
+
+
+	// look at waveforms where the difference between the first passing sample and the last post sample is 0
+	double firstpost; //fist sample passing threshold - the last post sample
+
+	//last sample - second to last sample
+	double secondlast;
+
+
+      if(ROI[lastTick]>1){   // not counting when the last tick is 0 or very small
+        firstpost = ROI[firstTick+7]-ROI[lastTick];
+	  secondlast = ROI[lastTick]-ROI[lastTick-1];
+
+	  //histogram to show waveforms
+        TH1D horig("roi_original", "ROI where first sample passing threshold - last postsample is 0;Tick;ADC", lastTick + 1 - firstTick, firstTick, lastTick + 1);
+        horig.SetLineColor(kBlack);
+
+        FillWaveform(horig, ROI, ROI.begin_index(), lastTick + 1, fTicks, fADCs);  //fill up to lastTick
+
+	  if (channel >2400 && channel <=4800 && firstpost>=0 && firstpost<1){
+          TCanvas c(Form("c_%d_%d_V",event,channel),Form("c%d_Y",channel),900,500);
+          horig.Draw("hist ]");
+          //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<" to "<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick]<<"="<<firstpost<<"\n";
+	    if ( ROI.size()>17 ){
+	      vevents += 1;
+	      if (firstTick != 1600 && firstTick != 4800){hSecondLastV.Fill(secondlast);}} // not on the frame boundaries
+	    //Cout<<uevents<<' '<<vevents<<' '<<yevents<<endl;
+	    //	      c.Print(".png");
+        }
+	  if ( channel <=2400 && firstpost>=0 && firstpost<1){
+          TCanvas c(Form("c_%d_%d_U",event,channel),Form("c%d_Y",channel),900,500);
+          horig.Draw("hist ]");
+          //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<" to "<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick]<<"="<<firstpost<<"\n";
+	    if ( ROI.size()>17){
+	      uevents += 1;
+	      if(secondlast==0){
+	    //cout<<uevents<<' '<<vevents<<' '<<yevents<<endl;
+          //c.Print(".png");
+		if (firstTick != 1600 && firstTick != 4800){ hSecondLastU.Fill(secondlast);
+		  c.Print(".png");}}}
+	  }
+	  if (channel >4800 && channel <=8256 && firstpost>=0 && firstpost<1){
+          TCanvas c(Form("c_%d_%d_Y",event,channel),Form("c%d_Y",channel),900,500);
+          horig.Draw("hist ]");
+          //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<" to "<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick]<<"="<<firstpost<<"\n";
+	    if ( ROI.size()>17){
+            yevents += 1;
+	    //cout<<uevents<<' '<<vevents<<' '<<yevents<<endl;
+          //c.Print(".png";
+	      if (firstTick != 1600 && firstTick != 4800){hSecondLastY.Fill(secondlast);}}
+        }
+	}
+
+      else
+        {firstpost = ROI[firstTick+7]-ROI[lastTick-1];
+	   secondlast = ROI[lastTick-1]-ROI[lastTick-2];
+
+	   TH1D horig("roi_original", "ROI where first sample passing threshold - last postsample is 0;Tick;ADC", lastTick  - firstTick, firstTick, lastTick);
+	   horig.SetLineColor(kBlack);
+
+	   FillWaveform(horig, ROI, ROI.begin_index(), lastTick, fTicks, fADCs);  // fill up to lastTick-1
+
+	   if (channel >2400 && channel <=4800 && firstpost>=0 && firstpost<1){
+	     TCanvas c(Form("c_%d_%d_V",event,channel),Form("c%d_Y",channel),900,500);
+	     horig.Draw("hist ]");
+	     //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<" to "<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick-1]<<"="<<firstpost<<"\n";
+	     if ( ROI.size()>17){
+	       vevents += 1;
+	     //cout<<uevents<<' '<<vevents<<' '<<yevents<<endl;
+	     //c.Print(".png");
+	       if (firstTick != 1600 && firstTick != 4800){hSecondLastV.Fill(secondlast);}}
+	    }
+	   if (channel <=2400 && firstpost>=0 && firstpost<1){
+	     TCanvas c(Form("c_%d_%d_U",event,channel),Form("c%d_Y",channel),900,500);
+	     horig.Draw("hist ]");
+	     //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<" to "<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick-1]<<"="<<firstpost<<"\n";
+	     if ( ROI.size()>17){
+	       uevents += 1;
+	     //cout<<uevents<<' '<<vevents<<' '<<yevents<<endl;
+	     //c.Print(".png");
+	       if(secondlast==0){
+		 if (firstTick != 1600 && firstTick != 4800){
+		   hSecondLastU.Fill(secondlast);
+		   c.Print(".png");}}}
+	    }
+	   if (channel >4800 && channel <=8256 && firstpost>=0 && firstpost<1){
+	     TCanvas c(Form("c_%d_%d_Y",event,channel),Form("c%d_Y",channel),900,500);
+	     horig.Draw("hist ]");
+	     //cout<<"event:"<<event<<' '<<"channel:"<<channel<<' '<<firstTick<<" to "<<lastTick<<' '<<ROI[firstTick+7]<<"-"<<ROI[lastTick-1]<<"="<<firstpost<<"\n";
+	     if ( ROI.size()>17){
+	       yevents += 1;
+	     //cout<<uevents<<' '<<vevents<<' '<<yevents<<endl;
+	     //c.Print(".png");
+	       if (firstTick != 1600 && firstTick != 4800){hSecondLastY.Fill(secondlast);}}
+	   }
+        } // end else
+
+    } //end loop over ROIs
+  } //end loop over wires
+}
+
+size_t sn::WaveformZeroAna::BookingBytes()
+{
+  return 3*HistBytes(200, 0, sizeof(float));   // last - second last sample in 3 planes
+}
+
+void sn::WaveformZeroAna::Finish()
+{
+  //last sample - second to last sample
+  TCanvas c1("c_secondlast","c1",1100,400);
+  c1.Divide(3,1);
+
+  c1.cd(1);
+  hSecondLastU.Draw();
+  TLine lineI(-25,0,-25,22);
+  lineI.SetLineColor(kRed);
+  lineI.Draw();
+  c1.cd(2);
+  hSecondLastV.Draw();
+  TLine line2(-15,0,-15,62);
+  line2.SetLineColor(kRed);
+  line2.Draw();
+  TLine line3(15,0,15,62);
+  line3.SetLineColor(kRed);
+  line3.Draw();
+  c1.cd(3);
+  hSecondLastY.Draw();
+  TLine line4(30,0,30,32);
+  line4.SetLineColor(kRed);
+  line4.Draw();
+
+  c1.cd();
+  c1.Print(".png");
+
+  cout<<"induction plane events: "<<uevents+vevents<<"(U: "<< uevents<< " V: "<<vevents<<" )   collection plane events: "<<yevents<<endl;
+}
@@ -0,0 +1,44 @@
+//***************************
+//    waveforms where the first sample passing threshold - last postsample is 0
+//***************************
+
+#ifndef SN_WAVEFORMZEROANA_HH
+#define SN_WAVEFORMZEROANA_HH
+
+//some standard C++ includes
+#include <vector>
+
+//some ROOT includes
+#include "TH1F.h"
+
+#include "SNStage.hh"
+
+namespace sn{
+
+  class WaveformZeroAna : public SNStage{
+
+  public:
+    size_t MaxEvents() const override { return 200; }
+    void ProcessEvent(SNEvent const& evt) override;
+    void Finish() override;
+    static size_t BookingBytes();   // the histogram members below, before they are booked
+
+  private:
+    // how many of the repeating samples do we see in the induction vs collection channels
+    int uevents = 0;
+    int vevents = 0;
+    int yevents = 0;
+
+    // ticks and ADCs of the waveform being drawn
+    std::vector<double> fTicks;
+    std::vector<double> fADCs;
+
+    //last sample - second to last sample
+    TH1F hSecondLastU{"hSecondlastu", "Last Sample - Second Last Sample ADC U; Last Sample - (Last-1) Sample; Frequency", 200, -100, 100};
+    TH1F hSecondLastV{"hSecondlastv", "Last Sample - Second Last Sample ADC V; Last Sample - (Last-1) Sample; Frequency", 200, -100, 100};
+    TH1F hSecondLastY{"hSecondlasty", "Last Sample - Second Last Sample ADC Y; Last Sample - (Last-1) Sample; Frequency", 200, -100, 100};
+  };
+
+}
+
+#endif
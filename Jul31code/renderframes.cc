@@ -0,0 +1,152 @@
+//***************************
+//    draws the animation frames of ReadSNSwizzledData (<N>events_frames.snpyr)
+//
+//    renderframes frames.snpyr output.gif [-j nWorkers] [-z zmax] [-mp4 output.mp4] [-keep]
+//
+//    every frame is drawn offscreen (batch mode) to a PNG, by nWorkers processes
+//    at once (ROOT's graphics are not for threads), then the PNGs are put
+//    together into the GIF, and into an MP4 with ffmpeg if asked for. -keep
+//    leaves the PNGs in the frames directory.
+//***************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdlib.h>
+
+//for fork
+#include <unistd.h>
+#include <sys/wait.h>
+
+//some ROOT includes
+#include "TROOT.h"
+#include "TH2F.h"
+#include "TCanvas.h"
+#include "TStyle.h"
+#include "TImage.h"
+
+#include "EventPyramid.hh"
+
+//convenient for us! let's not bother with the std namespace!
+using namespace std;
+
+// frames worker, worker+nWorkers, ... as <dir>/frame_<i>.png
+void DrawFrames(sn::EventPyramid const& frames, string const& dir, size_t worker, size_t nWorkers, double zmax){
+  gStyle->SetOptStat(0);
+  gStyle->SetPalette(55);
+  TCanvas c5("c5","c5",1000,600);
+  for(size_t i=worker; i<frames.NEvents(); i+=nWorkers){
+    // the whole detector at the finest level there is
+    sn::PyramidView view = frames.Read(i, 0, frames.NChannels(), 0, frames.NTicks(), frames.NChannels(), frames.NTicks());
+    auto h = view.MakeTH2F(Form("frame%zu", i), Form("%zu events; Channel; Tick", i+1));
+    h->SetDirectory(nullptr);
+    h->GetZaxis()->SetRangeUser(0, zmax);
+    c5.cd();
+    h->Draw("colz");
+    c5.Print(Form("%s/frame_%05zu.png", dir.c_str(), i));
+  }
+}
+
+// s as one word for the shell: in single quotes, with the single quotes in it closed and escaped
+string ShellQuote(string const& s){
+  string quoted = "'";
+  for(char c : s){
+    if(c == '\'') quoted += "'\\''";
+    else quoted += c;
+  }
+  return quoted + "'";
+}
+
+int main(int argc, char** argv) {
+
+  size_t nWorkers = 4;
+  double zmax = 120000;
+  string mp4;
+  bool keep = false;
+  vector<string> files;
+  for(int i=1; i<argc; i++){
+    string arg(argv[i]);
+    if(arg == "-j" && i+1 < argc) nWorkers = std::max(1, atoi(argv[++i]));
+    else if(arg == "-z" && i+1 < argc) zmax = atof(argv[++i]);
+    else if(arg == "-mp4" && i+1 < argc) mp4 = argv[++i];
+    else if(arg == "-keep") keep = true;
+    else files.push_back(arg);
+  }
+  if(files.size() != 2){
+    cout << "usage: " << argv[0] << " frames.snpyr output.gif [-j nWorkers] [-z zmax] [-mp4 output.mp4] [-keep]" << endl;
+    return 1;
+  }
+
+  gROOT->SetBatch(true);
+  sn::EventPyramid frames(files[0]);
+  if(frames.NEvents() == 0){
+    cout << files[0] << " has no frames" << endl;
+    return 1;
+  }
+
+  char dirTemplate[] = "frames_XXXXXX";
+  if(!mkdtemp(dirTemplate)){
+    cerr << "Can't make a directory for the frames" << endl;
+    return 1;
+  }
+  const string dir(dirTemplate);
+
+  // the workers share the mapped file and nothing else
+  nWorkers = std::min(nWorkers, frames.NEvents());
+  vector<pid_t> workers;
+  for(size_t w=0; w<nWorkers; w++){
+    const pid_t pid = fork();
+    if(pid == 0){
+      DrawFrames(frames, dir, w, nWorkers, zmax);
+      _exit(0);
+    }
+    if(pid < 0){
+      cerr << "Can't start worker " << w << ", drawing its frames here" << endl;
+      DrawFrames(frames, dir, w, nWorkers, zmax);
+    }
+    else
+      workers.push_back(pid);
+  }
+  bool failed = false;
+  for(pid_t pid : workers){
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed = true;
+  }
+  if(failed){
+    cerr << "A worker failed, the frames are left in " << dir << endl;
+    return 1;
+  }
+
+  // the GIF, 30/100 s a frame; the last one is written with "++", which makes it loop
+  remove(files[1].c_str());
+  for(size_t i=0; i<frames.NEvents(); i++){
+    TImage* img = TImage::Open(Form("%s/frame_%05zu.png", dir.c_str(), i));
+    if(!img){
+      cerr << "Can't read frame " << i << endl;
+      continue;
+    }
+    img->WriteImage(Form("%s%s", files[1].c_str(), i+1 < frames.NEvents() ? "+30" : "++"));
+    delete img;
+  }
+  cout << "wrote " << frames.NEvents() << " frames to " << files[1] << endl;
+
+  if(!mp4.empty()){
+    const string command = "ffmpeg -y -loglevel error -framerate 10 -i " + ShellQuote(dir + "/frame_%05d.png")
+      + " -vf 'pad=ceil(iw/2)*2:ceil(ih/2)*2' -pix_fmt yuv420p " + ShellQuote(mp4);
+    if(system(command.c_str()) == 0) cout << "wrote " << mp4 << endl;
+    else cerr << "ffmpeg failed on " << command << endl;
+  }
+
+  if(!keep){
+    for(size_t i=0; i<frames.NEvents(); i++) remove(Form("%s/frame_%05zu.png", dir.c_str(), i));
+    rmdir(dir.c_str());
+  }
+  else
+    cout << "the frames are in " << dir << endl;
+
+  return 0;
+}
@@ -0,0 +1,46 @@
+//***************************
+//    all the SN wire analyses in one pass over the file:
+//    baselines, waveanalysis, flippingbit, occupancyhist and waveform_zero
+//    each still write their own output file, but the wires are only read once per event
+//***************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SNDriver.hh"
+#include "SNOptions.h"
+#include "BaselineAna.hh"
+#include "WaveAna.hh"
+#include "FlippingBitAna.hh"
+#include "OccupancyAna.hh"
+#include "WaveformZeroAna.hh"
+
+//convenient for us! let's not bother with the std namespace!
+using namespace std;
+
+int main(int argc, char** argv) {
+
+  //We specify our files in a list of file names!
+  //Note: multiple files allowed, -j/-t/-p/-m for threads and read-ahead, -H for the full TH2s, -T for the timing, -M for a memory budget (see SNOptions.h).
+  sn::SNOptions opt = sn::ParseOptions(argc, argv);
+  vector<string> filenames = opt.filenames;
+
+  sn::SNDriver driver;
+  driver.SetWorkers(opt.nEventWorkers);
+  driver.SetChannelThreads(opt.nChannelThreads);
+  driver.SetPrefetch(opt.prefetchDepth, opt.prefetchMB);
+  if(!opt.metricsFile.empty()) driver.SetMetrics(opt.metricsFile);   // -T: where the time and memory go
+  driver.SetMemoryBudget(opt.memoryMB);   // -M: before the stages book their histograms
+  driver.SetMaxEvents(opt.maxEvents);   // -n: fewer events than the stages' own
+  driver.AddStage<sn::BaselineAna>("baselines_output.root").SetFullHists(opt.fullHists);   // -H for the full TH2s
+  driver.AddStage<sn::WaveAna>("waveanalysis_output.root").SetFullHists(opt.fullHists);   // -H for the full TH2s
+  driver.AddStage<sn::FlippingBitAna>("flippingbit_output.root");
+  driver.AddStage<sn::OccupancyAna>("occupancyhist_output.root");
+  driver.AddStage<sn::WaveformZeroAna>("");
+  driver.Run(filenames);
+
+  cout<<"success"<<endl;
+}
@@ -0,0 +1,286 @@
+//***************************
+//    benchmarks of the ROI kernels on fixed synthetic events (see SNGenerator.hh)
+//
+//    snbench [-n nEvents] [-s seed] [-r repeats] [-t nThreads] [-only name[,name...]] [-json out.json]
+//
+//    every benchmark runs over all the events 'repeats' times; the best and the
+//    median pass are reported as ns per sample, ROIs/s and events/s. The events
+//    only depend on the seed, so two builds compared with the same -n and -s ran
+//    on the same data. -json writes the table for the comparison scripts.
+//    Before anything is timed, the events are checked to come back from the
+//    SN stream as they went in (with an extra event of the stream's edge cases).
+//***************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <cstdio>
+#include <stdlib.h>
+#include <unistd.h>
+
+//some ROOT includes
+#include "TH1F.h"
+#include "TH2I.h"
+
+#include "SNGenerator.hh"
+#include "SNStream.hh"
+#include "RawROIStore.hh"
+#include "ROIView.h"
+#include "ROIBaseline.hh"
+#include "FlippedBits.hh"
+#include "ROIFeatures.hh"
+#include "FillBuffer.h"
+#include "SparseHist2D.hh"
+#include "ChannelPool.hh"
+
+//convenient for us! let's not bother with the std namespace!
+using namespace std;
+
+// one event of the dataset: the int16 store, and the same ROIs as floats for the float kernels
+struct BenchEvent{
+  sn::RawROIStore store;
+  vector<float> floats;            // every ROI, end to end
+  vector<sn::ROIView> rois;
+};
+
+struct BenchResult{
+  string name;
+  double best;     // s for all the events
+  double median;
+  size_t samples;
+  size_t rois;
+  size_t events;
+};
+
+// keeps the compiler from dropping what the kernels computed
+static volatile double gSink = 0;
+
+// what the generator doesn't make, for the stream check: ROIs across the frame boundary
+// and next to it, samples far enough apart for the 3 byte form, a swizzler error
+void EdgeEvent(sn::RawROIStore& store, size_t ticksPerFrame){
+  vector<int16_t> wide;
+  for(int k=0; k<40; k++) wide.push_back(k%2 ? 32767 : -32768);
+  vector<float> floats(wide.begin(), wide.end());
+  floats[3] = 1e-44;
+
+  store.clear();
+  store.AddWire(0);
+  store.AddROI(ticksPerFrame - 20, wide.data(), wide.size());         // across, every delta wide
+  store.AddWire(1);
+  store.AddROI(ticksPerFrame - 8, wide.data(), 8);                    // up to the boundary,
+  store.AddROI(ticksPerFrame, wide.data() + 1, 8);                    // from it,
+  store.AddROI(2*ticksPerFrame - 10, floats.data(), 10);              // and up to the end of the event
+  store.AddWire(2);
+  store.AddROI(ticksPerFrame - 1, floats.data(), 2);                  // one sample on each side
+}
+
+int main(int argc, char** argv) {
+
+  size_t nEvents = 4;
+  size_t repeats = 5;
+  size_t nThreads = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t seed = 20180731;
+  string json;
+  vector<string> only;
+  for(int i=1; i<argc; i++){
+    string arg(argv[i]);
+    if(arg == "-n" && i+1 < argc) nEvents = std::max(1, atoi(argv[++i]));
+    else if(arg == "-s" && i+1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+    else if(arg == "-r" && i+1 < argc) repeats = std::max(1, atoi(argv[++i]));
+    else if(arg == "-t" && i+1 < argc) nThreads = std::max(1, atoi(argv[++i]));
+    else if(arg == "-json" && i+1 < argc) json = argv[++i];
+    else if(arg == "-only" && i+1 < argc){
+      stringstream names(argv[++i]);
+      string name;
+      while(getline(names, name, ',')) only.push_back(name);
+    }
+    else{
+      cout << "usage: " << argv[0] << " [-n nEvents] [-s seed] [-r repeats] [-t nThreads] [-only name[,name...]] [-json out.json]" << endl;
+      return 1;
+    }
+  }
+
+  // the dataset
+  sn::SNGeneratorConfig config;
+  config.seed = seed;
+  const sn::SNGenerator generator(config);
+  vector<BenchEvent> events(nEvents);
+  size_t nSamples = 0, nROIs = 0;
+  for(size_t e=0; e<nEvents; e++){
+    BenchEvent& ev = events[e];
+    generator.Generate(e, ev.store);
+    // with room on both sides: the feature extraction reads ROI[first+7] and ROI[end-8] of short ROIs too
+    const size_t kPad = 16;
+    vector<size_t> offset;
+    vector<float> samples;
+    ev.floats.assign(kPad, 0);
+    for(size_t r=0; r<ev.store.NROIs(); r++){
+      offset.push_back(ev.floats.size());
+      ev.store.GetFloats(r, samples);
+      ev.floats.insert(ev.floats.end(), samples.begin(), samples.end());
+    }
+    ev.floats.resize(ev.floats.size() + kPad, 0);
+    for(size_t w=0; w<ev.store.NWires(); w++)
+      for(size_t r=ev.store.FirstROI(w); r<ev.store.EndROI(w); r++)
+        ev.rois.push_back(sn::ROIView{ ev.store.Channel(w), ev.store.FirstTick(r), ev.store.Length(r), ev.floats.data() + offset[r] });
+    for(size_t r=0; r<ev.store.NROIs(); r++) nSamples += ev.store.Length(r);
+    nROIs += ev.store.NROIs();
+  }
+
+  // and as a stream, for the decoding
+  char streamPath[] = "/tmp/snbench_XXXXXX";
+  const int fd = mkstemp(streamPath);
+  if(fd < 0){
+    cerr << "Can't make a temporary file for the stream" << endl;
+    return 1;
+  }
+  close(fd);
+  sn::RawROIStore edge;
+  EdgeEvent(edge, config.nTicks/2);
+  {
+    sn::SNStreamWriter writer(streamPath, config.nTicks/2, 2);
+    for(size_t e=0; e<nEvents; e++) writer.AddEvent(1, e, events[e].store);
+    writer.AddEvent(1, nEvents, edge);   // last, out of the way of the benchmarks
+    writer.Close();
+  }
+  sn::SNStream stream(streamPath);
+  remove(streamPath);   // the mapping keeps it while we need it
+
+  // nothing is timed on a stream that doesn't give back what went in
+  {
+    sn::SNStreamCheck check;
+    sn::RawROIStore decoded;
+    for(size_t e=0; e<=nEvents; e++){
+      stream.GetEvent(e, decoded);
+      sn::CheckStreamEvent(e < nEvents ? events[e].store : edge, decoded, stream.TicksPerFrame(), check, cerr);
+    }
+    cout << "stream check: " << check.nROIs << " ROIs, " << check.nCrossing << " across a frame boundary, "
+         << check.nWide << " samples in the 3 byte form, " << check.nMismatches << " differences" << endl;
+    if(check.nMismatches) return 1;
+  }
+
+  cout << nEvents << " events (seed " << seed << "): " << nROIs << " ROIs, " << nSamples << " samples" << endl;
+
+  // scratch the benchmarks share
+  vector<sn::ROIBaseline> baselines;
+  vector<uint64_t> mask;
+  sn::ROIFeatureTable features;
+  sn::RawROIStore decoded;
+  unique_ptr<sn::ChannelPool> pool(nThreads > 1 ? new sn::ChannelPool(nThreads) : nullptr);
+
+  TH1::AddDirectory(kFALSE);
+  TH1F hRise("hRise", "first rise", 400, -200, 200);
+  TH1F hLength("hLength", "ROI length", 100, 0, 100);
+  sn::SparseTH2I hMax("hMax", "maximum", 8256, 0, 8256, 4096, 0, 4096);
+
+  typedef function<void(BenchEvent const&, size_t)> Kernel;
+  vector< pair<string, Kernel> > benchmarks = {
+    { "baseline_float", [&](BenchEvent const& ev, size_t){
+        baselines.resize(ev.rois.size());
+        sn::EstimateBaselines(ev.rois.data(), ev.rois.size(), baselines.data());
+        gSink = gSink + baselines.back().slope;
+      } },
+    { "flipscan_float", [&](BenchEvent const& ev, size_t){
+        size_t n = 0;
+        for(auto const& roi : ev.rois) n += sn::HasFlippedBit(roi.begin(), roi.size());
+        gSink = gSink + n;
+      } },
+    { "flipscan_int16", [&](BenchEvent const& ev, size_t){   // as FlippingBitAna: the floats where int16 can't do it
+        size_t n = 0;
+        sn::RawROIStore const& s = ev.store;
+        for(size_t r=0; r<s.NROIs(); r++)
+          n += (s.Narrow(r) && !s.HasBad(r)) ? sn::HasFlippedBit(s.ADC(r), s.Length(r))
+                                             : sn::HasFlippedBit(ev.rois[r].begin(), ev.rois[r].size());
+        gSink = gSink + n;
+      } },
+    { "flipmask_float", [&](BenchEvent const& ev, size_t){
+        size_t n = 0;
+        for(auto const& roi : ev.rois) n += sn::FlippedBitMask(roi.begin(), roi.size(), mask);
+        gSink = gSink + n;
+      } },
+    { "features", [&](BenchEvent const& ev, size_t){
+        features.clear();
+        for(auto const& roi : ev.rois) sn::ExtractROIFeatures(roi, features);
+        gSink = gSink + features.integral.back();
+      } },
+    { "fills_direct", [&](BenchEvent const& ev, size_t){
+        for(auto const& roi : ev.rois){
+          hRise.Fill(roi[roi.begin_index() + 7] - roi[roi.begin_index()]);
+          hLength.Fill(roi.size());
+          hMax.Fill(roi.channel, *std::max_element(roi.begin(), roi.end()));
+        }
+      } },
+    { "fills_buffered", [&](BenchEvent const& ev, size_t){
+        sn::FillBuffer fills(true);
+        for(auto const& roi : ev.rois){
+          fills.Fill(hRise, roi[roi.begin_index() + 7] - roi[roi.begin_index()]);
+          fills.Fill(hLength, roi.size());
+          fills.Fill(hMax, roi.channel, *std::max_element(roi.begin(), roi.end()));
+        }
+        fills.Flush();
+      } },
+    { "store_from_floats", [&](BenchEvent const& ev, size_t){
+        decoded.clear();
+        for(size_t w=0; w<ev.store.NWires(); w++){
+          decoded.AddWire(ev.store.Channel(w));
+          for(size_t r=ev.store.FirstROI(w); r<ev.store.EndROI(w); r++)
+            decoded.AddROI(ev.rois[r].firstTick, ev.rois[r].samples, ev.rois[r].length);
+        }
+        gSink = gSink + decoded.NSamples();
+      } },
+    { "decode_stream", [&](BenchEvent const&, size_t e){
+        stream.GetEvent(e, decoded);
+        gSink = gSink + decoded.NSamples();
+      } },
+  };
+  if(pool)
+    benchmarks.emplace_back("decode_stream_pool", [&](BenchEvent const&, size_t e){
+        stream.GetEvent(e, decoded, pool.get());
+        gSink = gSink + decoded.NSamples();
+      });
+
+  vector<BenchResult> results;
+  for(auto const& b : benchmarks){
+    if(!only.empty() && find(only.begin(), only.end(), b.first) == only.end()) continue;
+    b.second(events[0], 0);   // warm up: caches, allocations, the bins of the histograms
+    vector<double> passes;
+    for(size_t p=0; p<repeats; p++){
+      const auto start = chrono::steady_clock::now();
+      for(size_t e=0; e<nEvents; e++) b.second(events[e], e);
+      passes.push_back(chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    sort(passes.begin(), passes.end());
+    results.push_back(BenchResult{ b.first, passes.front(), passes[passes.size()/2], nSamples, nROIs, nEvents });
+  }
+
+  // the table
+  printf("%-20s %12s %12s %14s %12s\n", "benchmark", "ns/sample", "(median)", "ROIs/s", "events/s");
+  for(auto const& r : results)
+    printf("%-20s %12.3f %12.3f %14.4g %12.2f\n", r.name.c_str(), r.best*1e9/r.samples, r.median*1e9/r.samples,
+           r.rois/r.best, r.events/r.best);
+
+  if(!json.empty()){
+    ofstream out(json);
+    out << "{\n  \"seed\": " << seed << ",\n  \"events\": " << nEvents << ",\n  \"rois\": " << nROIs
+        << ",\n  \"samples\": " << nSamples << ",\n  \"repeats\": " << repeats << ",\n  \"threads\": " << nThreads
+        << ",\n  \"compiler\": \"" << __VERSION__ << "\",\n  \"benchmarks\": [\n";
+    for(size_t i=0; i<results.size(); i++){
+      BenchResult const& r = results[i];
+      out << "    { \"name\": \"" << r.name << "\", \"best_s\": " << r.best << ", \"median_s\": " << r.median
+          << ", \"ns_per_sample\": " << r.best*1e9/r.samples << ", \"rois_per_s\": " << r.rois/r.best
+          << ", \"events_per_s\": " << r.events/r.best << " }" << (i+1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    cout << "wrote " << json << endl;
+  }
+  return 0;
+}
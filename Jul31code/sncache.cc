@@ -0,0 +1,61 @@
+//***************************
+//    converts the SN wires of art files into an ROI cache (see SNROICache.hh)
+//
+//    sncache output.sncache input.root [input2.root ...]
+//
+//    the analyses take the cache in place of the art file and skip the
+//    ROOT read and decompression of the "sndaq" and "sndeco" products
+//***************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+
+//"art" includes (canvas, and gallery)
+#include "canvas/Utilities/InputTag.h"
+#include "gallery/Event.h"
+#include "gallery/Handle.h"
+#include "gallery/ValidHandle.h"
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+#include "SNROICache.hh"
+
+//convenient for us! let's not bother with the std namespace!
+using namespace std;
+
+int main(int argc, char** argv) {
+
+  if(argc < 3){
+    cout << "usage: " << argv[0] << " output.sncache input.root [input2.root ...]" << endl;
+    return 1;
+  }
+
+  vector<string> filenames(argv+2, argv+argc);
+
+  art::InputTag wire_tag { "sndaq", "", "SupernovaAssembler" };
+  art::InputTag wire_tag_d { "sndeco", "", "CalDataSN" };
+
+  sn::SNROICacheWriter writer(argv[1]);
+
+  for (gallery::Event ev(filenames) ; !ev.atEnd(); ev.next()) {
+
+    auto const& wire_vec = *ev.getValidHandle< vector<recob::Wire> >(wire_tag);
+
+    // not every file has been through the deconvolution
+    gallery::Handle< vector<recob::Wire> > wire_handle_d;
+    const bool has_d = ev.getByLabel(wire_tag_d, wire_handle_d);
+
+    writer.AddEvent(ev.eventAuxiliary().run(), ev.eventAuxiliary().event(),
+                    wire_vec, has_d ? wire_handle_d.product() : nullptr);
+  }
+
+  writer.Close();
+
+  cout << "wrote " << writer.NEvents() << " events to " << argv[1];
+  if(writer.NBadSamples()) cout << " (" << writer.NBadSamples() << " sndaq samples were not int16 ADCs, kept as float)";
+  cout << endl;
+}
@@ -0,0 +1,102 @@
+//***************************
+//    synthetic SN events (see SNGenerator.hh) into a stream, a cache, or nowhere
+//
+//    sngen output.snstream|output.sncache|- [-n nEvents] [-s seed] [-j nThreads] [-run run]
+//          [-r roisPerChannel] [-noise rms] [-flip probability] [-denormal probability]
+//
+//    the analyses read the output like any other input: the stream leaves the
+//    swizzler errors out (0), the cache keeps them. With - the events are only made,
+//    to see how fast. The same seed gives the same events on any number of threads.
+//***************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <stdlib.h>
+
+#include "SNGenerator.hh"
+#include "SNStream.hh"
+#include "SNROICache.hh"
+
+//convenient for us! let's not bother with the std namespace!
+using namespace std;
+
+int main(int argc, char** argv) {
+
+  sn::SNGeneratorConfig config;
+  size_t nEvents = 10;
+  size_t nThreads = 1;
+  int run = 1;
+  vector<string> files;
+  for(int i=1; i<argc; i++){
+    string arg(argv[i]);
+    if(arg == "-n" && i+1 < argc) nEvents = atol(argv[++i]);
+    else if(arg == "-s" && i+1 < argc) config.seed = strtoull(argv[++i], nullptr, 10);
+    else if(arg == "-j" && i+1 < argc) nThreads = std::max(1, atoi(argv[++i]));
+    else if(arg == "-run" && i+1 < argc) run = atoi(argv[++i]);
+    else if(arg == "-r" && i+1 < argc) config.roisPerChannel = atof(argv[++i]);
+    else if(arg == "-noise" && i+1 < argc) config.noiseRMS = atof(argv[++i]);
+    else if(arg == "-flip" && i+1 < argc) config.flipProbability = atof(argv[++i]);
+    else if(arg == "-denormal" && i+1 < argc) config.denormalProbability = atof(argv[++i]);
+    else files.push_back(arg);
+  }
+  if(files.size() != 1){
+    cout << "usage: " << argv[0] << " output.snstream|output.sncache|- [-n nEvents] [-s seed] [-j nThreads] [-run run]" << endl
+         << "         [-r roisPerChannel] [-noise rms] [-flip probability] [-denormal probability]" << endl;
+    return 1;
+  }
+
+  const string& output = files[0];
+  const bool toCache = output.size() > 8 && output.compare(output.size()-8, 8, ".sncache") == 0;
+  unique_ptr<sn::SNStreamWriter> stream;
+  unique_ptr<sn::SNROICacheWriter> cache;
+  if(toCache) cache.reset(new sn::SNROICacheWriter(output));
+  else if(output != "-") stream.reset(new sn::SNStreamWriter(output, config.nTicks/2, 2));
+
+  const sn::SNGenerator generator(config);
+  vector<sn::RawROIStore> stores(nThreads);
+  vector<sn::SNTruth> truths(nThreads);
+  vector<recob::Wire> wires;
+  sn::SNTruth total;
+  double generating = 0;
+
+  // nThreads events at a time, written in order
+  for(size_t first=0; first<nEvents; first+=nThreads){
+    const size_t n = std::min(nThreads, nEvents - first);
+    const auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for(size_t t=1; t<n; t++)
+      threads.emplace_back([&, t](){ generator.Generate(first+t, stores[t], &truths[t]); });
+    generator.Generate(first, stores[0], &truths[0]);
+    for(auto& t : threads) t.join();
+    generating += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    for(size_t t=0; t<n; t++){
+      if(stream) stream->AddEvent(run, first+t, stores[t]);
+      if(cache){
+        stores[t].GetWires(wires, config.nTicks);
+        cache->AddEvent(run, first+t, wires, nullptr);
+      }
+      total.nROIs += truths[t].nROIs;
+      total.nSamples += truths[t].nSamples;
+      total.nSplit += truths[t].nSplit;
+      total.nDenormals += truths[t].nDenormals;
+      total.flips.insert(total.flips.end(), truths[t].flips.begin(), truths[t].flips.end());
+    }
+  }
+  if(stream) stream->Close();
+  if(cache) cache->Close();
+
+  cout << "made " << nEvents << " events (seed " << config.seed << "): " << total.nROIs << " ROIs ("
+       << total.nSplit << " cut at a frame boundary), " << total.nSamples << " samples, "
+       << total.flips.size() << " flipped bits, " << total.nDenormals << " swizzler errors" << endl;
+  if(generating > 0)
+    cout << "in " << generating << " s on " << nThreads << " threads: "
+         << total.nSamples*sizeof(float)/generating/1e9 << " GB/s of float samples" << endl;
+  if(output != "-") cout << "wrote " << output << endl;
+}
@@ -0,0 +1,112 @@
+//***************************
+//    writes the "sndaq" wires of art files (or of an ROI cache) as a binary SN stream (see SNStream.hh)
+//
+//    snstream [-check] output.snstream input.root [input2.root ...]
+//    snstream [-check] output.snstream input.sncache
+//
+//    the analyses take the stream in place of the art file and decode it
+//    themselves; it has no deconvolved wires, so flippingbit can't run on it.
+//    -check reads the inputs again once the stream is written and compares every
+//    event decoded from the stream with them, ROI by ROI (sn::CheckStreamEvent)
+//***************************
+
+
+//some standard C++ includes
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+
+//"art" includes (canvas, and gallery)
+#include "canvas/Utilities/InputTag.h"
+#include "gallery/Event.h"
+#include "gallery/ValidHandle.h"
+
+//"larsoft" object includes
+#include "lardataobj/RecoBase/Wire.h"
+
+#include "SNROICache.hh"
+#include "SNStream.hh"
+#include "ROIView.h"
+
+//convenient for us! let's not bother with the std namespace!
+using namespace std;
+
+// every event of the inputs in order: the cache, or the sndaq wires of the art files
+void ForEachEvent(vector<string> const& filenames, function<void(int, int, vector<recob::Wire> const&)> const& f){
+  if(filenames.size() == 1 && sn::SNROICache::IsCache(filenames[0])){
+    sn::SNROICache cache(filenames[0]);
+    vector<recob::Wire> wires;
+    for(size_t entry=0; entry<cache.NEvents(); entry++){
+      cache.GetWires(entry, sn::SNROICache::kRaw, wires);
+      f(cache.Run(entry), cache.Event(entry), wires);
+    }
+  }
+  else{
+    art::InputTag wire_tag { "sndaq", "", "SupernovaAssembler" };
+    for (gallery::Event ev(filenames) ; !ev.atEnd(); ev.next()) {
+      auto const& wire_vec = *ev.getValidHandle< vector<recob::Wire> >(wire_tag);
+      f(ev.eventAuxiliary().run(), ev.eventAuxiliary().event(), wire_vec);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+
+  vector<string> args(argv+1, argv+argc);
+  const bool check = !args.empty() && args[0] == "-check";
+  if(check) args.erase(args.begin());
+  if(args.size() < 2){
+    cout << "usage: " << argv[0] << " [-check] output.snstream input.root [input2.root ...]" << endl;
+    return 1;
+  }
+
+  const string output = args[0];
+  vector<string> filenames(args.begin()+1, args.end());
+
+  sn::SNStreamWriter writer(output);
+  size_t samples = 0;
+  ForEachEvent(filenames, [&](int run, int event, vector<recob::Wire> const& wires){
+      writer.AddEvent(run, event, wires);
+      for(auto const& wire : wires)
+        for(auto const& roi : sn::ROIs(wire)) samples += roi.length;
+    });
+
+  writer.Close();
+
+  cout << "wrote " << writer.NEvents() << " events to " << output << ", "
+       << writer.Bytes() << " bytes for " << samples << " samples";
+  if(samples) cout << " (" << double(writer.Bytes())/samples << " bytes per sample)";
+  if(writer.NBadSamples()) cout << ", " << writer.NBadSamples() << " samples were not ADC counts and are 0 now";
+  cout << endl;
+  if(!check) return 0;
+
+  // the same events again, against what the stream gives back
+  sn::SNStream stream(output);
+  sn::SNStreamCheck result;
+  sn::RawROIStore written, decoded;
+  size_t entry = 0;
+  ForEachEvent(filenames, [&](int run, int event, vector<recob::Wire> const& wires){
+      if(entry >= stream.NEvents()){
+        cout << "run " << run << " event " << event << " is not in the stream" << endl;
+        result.nMismatches++;
+        return;
+      }
+      if(stream.Run(entry) != run || stream.Event(entry) != event){
+        cout << "entry " << entry << ": run " << run << " event " << event << " written, run "
+             << stream.Run(entry) << " event " << stream.Event(entry) << " read" << endl;
+        result.nMismatches++;
+      }
+      written.Fill(wires);
+      stream.GetEvent(entry++, decoded);
+      if(!sn::CheckStreamEvent(written, decoded, stream.TicksPerFrame(), result, cout))
+        cout << "run " << run << " event " << event << " did not come back as it was written" << endl;
+    });
+
+  cout << "checked " << result.nEvents << " events, " << result.nROIs << " ROIs, " << result.nSamples << " samples: "
+       << result.nCrossing << " ROIs across a frame boundary, " << result.nWide << " samples in the 3 byte form, "
+       << result.nMismatches << " differences" << endl;
+  if(result.nCrossing == 0) cout << "(no ROI crossed a frame boundary, the joining was not checked)" << endl;
+  if(result.nWide == 0) cout << "(no sample needed the 3 byte form, it was not checked)" << endl;
+  return result.nMismatches ? 1 : 0;
+}
@@ -37,6 +37,8 @@
 //"larsoft" object includes                                                                                                  
 #include "lardataobj/RecoBase/Wire.h"
 
+#include "SNOptions.h"
+
 //convenient for us! let's not bother with art and std namespaces!                                                           
 using namespace art;
 using namespace std;
@@ -50,7 +52,7 @@ int main(int argc, char** argv) {
 
   //We specify our files in a list of file names!                                                                            
   //Note: multiple files allowed. Just separate by comma.                                                                    
-  vector<string> filenames { argv[1] };
+  vector<string> filenames = sn::ParseOptions(argc, argv).filenames;   // lists, globs and @list.txt too
 
   //Check the contents of your file by setting up a version of uboonecode, and                                               
   //running an event dump:                                                                                                   